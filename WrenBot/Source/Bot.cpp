@@ -0,0 +1,377 @@
+#include "stdafx.h"
+#include "Bot.h"
+#include <Utility.h>
+#include <Networking/Direction.h>
+#include "EventHandling/Events/LoginSuccessEvent.h"
+#include "EventHandling/Events/CreateCharacterSuccessEvent.h"
+#include "EventHandling/Events/EnterWorldSuccessEvent.h"
+#include "EventHandling/Events/NpcUpdateEvent.h"
+#include "EventHandling/Events/NpcDeathEvent.h"
+#include "EventHandling/Events/ActivateAbilitySuccessEvent.h"
+#include "Events/PlayerCorrectionEvent.h"
+#include "Events/PongEvent.h"
+
+Bot::Bot(BotStats& stats, const BotRole role, const std::string& accountName, const std::string& password, const unsigned int seed, const char* serverIpAddress, const int serverPort)
+	: socketManager{ eventHandler, serverIpAddress, serverPort },
+	  stats{ stats },
+	  role{ role },
+	  accountName{ accountName },
+	  password{ password },
+	  rng{ seed }
+{
+}
+
+// Puts this bot behind a simulated bad link, seeded from the bot's own seed.
+void Bot::SimulateNetwork(const NetworkConditions& conditions)
+{
+	socketManager.EnableNetworkSimulator(rng()).SetConditions(conditions);
+}
+
+void Bot::Start(const double now)
+{
+	this->now = now;
+	startTime = now;
+	SetState(BotState::CreatingAccount);
+}
+
+void Bot::Update(const double now)
+{
+	const auto deltaTime = now - this->now;
+	this->now = now;
+
+	socketManager.ProcessPackets();
+	PublishEvents();
+
+	if (state != BotState::InWorld && state != BotState::Failed && now - requestTime > BOT_REQUEST_TIMEOUT)
+	{
+		stats.timeouts++;
+		SendRequest();
+	}
+
+	if (state == BotState::InWorld)
+	{
+		updateTimer += deltaTime;
+		while (updateTimer >= UPDATE_FREQUENCY)
+		{
+			Tick();
+			updateTimer -= UPDATE_FREQUENCY;
+		}
+
+		secondTimer += deltaTime;
+		if (secondTimer >= 1.0)
+		{
+			EverySecond();
+			secondTimer -= 1.0;
+		}
+	}
+
+	socketManager.FlushPackets();
+}
+
+void Bot::Stop()
+{
+	if (socketManager.Connected())
+	{
+		socketManager.SendPacket(OpCode::Disconnect);
+		socketManager.Logout();
+	}
+
+	socketManager.FlushPackets();
+	socketManager.CloseSockets();
+}
+
+const BotState Bot::GetState() const { return state; }
+
+// Bots are their own only observer, so there's no need to go through the EventHandler's observer list.
+void Bot::PublishEvents()
+{
+	std::queue<std::unique_ptr<const Event>>& eventQueue = eventHandler.GetEventQueue();
+	while (!eventQueue.empty())
+	{
+		auto event = std::move(eventQueue.front());
+		eventQueue.pop();
+
+		HandleEvent(event.get());
+	}
+}
+
+void Bot::SetState(const BotState state)
+{
+	this->state = state;
+	SendRequest();
+}
+
+// Sends the request that moves the bot out of its current state. Creating an account that
+// already exists fails harmlessly, which lets the same accounts be reused across runs.
+void Bot::SendRequest()
+{
+	requestTime = now;
+
+	switch (state)
+	{
+		case BotState::CreatingAccount:
+		{
+			std::vector<std::string> args{ accountName, password };
+			socketManager.SendPacket(OpCode::CreateAccount, args);
+			break;
+		}
+		case BotState::LoggingIn:
+		{
+			std::vector<std::string> args{ accountName, password };
+			socketManager.SendPacket(OpCode::Connect, args);
+			break;
+		}
+		case BotState::CreatingCharacter:
+		{
+			std::vector<std::string> args{ accountName };
+			socketManager.SendPacket(OpCode::CreateCharacter, args);
+			break;
+		}
+		case BotState::EnteringWorld:
+		{
+			std::vector<std::string> args{ characterName };
+			socketManager.SendPacket(OpCode::EnterWorld, args);
+			break;
+		}
+		default:
+			break;
+	}
+}
+
+// One fixed update tick, at the same rate the client samples input.
+void Bot::Tick()
+{
+	switch (role)
+	{
+		case BotRole::Walker:
+			Walk();
+			break;
+		case BotRole::Fighter:
+			Fight();
+			break;
+		case BotRole::Chatter:
+			Walk();
+			Chat();
+			break;
+		default:
+			break;
+	}
+
+	inputs.push_back(PlayerInput{ ++inputSequence, direction });
+	if (inputs.size() > MAX_REDUNDANT_INPUTS)
+		inputs.pop_front();
+
+	socketManager.SendPlayerInputs(inputs);
+}
+
+void Bot::EverySecond()
+{
+	socketManager.SendPacket(OpCode::Heartbeat);
+
+	if (!pingPending)
+	{
+		socketManager.SendPing(pingId);
+		pingPending = true;
+	}
+}
+
+void Bot::Walk()
+{
+	if (now < nextDirectionChange)
+		return;
+
+	direction = Direction::FromIndex(std::uniform_int_distribution<int>{ 0, DIRECTION_COUNT - 1 }(rng));
+	nextDirectionChange = now + RandomBetween(BOT_MIN_WALK_TIME, BOT_MAX_WALK_TIME);
+}
+
+void Bot::Fight()
+{
+	const auto target = npcs.find(targetId);
+	if (target == npcs.end() || !target->second.alive)
+	{
+		targetId = FindNearestNpc();
+		direction = VEC_ZERO;
+		if (targetId == -1)
+			return;
+
+		std::vector<std::string> args{ std::to_string(targetId) };
+		socketManager.SendPacket(OpCode::SetTarget, args);
+		return;
+	}
+
+	const auto& targetPosition = target->second.position;
+	if (!Utility::AreOnAdjacentOrDiagonalTiles(position, targetPosition))
+	{
+		const auto dx = targetPosition.x - position.x;
+		const auto dz = targetPosition.z - position.z;
+		direction = XMFLOAT3{ dx > TILE_SIZE / 2 ? 1.0f : dx < -TILE_SIZE / 2 ? -1.0f : 0.0f, 0.0f, dz > TILE_SIZE / 2 ? 1.0f : dz < -TILE_SIZE / 2 ? -1.0f : 0.0f };
+		return;
+	}
+
+	direction = VEC_ZERO;
+	if (!autoAttackOn && !autoAttackPending)
+	{
+		std::vector<std::string> args{ std::to_string(AUTO_ATTACK_ABILITY_ID) };
+		socketManager.SendPacket(OpCode::ActivateAbility, args);
+		autoAttackPending = true;
+	}
+}
+
+void Bot::Chat()
+{
+	if (now < nextChatMessage)
+		return;
+
+	// same argument order as Game's SendChatMessage handler
+	std::vector<std::string> args{ characterName, "Load test message " + std::to_string(++chatMessageCount) };
+	socketManager.SendPacket(OpCode::SendChatMessage, args);
+	stats.chatMessagesSent++;
+
+	nextChatMessage = now + RandomBetween(BOT_MIN_CHAT_INTERVAL, BOT_MAX_CHAT_INTERVAL);
+}
+
+const int Bot::FindNearestNpc() const
+{
+	auto nearestId = -1;
+	auto nearestDistance = 0.0f;
+	for (auto it = npcs.begin(); it != npcs.end(); it++)
+	{
+		if (!it->second.alive)
+			continue;
+
+		const auto dx = it->second.position.x - position.x;
+		const auto dz = it->second.position.z - position.z;
+		const auto distance = dx * dx + dz * dz;
+		if (nearestId == -1 || distance < nearestDistance)
+		{
+			nearestId = it->first;
+			nearestDistance = distance;
+		}
+	}
+
+	return nearestId;
+}
+
+const double Bot::RandomBetween(const double min, const double max)
+{
+	return std::uniform_real_distribution<double>{ min, max }(rng);
+}
+
+const bool Bot::HandleEvent(const Event* const event)
+{
+	const auto type = event->type;
+	switch (type)
+	{
+		case EventType::CreateAccountSuccess:
+		case EventType::CreateAccountFailed:
+		{
+			if (state == BotState::CreatingAccount)
+				SetState(BotState::LoggingIn);
+			break;
+		}
+		case EventType::LoginFailed:
+		{
+			stats.loginFailures++;
+			state = BotState::Failed;
+			break;
+		}
+		case EventType::LoginSuccess:
+		{
+			const auto derivedEvent = (LoginSuccessEvent*)event;
+
+			if (derivedEvent->characterList.empty())
+				SetState(BotState::CreatingCharacter);
+			else
+			{
+				characterName = *derivedEvent->characterList[0];
+				SetState(BotState::EnteringWorld);
+			}
+			break;
+		}
+		case EventType::CreateCharacterFailed:
+		{
+			stats.characterFailures++;
+			state = BotState::Failed;
+			break;
+		}
+		case EventType::CreateCharacterSuccess:
+		{
+			characterName = accountName;
+			SetState(BotState::EnteringWorld);
+			break;
+		}
+		case EventType::EnterWorldSuccess:
+		{
+			const auto derivedEvent = (EnterWorldSuccessEvent*)event;
+
+			position = derivedEvent->position;
+			state = BotState::InWorld;
+			stats.AddLoginTime(now - startTime);
+			break;
+		}
+		case EventType::PlayerCorrection:
+		{
+			const auto derivedEvent = (PlayerCorrectionEvent*)event;
+
+			position = derivedEvent->position;
+			if (lastCorrectionTime >= 0.0)
+				stats.AddUpdateInterval(now - lastCorrectionTime);
+			lastCorrectionTime = now;
+			break;
+		}
+		case EventType::NpcUpdate:
+		{
+			const auto derivedEvent = (NpcUpdateEvent*)event;
+
+			npcs[derivedEvent->gameObjectId] = BotNpc{ derivedEvent->pos, derivedEvent->health > 0 };
+			break;
+		}
+		case EventType::NpcDeath:
+		{
+			const auto derivedEvent = (NpcDeathEvent*)event;
+
+			npcs[derivedEvent->gameObjectId].alive = false;
+			if (derivedEvent->gameObjectId != targetId)
+				break;
+
+			stats.kills++;
+			for (auto i = 0; i < derivedEvent->itemIds.size(); i++)
+			{
+				std::vector<std::string> args{ std::to_string(targetId), std::to_string(i) };
+				socketManager.SendPacket(OpCode::LootItem, args);
+			}
+			break;
+		}
+		case EventType::ActivateAbilitySuccess:
+		{
+			const auto derivedEvent = (ActivateAbilitySuccessEvent*)event;
+
+			// sent whenever auto attack is toggled, including by the server when the target dies
+			if (derivedEvent->abilityId == AUTO_ATTACK_ABILITY_ID)
+			{
+				autoAttackOn = !autoAttackOn;
+				autoAttackPending = false;
+			}
+			break;
+		}
+		case EventType::ServerMessage:
+		{
+			// errors like an invalid or dead target don't toggle auto attack, so try again next tick
+			autoAttackPending = false;
+			break;
+		}
+		case EventType::Pong:
+		{
+			const auto derivedEvent = (PongEvent*)event;
+
+			stats.AddRtt(derivedEvent->rtt);
+			pingPending = false;
+			pingId++;
+			break;
+		}
+		default:
+			break;
+	}
+
+	return false;
+}
\ No newline at end of file
@@ -0,0 +1,93 @@
+#pragma once
+
+#include <EventHandling/EventHandler.h>
+#include <EventHandling/Observer.h>
+#include <ClientSocketManager.h>
+#include "BotStats.h"
+
+constexpr auto BOT_REQUEST_TIMEOUT = 10.0; // seconds before a login step is sent again
+constexpr auto BOT_MIN_WALK_TIME = 1.0;    // seconds a walking bot keeps a direction
+constexpr auto BOT_MAX_WALK_TIME = 4.0;
+constexpr auto BOT_MIN_CHAT_INTERVAL = 5.0;
+constexpr auto BOT_MAX_CHAT_INTERVAL = 15.0;
+constexpr auto AUTO_ATTACK_ABILITY_ID = 1;
+
+enum class BotRole
+{
+	Idle,    // stands still, but still sends inputs, heartbeats and pings like an idle player
+	Walker,  // walks in random directions
+	Fighter, // walks to the nearest living npc, auto-attacks it and loots it
+	Chatter  // walks in random directions and chats
+};
+
+enum class BotState
+{
+	CreatingAccount,
+	LoggingIn,
+	CreatingCharacter,
+	EnteringWorld,
+	InWorld,
+	Failed
+};
+
+struct BotNpc
+{
+	XMFLOAT3 position;
+	bool alive;
+};
+
+// One simulated player. Every bot has its own socket, since the server tells players apart by
+// endpoint, and its own ClientSocketManager and event queue. It drives them the way Game does
+// from user input: log in, create a character if there is none, enter the world, then play its role.
+class Bot : public Observer
+{
+	EventHandler eventHandler;
+	ClientSocketManager socketManager;
+	BotStats& stats;
+	const BotRole role;
+	const std::string accountName;
+	const std::string password;
+	std::mt19937 rng;
+	BotState state{ BotState::CreatingAccount };
+	std::string characterName;
+	double now{ 0.0 };
+	double startTime{ 0.0 };
+	double requestTime{ 0.0 };
+	double updateTimer{ 0.0 };
+	double secondTimer{ 0.0 };
+	double lastCorrectionTime{ -1.0 };
+
+	// in world
+	XMFLOAT3 position{ VEC_ZERO };
+	XMFLOAT3 direction{ VEC_ZERO };
+	unsigned int inputSequence{ 0 };
+	std::deque<PlayerInput> inputs;
+	unsigned int pingId{ 0 };
+	bool pingPending{ false };
+	double nextDirectionChange{ 0.0 };
+	double nextChatMessage{ 0.0 };
+	int chatMessageCount{ 0 };
+	std::map<int, BotNpc> npcs;
+	int targetId{ -1 };
+	bool autoAttackOn{ false };
+	bool autoAttackPending{ false };
+
+	void PublishEvents();
+	void SetState(const BotState state);
+	void SendRequest();
+	void Tick();
+	void EverySecond();
+	void Walk();
+	void Fight();
+	void Chat();
+	const int FindNearestNpc() const;
+	const double RandomBetween(const double min, const double max);
+public:
+	Bot(BotStats& stats, const BotRole role, const std::string& accountName, const std::string& password, const unsigned int seed, const char* serverIpAddress, const int serverPort);
+	void Start(const double now);
+	void SimulateNetwork(const NetworkConditions& conditions);
+	void Update(const double now);
+	void Stop();
+	const BotState GetState() const;
+	virtual const bool HandleEvent(const Event* const event) override;
+};
\ No newline at end of file
@@ -0,0 +1,56 @@
+#include "stdafx.h"
+#include "BotStats.h"
+
+void BotStats::AddRtt(const double rtt) { rttSamples.push_back(rtt); }
+void BotStats::AddUpdateInterval(const double interval) { updateIntervalSamples.push_back(interval); }
+void BotStats::AddLoginTime(const double loginTime) { loginTimeSamples.push_back(loginTime); }
+
+const double BotStats::Percentile(std::vector<double>& samples, const double percentile)
+{
+	const auto index = static_cast<size_t>(percentile * (samples.size() - 1));
+	std::nth_element(samples.begin(), samples.begin() + index, samples.end());
+	return samples[index];
+}
+
+void BotStats::PrintPercentiles(std::ostream& out, const char* name, std::vector<double>& samples)
+{
+	out << "  " << name << ": ";
+	if (samples.empty())
+	{
+		out << "no samples\n";
+		return;
+	}
+
+	out << "p50 " << Percentile(samples, 0.5) * 1000.0 << "ms, "
+		<< "p90 " << Percentile(samples, 0.9) * 1000.0 << "ms, "
+		<< "p99 " << Percentile(samples, 0.99) * 1000.0 << "ms, "
+		<< "max " << Percentile(samples, 1.0) * 1000.0 << "ms (" << samples.size() << " samples)\n";
+}
+
+// The update rate is the number of PlayerCorrections each in-world bot got per second; the server
+// sends one per replication tick, so anything below 60/s means ticks are running late or datagrams are lost.
+void BotStats::Report(std::ostream& out, const double interval, const int botsStarted, const int botsInWorld)
+{
+	const auto updateRate = botsInWorld == 0 ? 0.0 : updateIntervalSamples.size() / interval / botsInWorld;
+
+	out << std::fixed << std::setprecision(1)
+		<< "WrenBot: " << botsInWorld << "/" << botsStarted << " bots in world, "
+		<< updateRate << " updates/s/bot, "
+		<< chatMessagesSent << " chat messages, " << kills << " kills, "
+		<< loginFailures << " login failures, " << characterFailures << " character failures, " << timeouts << " timeouts\n";
+	PrintPercentiles(out, "rtt", rttSamples);
+	PrintPercentiles(out, "update interval", updateIntervalSamples);
+	PrintPercentiles(out, "login time", loginTimeSamples);
+}
+
+void BotStats::Reset()
+{
+	rttSamples.clear();
+	updateIntervalSamples.clear();
+	loginTimeSamples.clear();
+	loginFailures = 0;
+	characterFailures = 0;
+	timeouts = 0;
+	chatMessagesSent = 0;
+	kills = 0;
+}
\ No newline at end of file
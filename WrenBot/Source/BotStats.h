@@ -0,0 +1,24 @@
+#pragma once
+
+// Samples and counters shared by every bot. main reports and resets them every report interval.
+class BotStats
+{
+	std::vector<double> rttSamples;            // seconds
+	std::vector<double> updateIntervalSamples; // seconds between PlayerCorrections
+	std::vector<double> loginTimeSamples;      // seconds from CreateAccount to EnterWorldSuccess
+
+	static const double Percentile(std::vector<double>& samples, const double percentile);
+	static void PrintPercentiles(std::ostream& out, const char* name, std::vector<double>& samples);
+public:
+	int loginFailures{ 0 };
+	int characterFailures{ 0 };
+	int timeouts{ 0 };
+	int chatMessagesSent{ 0 };
+	int kills{ 0 };
+
+	void AddRtt(const double rtt);
+	void AddUpdateInterval(const double interval);
+	void AddLoginTime(const double loginTime);
+	void Report(std::ostream& out, const double interval, const int botsStarted, const int botsInWorld);
+	void Reset();
+};
\ No newline at end of file
@@ -0,0 +1,161 @@
+#include "stdafx.h"
+#include <GameTimer.h>
+#include "Bot.h"
+
+// Headless load generator: logs in a ramp of simulated players and reports server RTT and update
+// rate percentiles. Every option has a default, e.g.
+//   WrenBot.exe --bots 2000 --rate 50 --mix walker:50,fighter:30,chatter:15,idle:5 --duration 600
+// --netsim puts every bot behind a simulated link, e.g. --netsim latency=80,jitter=20,loss=2
+struct BotOptions
+{
+	int bots{ 100 };
+	double loginsPerSecond{ 20.0 };  // logins hash a password on the server, so they're ramped up
+	double duration{ 0.0 };          // seconds, 0 runs until the process is killed
+	double reportInterval{ 10.0 };   // seconds
+	std::string server{ SERVER_IP_ADDRESS };
+	int port{ SERVER_PORT_NUMBER };
+	std::string prefix{ "bot" };
+	std::string password{ "password" };
+	unsigned int seed{ 1 };
+	double mix[4]{ 10.0, 40.0, 40.0, 10.0 }; // weights for Idle, Walker, Fighter, Chatter
+	bool simulateNetwork{ false };
+	NetworkConditions networkConditions;
+};
+
+void SetMix(BotOptions& options, const std::string& mix)
+{
+	static const std::string roleNames[4]{ "idle", "walker", "fighter", "chatter" };
+
+	for (auto i = 0; i < 4; i++)
+		options.mix[i] = 0.0;
+
+	size_t start = 0;
+	while (start < mix.length())
+	{
+		auto end = mix.find(',', start);
+		if (end == std::string::npos)
+			end = mix.length();
+
+		const auto entry = mix.substr(start, end - start);
+		const auto separator = entry.find(':');
+		if (separator == std::string::npos)
+			throw std::exception("Expected --mix role:weight,role:weight,...");
+
+		const auto roleName = entry.substr(0, separator);
+		const auto roleIt = std::find(std::begin(roleNames), std::end(roleNames), roleName);
+		if (roleIt == std::end(roleNames))
+			throw std::exception("Unknown bot role in --mix.");
+
+		options.mix[roleIt - std::begin(roleNames)] = std::stod(entry.substr(separator + 1));
+		start = end + 1;
+	}
+}
+
+BotOptions ParseOptions(const int argc, char* argv[])
+{
+	BotOptions options;
+	for (auto i = 1; i + 1 < argc; i += 2)
+	{
+		const std::string option{ argv[i] };
+		const std::string value{ argv[i + 1] };
+
+		if (option == "--bots")
+			options.bots = std::stoi(value);
+		else if (option == "--rate")
+			options.loginsPerSecond = std::stod(value);
+		else if (option == "--duration")
+			options.duration = std::stod(value);
+		else if (option == "--report")
+			options.reportInterval = std::stod(value);
+		else if (option == "--server")
+			options.server = value;
+		else if (option == "--port")
+			options.port = std::stoi(value);
+		else if (option == "--prefix")
+			options.prefix = value;
+		else if (option == "--password")
+			options.password = value;
+		else if (option == "--seed")
+			options.seed = std::stoul(value);
+		else if (option == "--mix")
+			SetMix(options, value);
+		else if (option == "--netsim")
+		{
+			options.simulateNetwork = true;
+			options.networkConditions = ParseNetworkConditions(value);
+		}
+		else
+			throw std::exception("Unknown option.");
+	}
+	return options;
+}
+
+int main(int argc, char* argv[])
+{
+	BotOptions options;
+	try
+	{
+		options = ParseOptions(argc, argv);
+	}
+	catch (const std::exception& e)
+	{
+		std::cout << e.what() << "\n";
+		return 1;
+	}
+
+	BotStats stats;
+	std::mt19937 rng{ options.seed };
+	std::discrete_distribution<int> roles{ std::begin(options.mix), std::end(options.mix) };
+
+	std::vector<std::unique_ptr<Bot>> bots;
+	for (auto i = 0; i < options.bots; i++)
+	{
+		const auto role = static_cast<BotRole>(roles(rng));
+		bots.push_back(std::make_unique<Bot>(stats, role, options.prefix + std::to_string(i), options.password, rng(), options.server.c_str(), options.port));
+		if (options.simulateNetwork)
+			bots.back()->SimulateNetwork(options.networkConditions);
+	}
+
+	std::cout << "WrenBot initialized with " << options.bots << " bots.\n\n";
+
+	GameTimer timer;
+	timer.Reset();
+	auto botsStarted = 0;
+	auto lastReport = 0.0;
+
+	while (true)
+	{
+		timer.Tick();
+		const double now = timer.TotalTime();
+		if (options.duration > 0.0 && now >= options.duration)
+			break;
+
+		while (botsStarted < bots.size() && botsStarted < now * options.loginsPerSecond)
+			bots[botsStarted++]->Start(now);
+
+		for (auto i = 0; i < botsStarted; i++)
+			bots[i]->Update(now);
+
+		if (now - lastReport >= options.reportInterval)
+		{
+			auto botsInWorld = 0;
+			for (auto i = 0; i < botsStarted; i++)
+			{
+				if (bots[i]->GetState() == BotState::InWorld)
+					botsInWorld++;
+			}
+
+			stats.Report(std::cout, now - lastReport, botsStarted, botsInWorld);
+			stats.Reset();
+			lastReport = now;
+		}
+
+		// every bot is polled each pass, so there's nothing to block on; just don't spin a core
+		Sleep(1);
+	}
+
+	for (auto i = 0; i < botsStarted; i++)
+		bots[i]->Stop();
+
+	return 0;
+}
\ No newline at end of file
@@ -1,10 +1,11 @@
 #include "stdafx.h"
 #include "ClientSocketManager.h"
-#include "Game.h"
 #include "Events/AttackHitEvent.h"
 #include "Events/AttackMissEvent.h"
 #include "Events/SkillIncreaseEvent.h"
 #include "Events/MoveItemSuccessEvent.h"
+#include "Events/PlayerCorrectionEvent.h"
+#include "Events/PongEvent.h"
 #include "EventHandling/Events/CreateAccountFailedEvent.h"
 #include "EventHandling/Events/LoginSuccessEvent.h"
 #include "EventHandling/Events/LoginFailedEvent.h"
@@ -19,15 +20,17 @@
 #include "EventHandling/Events/ActivateAbilitySuccessEvent.h"
 #include "EventHandling/Events/NpcDeathEvent.h"
 #include "EventHandling/Events/LootItemSuccessEvent.h"
+#include <Networking/EntityState.h>
 
-ClientSocketManager::ClientSocketManager(EventHandler& eventHandler)
+ClientSocketManager::ClientSocketManager(EventHandler& eventHandler, const char* serverIpAddress, const int serverPort)
 	: SocketManager{ eventHandler }
 {
 	InitializeMessageHandlers();
 
-    from.sin_family = AF_INET;
-	inet_pton(AF_INET, SERVER_IP_ADDRESS, &from.sin_addr);
-    from.sin_port = htons(SERVER_PORT_NUMBER);
+	ZeroMemory(&server, sizeof(server));
+    server.sin_family = AF_INET;
+	inet_pton(AF_INET, serverIpAddress, &server.sin_addr);
+    server.sin_port = htons(serverPort);
 }
 
 void ClientSocketManager::SendPacket(const OpCode opCode)
@@ -41,7 +44,69 @@ void ClientSocketManager::SendPacket(const OpCode opCode, std::vector<std::strin
 	if (Connected())
 		args.insert(args.begin(), { std::to_string(accountId), token });
 
-	SocketManager::SendPacket(from, opCode, args);
+	SocketManager::SendPacket(server, opCode, args);
+}
+
+// Sends the newest inputs (up to MAX_REDUNDANT_INPUTS), so each one goes out several times
+// and a lost datagram is covered by the next. Sequences are consecutive, so only the first is sent.
+void ClientSocketManager::SendPlayerInputs(const std::deque<PlayerInput>& inputs)
+{
+	if (!Connected() || inputs.empty())
+		return;
+
+	const auto inputCount = Utility::Min<int>(MAX_REDUNDANT_INPUTS, static_cast<int>(inputs.size()));
+	const auto firstIndex = inputs.size() - inputCount;
+
+	inputWriter.Reset();
+	inputWriter.WriteBits(accountId, 32);
+	inputWriter.WriteString(token);
+	inputWriter.WriteRangedInt(inputCount, 1, MAX_REDUNDANT_INPUTS);
+	inputWriter.WriteBits(inputs[firstIndex].sequence, 32);
+	for (auto i = firstIndex; i < inputs.size(); i++)
+		inputWriter.WriteDirection(inputs[i].direction);
+	inputWriter.Flush();
+
+	Packet& packet = packetPool.Acquire();
+	packet.Begin(OpCode::PlayerInput).Write(inputWriter);
+	SocketManager::SendPacket(server, packet);
+	packet.Release();
+}
+
+// The round trip is timed here rather than by whoever handles the PongEvent, since events are only
+// published on the next update tick. The send time travels with the Ping and comes back in the Pong,
+// and the latest RTT and jitter go along for the server's per-session stats.
+void ClientSocketManager::SendPing(const unsigned int pingId)
+{
+	std::vector<std::string> args
+	{
+		std::to_string(pingId),
+		std::to_string(GetTime()),
+		std::to_string(clockSync.GetRtt()),
+		std::to_string(clockSync.GetJitter())
+	};
+	SendPacket(OpCode::Ping, args);
+}
+
+// Pings the server often enough to keep the clock in step with it; call it every update.
+void ClientSocketManager::SyncClock()
+{
+	const auto now = GetTime();
+	if (!Connected() || now < nextClockSyncTime)
+		return;
+
+	SendPing(nextPingId++);
+	nextClockSyncTime = now + clockSync.GetPingInterval();
+}
+
+// Seconds since the server's first tick, as best the clock sync can tell.
+const double ClientSocketManager::GetServerTime()
+{
+	return clockSync.GetServerTime(GetTime());
+}
+
+const unsigned int ClientSocketManager::GetServerTick()
+{
+	return static_cast<unsigned int>(Utility::Max<double>(GetServerTime(), 0.0) / UPDATE_FREQUENCY);
 }
 
 const bool ClientSocketManager::Connected() const
@@ -172,6 +237,7 @@ void ClientSocketManager::Logout()
 {
 	accountId = -1;
 	token = "";
+	entitySequences.Clear();
 }
 
 void ClientSocketManager::InitializeMessageHandlers()
@@ -278,87 +344,64 @@ void ClientSocketManager::InitializeMessageHandlers()
 		eventHandler.QueueEvent(e);
 	};
 
-	messageHandlers[OpCode::NpcUpdate] = [this](const std::vector<std::string>& args)
+	binaryMessageHandlers[OpCode::NpcUpdate] = [this](BitReader& reader)
 	{
-		auto j = 0;
-		const std::string& gameObjectId = args.at(j++);
-		const std::string& posX = args.at(j++);
-		const std::string& posY = args.at(j++);
-		const std::string& posZ = args.at(j++);
-		const std::string& movX = args.at(j++);
-		const std::string& movY = args.at(j++);
-		const std::string& movZ = args.at(j++);
-		const std::string& agility = args.at(j++);
-		const std::string& strength = args.at(j++);
-		const std::string& wisdom = args.at(j++);
-		const std::string& intelligence = args.at(j++);
-		const std::string& charisma = args.at(j++);
-		const std::string& luck = args.at(j++);
-		const std::string& endurance = args.at(j++);
-		const std::string& health = args.at(j++);
-		const std::string& maxHealth = args.at(j++);
-		const std::string& mana = args.at(j++);
-		const std::string& maxMana = args.at(j++);
-		const std::string& stamina = args.at(j++);
-		const std::string& maxStamina = args.at(j++);
+		EntityState state;
+		state.Read(reader, false);
+		if (reader.Failed() || !entitySequences.Accept(OpCode::NpcUpdate, state.id, state.sequence, GetTime()))
+			return;
 
 		std::unique_ptr<Event> e = std::make_unique<NpcUpdateEvent>
 		(
-			std::stol(gameObjectId),
-			XMFLOAT3{ std::stof(posX), std::stof(posY), std::stof(posZ)}, XMFLOAT3{ std::stof(movX), std::stof(movY), std::stof(movZ)},
-			std::stoi(agility), std::stoi(strength), std::stoi(wisdom), std::stoi(intelligence), std::stoi(charisma), std::stoi(luck), std::stoi(endurance),
-			std::stoi(health), std::stoi(maxHealth), std::stoi(mana), std::stoi(maxMana), std::stoi(stamina), std::stoi(maxStamina)
+			state.id,
+			state.position, state.movementVector,
+			state.agility, state.strength, state.wisdom, state.intelligence, state.charisma, state.luck, state.endurance,
+			state.health, state.maxHealth, state.mana, state.maxMana, state.stamina, state.maxStamina
 		);
 
 		eventHandler.QueueEvent(e);
 	};
 
-	messageHandlers[OpCode::PlayerUpdate] = [this](const std::vector<std::string>& args)
+	binaryMessageHandlers[OpCode::PlayerUpdate] = [this](BitReader& reader)
 	{
-		auto j = 0;
-		const std::string& accountId = args.at(j++);
-		const std::string& posX = args.at(j++);
-		const std::string& posY = args.at(j++);
-		const std::string& posZ = args.at(j++);
-		const std::string& movX = args.at(j++);
-		const std::string& movY = args.at(j++);
-		const std::string& movZ = args.at(j++);
-		const std::string& modelId = args.at(j++);
-		const std::string& textureId = args.at(j++);
-		const std::string& name = args.at(j++);
-		const std::string& agility = args.at(j++);
-		const std::string& strength = args.at(j++);
-		const std::string& wisdom = args.at(j++);
-		const std::string& intelligence = args.at(j++);
-		const std::string& charisma = args.at(j++);
-		const std::string& luck = args.at(j++);
-		const std::string& endurance = args.at(j++);
-		const std::string& health = args.at(j++);
-		const std::string& maxHealth = args.at(j++);
-		const std::string& mana = args.at(j++);
-		const std::string& maxMana = args.at(j++);
-		const std::string& stamina = args.at(j++);
-		const std::string& maxStamina = args.at(j++);
+		EntityState state;
+		state.Read(reader, true);
+		if (reader.Failed() || !entitySequences.Accept(OpCode::PlayerUpdate, state.id, state.sequence, GetTime()))
+			return;
 
 		std::unique_ptr<Event> e = std::make_unique<PlayerUpdateEvent>
 		(
-			std::stol(accountId),
-			XMFLOAT3{ std::stof(posX), std::stof(posY), std::stof(posZ)}, XMFLOAT3{ std::stof(movX), std::stof(movY), std::stof(movZ) },
-			std::stoi(modelId), std::stoi(textureId),
-			name,
-			std::stoi(agility), std::stoi(strength), std::stoi(wisdom), std::stoi(intelligence), std::stoi(charisma), std::stoi(luck), std::stoi(endurance),
-			std::stoi(health), std::stoi(maxHealth), std::stoi(mana), std::stoi(maxMana), std::stoi(stamina), std::stoi(maxStamina)
+			state.id,
+			state.position, state.movementVector,
+			state.modelId, state.textureId,
+			state.name,
+			state.agility, state.strength, state.wisdom, state.intelligence, state.charisma, state.luck, state.endurance,
+			state.health, state.maxHealth, state.mana, state.maxMana, state.stamina, state.maxStamina
 		);
 
 		eventHandler.QueueEvent(e);
 	};
 
+	binaryMessageHandlers[OpCode::PlayerCorrection] = [this](BitReader& reader)
+	{
+		unsigned short sequence;
+		unsigned int inputSequence;
+		XMFLOAT3 position, movementVector, destination;
+		PlayerMovement::ReadCorrection(reader, sequence, inputSequence, position, movementVector, destination);
+		if (reader.Failed() || !entitySequences.Accept(OpCode::PlayerCorrection, accountId, sequence, GetTime()))
+			return;
+
+		std::unique_ptr<Event> e = std::make_unique<PlayerCorrectionEvent>(inputSequence, position, movementVector, destination);
+		eventHandler.QueueEvent(e);
+	};
+
 	messageHandlers[OpCode::PropagateChatMessage] = [this](const std::vector<std::string>& args)
 	{
 		const std::string& message = args.at(0);
 		const std::string& senderName = args.at(1);
+		const std::string& channel = args.at(2);
 
-		std::unique_ptr<Event> e = std::make_unique<PropagateChatMessageEvent>(senderName, message);
+		std::unique_ptr<Event> e = std::make_unique<PropagateChatMessageEvent>(senderName, message, channel);
 		eventHandler.QueueEvent(e);
 	};
 
@@ -401,8 +444,14 @@ void ClientSocketManager::InitializeMessageHandlers()
 	messageHandlers[OpCode::Pong] = [this](const std::vector<std::string>& args)
 	{
 		const std::string& pingId = args.at(0);
+		const auto sendTime = std::stod(args.at(1));
+		const auto serverTime = std::stod(args.at(2));
+		const auto now = GetTime();
+
+		clockSync.AddSample(sendTime, serverTime, now);
 
-		game->OnPong(std::stoul(pingId));
+		std::unique_ptr<Event> e = std::make_unique<PongEvent>(std::stoul(pingId), now - sendTime);
+		eventHandler.QueueEvent(e);
 	};
 
 	messageHandlers[OpCode::SkillIncrease] = [this](const std::vector<std::string>& args)
@@ -443,6 +492,19 @@ void ClientSocketManager::InitializeMessageHandlers()
 		std::unique_ptr<Event> e = std::make_unique<MoveItemSuccessEvent>(draggingSlot, slot);
 		eventHandler.QueueEvent(e);
 	};
-}
 
-void ClientSocketManager::SetGamePointer(Game* game) { this->game = game; }
+	// the player has walked into a zone run by another server, which already has the session
+	messageHandlers[OpCode::ZoneTransfer] = [this](const std::vector<std::string>& args)
+	{
+		const std::string& ipAddress = args.at(0);
+		const auto port = std::stoi(args.at(1));
+
+		inet_pton(AF_INET, ipAddress.c_str(), &server.sin_addr);
+		server.sin_port = htons(port);
+
+		// the new zone's ticks started at a different time, and its entities count their own updates
+		clockSync.Reset();
+		nextClockSyncTime = 0.0;
+		entitySequences.Clear();
+	};
+}
\ No newline at end of file
@@ -2,18 +2,25 @@
 
 #include <SocketManager.h>
 #include <OpCodes.h>
+#include <Constants.h>
 #include <Models/Skill.h>
 #include <Models/Ability.h>
 #include <EventHandling/EventHandler.h>
-
-class Game;
+#include <PlayerMovement.h>
+#include <Networking/ClockSync.h>
+#include <Networking/EntitySequences.h>
 
 class ClientSocketManager : public SocketManager
 {
 private:
-	Game* game;
+	sockaddr_in server; // changes when the player is handed off to another zone
 	int accountId{ -1 };
 	std::string token{ "" };
+	BitWriter inputWriter;
+	ClockSync clockSync;
+	unsigned int nextPingId{ 0 };
+	double nextClockSyncTime{ 0.0 };
+	EntitySequences entitySequences;
 
 	std::vector<std::unique_ptr<std::string>> BuildCharacterVector(const std::string& characterString) const;
 	std::vector<std::unique_ptr<WrenCommon::Skill>> BuildSkillVector(const std::string& skillString) const;
@@ -22,11 +29,15 @@ private:
 	void InitializeMessageHandlers() override;
 	
 public:
-	ClientSocketManager(EventHandler& eventHandler);
+	ClientSocketManager(EventHandler& eventHandler, const char* serverIpAddress = SERVER_IP_ADDRESS, const int serverPort = SERVER_PORT_NUMBER);
     
-	void SetGamePointer(Game* game);
 	void SendPacket(const OpCode opCode);
 	void SendPacket(const OpCode opcode, std::vector<std::string>& args);
+	void SendPlayerInputs(const std::deque<PlayerInput>& inputs);
+	void SendPing(const unsigned int pingId);
+	void SyncClock();
+	const double GetServerTime();
+	const unsigned int GetServerTick();
 	const bool Connected() const;
 	void Logout();
 };
\ No newline at end of file
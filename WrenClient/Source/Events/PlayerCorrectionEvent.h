@@ -0,0 +1,20 @@
+#pragma once
+
+#include <EventHandling/Events/Event.h>
+
+class PlayerCorrectionEvent : public Event
+{
+public:
+	PlayerCorrectionEvent(const unsigned int inputSequence, const XMFLOAT3 position, const XMFLOAT3 movementVector, const XMFLOAT3 destination)
+		: Event(EventType::PlayerCorrection),
+		  inputSequence{ inputSequence },
+		  position{ position },
+		  movementVector{ movementVector },
+		  destination{ destination }
+	{
+	}
+	const unsigned int inputSequence;
+	const XMFLOAT3 position;
+	const XMFLOAT3 movementVector;
+	const XMFLOAT3 destination;
+};
\ No newline at end of file
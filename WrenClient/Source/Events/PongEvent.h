@@ -0,0 +1,16 @@
+#pragma once
+
+#include <EventHandling/Events/Event.h>
+
+class PongEvent : public Event
+{
+public:
+	PongEvent(const unsigned int pingId, const double rtt)
+		: Event(EventType::Pong),
+		  pingId{ pingId },
+		  rtt{ rtt }
+	{
+	}
+	const unsigned int pingId;
+	const double rtt; // seconds
+};
\ No newline at end of file
@@ -4,6 +4,8 @@
 #include "Events/SkillIncreaseEvent.h"
 #include "Events/DoubleLeftMouseDownEvent.h"
 #include "Events/MoveItemSuccessEvent.h"
+#include "Events/PlayerCorrectionEvent.h"
+#include "Events/PongEvent.h"
 #include "EventHandling/Events/ChangeActiveLayerEvent.h"
 #include "EventHandling/Events/CreateAccountFailedEvent.h"
 #include "EventHandling/Events/LoginSuccessEvent.h"
@@ -841,15 +843,7 @@ void Game::Tick()
 
 	// to get an accurate ping, we should handle this outside of the main update loop which is locked at 60 updates / second
 	if (activeLayer == InGame)
-	{
-		if (pingStart == 0.0f)
-		{
-			pingStart = timer.TotalTime();
-
-			std::vector<std::string> args{ std::to_string(pingId) };
-			socketManager.SendPacket(OpCode::Ping, args);
-		}
-	}
+		socketManager.SyncClock();
 
 	// reset double click timer if necessary
 	if (timer.TotalTime() - doubleClickStart > 0.5f)
@@ -863,15 +857,69 @@ void Game::Tick()
 			camera.Update(player->GetWorldPosition(), UPDATE_FREQUENCY);
 			
 			textWindow->Update(); // this should be handled by objectManager.Update()...
+			PredictPlayerMovement();
 			objectManager.Update();
 		}
 		
 		PublishEvents();
+		snapshotInterpolator.RemoveExpired(timer.TotalTime());
 
 		updateTimer -= UPDATE_FREQUENCY;
 	}
 	
+	if (activeLayer == InGame)
+		UpdateRemotePositions();
+
 	Render(updateTimer);
+
+	socketManager.FlushPackets();
+}
+
+// Every update tick samples the held direction as one input, sends it along with the few before it,
+// and applies it to our own character right away instead of waiting a round trip for the server.
+void Game::PredictPlayerMovement()
+{
+	predictedInputs.push_back(PlayerInput{ ++inputSequence, rightMouseDownDir });
+	if (predictedInputs.size() > MAX_PREDICTED_INPUTS)
+		predictedInputs.pop_front();
+
+	socketManager.SendPlayerInputs(predictedInputs);
+
+	PlayerMovement::TryStartMove(*player, rightMouseDownDir, nullptr);
+}
+
+// Rewinds our character to the server's result for the last input it applied, then replays the
+// inputs it hasn't seen yet. When the prediction was right this lands exactly where we already were.
+void Game::ReconcilePlayerMovement(const unsigned int inputSequence, const XMFLOAT3& position, const XMFLOAT3& movementVector, const XMFLOAT3& destination)
+{
+	while (!predictedInputs.empty() && predictedInputs.front().sequence <= inputSequence)
+		predictedInputs.pop_front();
+
+	player->localPosition = position;
+	player->movementVector = movementVector;
+	player->destination = destination;
+
+	for (auto i = 0; i < predictedInputs.size(); i++)
+		PlayerMovement::Step(*player, predictedInputs[i].direction, nullptr);
+}
+
+// Remote entities are drawn where the SnapshotInterpolator puts them, every frame, rather than
+// wherever the last NpcUpdate/PlayerUpdate left them.
+void Game::UpdateRemotePositions()
+{
+	const auto now = timer.TotalTime();
+	auto* const gameObjects = objectManager.GetGameObjects();
+	const auto gameObjectLength = objectManager.GetGameObjectIndex();
+	for (auto i = 0; i < gameObjectLength; i++)
+	{
+		GameObject& gameObject = gameObjects[i];
+		if (&gameObject == player)
+			continue;
+
+		XMFLOAT3 position;
+		if (snapshotInterpolator.TryGetPosition(gameObject.GetId(), now, gameObject.GetSpeed(), position))
+			gameObject.localPosition = position;
+	}
 }
 
 void Game::Render(const float updateTimer)
@@ -1095,14 +1143,6 @@ void Game::OnDeviceRestored()
 	SetActiveLayer(activeLayer);
 }
 
-void Game::OnPong(unsigned int pingId)
-{
-	const auto delta = timer.TotalTime() - pingStart;
-	ping = static_cast<int>(std::round(delta * 1000));
-	pingStart = 0.0f;
-	this->pingId++;
-}
-
 const bool Game::HandleEvent(const Event* const event)
 {
 	const auto fun = eventHandlers[event->type];
@@ -1121,11 +1161,8 @@ void Game::CreateEventHandlers()
 
 		const auto derivedEvent = (MouseEvent*)event;
 
-		const auto dir = Utility::MousePosToDirection(g_clientWidth, g_clientHeight, derivedEvent->mousePosX, derivedEvent->mousePosY);
-		std::vector<std::string> args{ std::to_string(dir.x), std::to_string(dir.y), std::to_string(dir.z) };
-		socketManager.SendPacket(OpCode::PlayerRightMouseDown, args);
-
-		rightMouseDownDir = dir;
+		// sampled once per update tick by PredictPlayerMovement
+		rightMouseDownDir = Utility::MousePosToDirection(g_clientWidth, g_clientHeight, derivedEvent->mousePosX, derivedEvent->mousePosY);
 	};
 
 	eventHandlers[EventType::RightMouseUp] = [this](const Event* const event)
@@ -1133,8 +1170,6 @@ void Game::CreateEventHandlers()
 		if (activeLayer != Layer::InGame)
 			return;
 
-		socketManager.SendPacket(OpCode::PlayerRightMouseUp);
-
 		rightMouseDownDir = VEC_ZERO;
 	};
 
@@ -1147,13 +1182,7 @@ void Game::CreateEventHandlers()
 
 		if (activeLayer == Layer::InGame && rightMouseDownDir != VEC_ZERO)
 		{
-			const auto dir = Utility::MousePosToDirection(g_clientWidth, g_clientHeight, derivedEvent->mousePosX, derivedEvent->mousePosY);
-			if (dir != rightMouseDownDir)
-			{
-				std::vector<std::string> args{ std::to_string(dir.x), std::to_string(dir.y), std::to_string(dir.z) };
-				socketManager.SendPacket(OpCode::PlayerRightMouseDirChange, args);
-				rightMouseDownDir = dir;
-			}
+			rightMouseDownDir = Utility::MousePosToDirection(g_clientWidth, g_clientHeight, derivedEvent->mousePosX, derivedEvent->mousePosY);
 		}
 	};
 
@@ -1247,6 +1276,7 @@ void Game::CreateEventHandlers()
 		GameObject& player = objectManager.CreateGameObject(derivedEvent->position, XMFLOAT3{ 14.0f, 14.0f, 14.0f }, PLAYER_SPEED, GameObjectType::Player, derivedEvent->name, derivedEvent->accountId);
 		const auto playerId = player.GetId();
 		this->player = &player;
+		predictedInputs.clear();
 
 		clientSettingsManager = std::make_unique<ClientSettingsManager>(*this, player.name);
 		clientSettingsManager->LoadClientSettings();
@@ -1332,6 +1362,7 @@ void Game::CreateEventHandlers()
 		{
 			GameObject& obj = objectManager.CreateGameObject(pos, XMFLOAT3{ 14.0f, 14.0f, 14.0f }, speed, GameObjectType::Npc, name, gameObjectId);
 			obj.movementVector = mov;
+			snapshotInterpolator.AddSnapshot(gameObjectId, timer.TotalTime(), pos, mov);
 			const RenderComponent& sphereRenderComponent = renderComponentManager.CreateRenderComponent(gameObjectId, meshes[modelId].get(), vertexShader.Get(), pixelShader.Get(), textures[textureId].Get());
 			obj.renderComponentId = sphereRenderComponent.GetId();
 
@@ -1346,8 +1377,8 @@ void Game::CreateEventHandlers()
 		else
 		{
 			GameObject& gameObject = objectManager.GetGameObjectById(derivedEvent->gameObjectId);
-			gameObject.localPosition = pos;
 			gameObject.movementVector = mov;
+			snapshotInterpolator.AddSnapshot(gameObjectId, timer.TotalTime(), pos, mov);
 
 			StatsComponent& statsComponent = statsComponentManager.GetComponentById(gameObject.statsComponentId);
 			statsComponent.agility = agility;
@@ -1366,6 +1397,23 @@ void Game::CreateEventHandlers()
 		}
 	};
 
+	eventHandlers[EventType::Pong] = [this](const Event* const event)
+	{
+		const auto derivedEvent = (PongEvent*)event;
+
+		ping = static_cast<int>(std::round(derivedEvent->rtt * 1000));
+	};
+
+	eventHandlers[EventType::PlayerCorrection] = [this](const Event* const event)
+	{
+		const auto derivedEvent = (PlayerCorrectionEvent*)event;
+
+		if (activeLayer != Layer::InGame)
+			return;
+
+		ReconcilePlayerMovement(derivedEvent->inputSequence, derivedEvent->position, derivedEvent->movementVector, derivedEvent->destination);
+	};
+
 	eventHandlers[EventType::PlayerUpdate] = [this](const Event* const event)
 	{
 		const auto derivedEvent = (PlayerUpdateEvent*)event;
@@ -1395,6 +1443,7 @@ void Game::CreateEventHandlers()
 		{
 			GameObject& obj = objectManager.CreateGameObject(pos, XMFLOAT3{ 14.0f, 14.0f, 14.0f }, PLAYER_SPEED, GameObjectType::Player, name, gameObjectId);
 			obj.movementVector = mov;
+			snapshotInterpolator.AddSnapshot(gameObjectId, timer.TotalTime(), pos, mov);
 			const RenderComponent& sphereRenderComponent = renderComponentManager.CreateRenderComponent(gameObjectId, meshes.at(modelId).get(), vertexShader.Get(), pixelShader.Get(), textures.at(textureId).Get());
 			obj.renderComponentId = sphereRenderComponent.GetId();
 
@@ -1407,8 +1456,13 @@ void Game::CreateEventHandlers()
 		else
 		{
 			GameObject& obj = objectManager.GetGameObjectById(derivedEvent->accountId);
-			obj.localPosition = pos;
-			obj.movementVector = mov;
+
+			// our own character is predicted locally and only moved by PlayerCorrection
+			if (&obj != player)
+			{
+				obj.movementVector = mov;
+				snapshotInterpolator.AddSnapshot(gameObjectId, timer.TotalTime(), pos, mov);
+			}
 
 			StatsComponent& statsComponent = statsComponentManager.GetComponentById(obj.statsComponentId);
 			statsComponent.agility = agility;
@@ -1528,8 +1582,9 @@ void Game::CreateEventHandlers()
 	eventHandlers[EventType::PropagateChatMessage] = [this](const Event* const event)
 	{
 		const auto derivedEvent = (PropagateChatMessageEvent*)event;
-		
-		textWindow->AddMessage("(" + derivedEvent->senderName + ") " + derivedEvent->message);
+		const auto channel = derivedEvent->channel.empty() ? std::string{ "" } : "[" + derivedEvent->channel + "] ";
+
+		textWindow->AddMessage(channel + "(" + derivedEvent->senderName + ") " + derivedEvent->message);
 	};
 
 	eventHandlers[EventType::ServerMessage] = [this](const Event* const event)
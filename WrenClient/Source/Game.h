@@ -37,6 +37,8 @@
 #include "EventHandling/EventHandler.h"
 #include "ClientSocketManager.h"
 #include "ClientSettingsManager.h"
+#include <Networking/SnapshotInterpolator.h>
+#include <PlayerMovement.h>
 
 static constexpr auto ARIAL_FONT_FAMILY{ L"Arial" };
 static constexpr auto LOCALE{ L"en-US" };
@@ -68,7 +70,6 @@ public:
 	void OnResuming();
 	void OnWindowMoved();
 	void OnWindowSizeChanged(int width, int height);
-	void OnPong(unsigned int pingId);
 
 	~Game();
 
@@ -82,11 +83,11 @@ private:
 	CommonRepository& commonRepository;
 	ClientSocketManager& socketManager;
 	int ping{ 0 };
-	float pingStart{ 0.0f };
-	unsigned int pingId{ 0 };
 	float doubleClickStart{ 0.0f };
 	float updateTimer{ 0.0f };
 	XMFLOAT3 rightMouseDownDir{ VEC_ZERO };
+	unsigned int inputSequence{ 0 };
+	std::deque<PlayerInput> predictedInputs; // sent but not yet acknowledged by a PlayerCorrection
 	std::string characterNamePendingDeletion{};
 	XMMATRIX worldTransform{ XMMatrixIdentity() };
 	XMMATRIX viewTransform{ XMMatrixIdentity() };
@@ -97,6 +98,7 @@ private:
 	Camera camera;
 	GameMap gameMap;
 	GameObject* player;
+	SnapshotInterpolator snapshotInterpolator;
 	std::vector<UIComponent*> uiComponents;
 	std::vector<std::unique_ptr<Mesh>> meshes;
 	std::vector<ComPtr<ID3D11ShaderResourceView>> textures;
@@ -132,6 +134,9 @@ private:
 	void InitializeCharacterListings();
 	void InitializeStaticObjects();
 
+	void PredictPlayerMovement();
+	void ReconcilePlayerMovement(const unsigned int inputSequence, const XMFLOAT3& position, const XMFLOAT3& movementVector, const XMFLOAT3& destination);
+	void UpdateRemotePositions();
 	void Render(const float updateTimer);
 	void Clear();
 	void CreateDeviceDependentResources();
@@ -28,7 +28,6 @@ int CALLBACK WinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, LPSTR lpCmdLi
 	static CommonRepository commonRepository{ "..\\..\\Databases\\WrenCommon.db" };
 	static ClientSocketManager socketManager{ eventHandler };
 	static auto game = std::make_unique<Game>(eventHandler, objectManager, renderComponentManager, statsComponentManager, inventoryComponentManager, clientRepository, commonRepository, socketManager);
-	socketManager.SetGamePointer(game.get()); // this is a hack to get ping/pong working. refactor.
 
 	// Register class
 	WNDCLASSEX wcex = {};
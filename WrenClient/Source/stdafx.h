@@ -39,6 +39,7 @@
 #include <list>
 #include <forward_list>
 #include <queue>
+#include <random>
 #include <d3d11.h>
 #include <dxgi1_6.h>
 #include <d2d1_3.h>
@@ -5,6 +5,8 @@ constexpr char LIST_STATIC_OBJECTS_QUERY[] = "SELECT id, name, model_id, texture
 
 std::vector<std::unique_ptr<StaticObject>> CommonRepository::ListStaticObjects()
 {
+	QueryScope scope{ *this, "CommonRepository::ListStaticObjects" };
+
 	auto dbConnection = GetConnection();
 	auto statement = PrepareStatement(dbConnection, LIST_STATIC_OBJECTS_QUERY);
 
@@ -23,6 +23,8 @@ public:
 	ComponentManager(EventHandler& eventHandler, ObjectManager& objectManager);
 	
 	T& GetComponentById(const int componentId);
+	const int GetComponentCount() const;
+	const int GetMaxComponents() const;
 	const bool HandleEvent(const Event* const event) override;
 	~ComponentManager();
 };
@@ -68,6 +70,18 @@ T& ComponentManager<T, maxComponents>::GetComponentById(const int componentId)
 	return components[index];
 }
 
+template <class T, int maxComponents>
+const int ComponentManager<T, maxComponents>::GetComponentCount() const
+{
+	return componentIndex;
+}
+
+template <class T, int maxComponents>
+const int ComponentManager<T, maxComponents>::GetMaxComponents() const
+{
+	return maxComponents;
+}
+
 template <class T, int maxComponents>
 const bool ComponentManager<T, maxComponents>::HandleEvent(const Event* const event)
 {
@@ -24,7 +24,9 @@ constexpr XMFLOAT3 VEC_NORTHWEST = XMFLOAT3{ -1.0f, 0.0f, 1.0f };
 constexpr XMFLOAT3 VEC_WEST      = XMFLOAT3{ -1.0f, 0.0f, 0.0f };
 
 const OpCode CHECKSUM{ OpCode::Checksum };
-constexpr auto PACKET_SIZE = 1024;
+constexpr auto PACKET_SIZE = 1024; // initial capacity of a Packet
+constexpr auto MAX_MESSAGE_SIZE = 65536; // larger messages are split into fragments across several datagrams
+constexpr auto MAX_DATAGRAM_SIZE = 1200; // stay under the typical internet MTU so datagrams never get split by IP
 constexpr auto SERVER_IP_ADDRESS = "127.0.0.1";
 constexpr auto SERVER_PORT_NUMBER = 27016;
 
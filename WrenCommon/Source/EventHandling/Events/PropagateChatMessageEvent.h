@@ -5,12 +5,14 @@
 class PropagateChatMessageEvent : public Event
 {
 public:
-	PropagateChatMessageEvent(const std::string& senderName, const std::string& message)
+	PropagateChatMessageEvent(const std::string& senderName, const std::string& message, const std::string& channel)
 		: Event(EventType::PropagateChatMessage),
 		  senderName{ senderName },
-		  message{ message }
+		  message{ message },
+		  channel{ channel }
 	{
 	}
 	const std::string senderName;
 	const std::string message;
+	const std::string channel; // empty for say
 };
\ No newline at end of file
@@ -55,3 +55,5 @@ XMFLOAT3 GameObject::GetWorldPosition() const
 const int GameObject::GetId() const { return id; }
 
 const GameObjectType GameObject::GetType() const { return type; }
+
+const float GameObject::GetSpeed() const { return speed; }
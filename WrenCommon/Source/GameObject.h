@@ -25,6 +25,7 @@ public:
     XMFLOAT3 GetWorldPosition() const;
 	const int GetId() const;
 	const GameObjectType GetType() const;
+	const float GetSpeed() const;
 
 	std::string name{ "" };
 
@@ -38,6 +39,7 @@ public:
 	// only really needed on the server. separate component?
 	int modelId{ -1 };
 	int textureId{ -1 };
+	unsigned short replicationSequence{ 0 }; // bumped each tick the entity is encoded, see EntityState
 
 	// components. i think this should be a map or vector? map<ComponentType, unsigned int>
 	int statsComponentId{ -1 };
@@ -10,9 +10,19 @@ GameTimer::GameTimer() :
     mCurrTime(0),
     mStopped(false)
 {
-    __int64 countsPerSec;
-    QueryPerformanceFrequency((LARGE_INTEGER*)&countsPerSec);
-    mSecondsPerCount = 1.0 / (double)countsPerSec;
+    mSecondsPerCount = (double)std::chrono::steady_clock::period::num / std::chrono::steady_clock::period::den;
+}
+
+// steady_clock is portable and as precise as the platform allows (it's QueryPerformanceCounter on Windows)
+__int64 GameTimer::GetCounts()
+{
+    return static_cast<__int64>(std::chrono::steady_clock::now().time_since_epoch().count());
+}
+
+// Seconds since an arbitrary point, with full double precision for deadlines in long running loops.
+double GameTimer::GetTime()
+{
+    return GetCounts() * ((double)std::chrono::steady_clock::period::num / std::chrono::steady_clock::period::den);
 }
 
 void GameTimer::Tick()
@@ -23,8 +33,7 @@ void GameTimer::Tick()
         return;
     }
     // Get the time this frame.
-    __int64 currTime;
-    QueryPerformanceCounter((LARGE_INTEGER*)&currTime);
+    const __int64 currTime = GetCounts();
     mCurrTime = currTime;
     // Time difference between this frame and the previous.
     mDeltaTime = (mCurrTime - mPrevTime)*mSecondsPerCount;
@@ -46,8 +55,7 @@ float GameTimer::DeltaTime()
 
 void GameTimer::Reset()
 {
-    __int64 currTime;
-    QueryPerformanceCounter((LARGE_INTEGER*)&currTime);
+    const __int64 currTime = GetCounts();
     mBaseTime = currTime;
     mPrevTime = currTime;
     mStopTime = 0;
@@ -59,8 +67,7 @@ void GameTimer::Stop()
     // If we are already stopped, then don't do anything.
     if (!mStopped)
     {
-        __int64 currTime;
-        QueryPerformanceCounter((LARGE_INTEGER*)&currTime);
+        const __int64 currTime = GetCounts();
         // Otherwise, save the time we stopped at, and set
         // the Boolean flag indicating the timer is stopped.
         mStopTime = currTime;
@@ -70,8 +77,7 @@ void GameTimer::Stop()
 
 void GameTimer::Start()
 {
-    __int64 startTime;
-    QueryPerformanceCounter((LARGE_INTEGER*)&startTime);
+    const __int64 startTime = GetCounts();
     // Accumulate the time elapsed between stop and start pairs.
     //
     // |<-------d------->|
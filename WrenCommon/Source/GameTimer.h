@@ -10,7 +10,10 @@ public:
     void Start(); // Call when unpaused.
     void Stop(); // Call when paused.
     void Tick(); // Call every frame.
+    static double GetTime(); // in seconds
 private:
+    static __int64 GetCounts();
+
     double mSecondsPerCount;
     double mDeltaTime;
     __int64 mBaseTime;
@@ -0,0 +1,107 @@
+#include "stdafx.h"
+#include "BitReader.h"
+#include "BitWriter.h"
+#include "Direction.h"
+#include <Utility.h>
+
+BitReader::BitReader(const char* data, const int length)
+	: data{ reinterpret_cast<const unsigned char*>(data) },
+	  length{ length }
+{
+}
+
+const unsigned int BitReader::ReadBits(const int bits)
+{
+	if (bitPosition + bits > length * 8)
+	{
+		failed = true;
+		bitPosition = length * 8;
+		return 0;
+	}
+
+	unsigned __int64 value{ 0 };
+	auto bitsRead = 0;
+	while (bitsRead < bits)
+	{
+		const auto byteOffset = bitPosition >> 3;
+		const auto bitOffset = bitPosition & 7;
+		const auto count = Utility::Min<int>(8 - bitOffset, bits - bitsRead);
+		const auto chunk = (data[byteOffset] >> bitOffset) & ((1u << count) - 1);
+		value |= static_cast<unsigned __int64>(chunk) << bitsRead;
+		bitsRead += count;
+		bitPosition += count;
+	}
+	return static_cast<unsigned int>(value);
+}
+
+const bool BitReader::ReadBool()
+{
+	return ReadBits(1) != 0;
+}
+
+const int BitReader::ReadRangedInt(const int min, const int max)
+{
+	const auto value = static_cast<int>(ReadBits(BitWriter::BitsRequired(static_cast<unsigned int>(max - min)))) + min;
+	if (value > max)
+	{
+		failed = true;
+		return max;
+	}
+	return value;
+}
+
+const float BitReader::ReadQuantizedFloat(const float min, const float max, const int bits)
+{
+	const auto steps = static_cast<unsigned int>((1ull << bits) - 1);
+	return min + (static_cast<float>(ReadBits(bits)) / steps) * (max - min);
+}
+
+const float BitReader::ReadFloat()
+{
+	const auto bits = ReadBits(32);
+	float value;
+	memcpy(&value, &bits, sizeof(float));
+	return value;
+}
+
+const XMFLOAT3 BitReader::ReadDirection()
+{
+	const auto index = static_cast<int>(ReadBits(DIRECTION_BITS));
+	if (index == DIRECTION_ESCAPE)
+	{
+		const auto x = ReadFloat();
+		const auto y = ReadFloat();
+		const auto z = ReadFloat();
+		return XMFLOAT3{ x, y, z };
+	}
+
+	if (index >= DIRECTION_COUNT)
+	{
+		failed = true;
+		return VEC_ZERO;
+	}
+
+	return Direction::FromIndex(index);
+}
+
+const std::string BitReader::ReadString()
+{
+	const auto length = static_cast<int>(ReadBits(8));
+	std::string value;
+	value.reserve(length);
+	for (auto i = 0; i < length && !failed; i++)
+		value += static_cast<char>(ReadBits(8));
+	return value;
+}
+
+// Skips to the next whole byte and returns everything after it, e.g. a message carried inside another.
+// The reader is at the end afterwards.
+const char* BitReader::ReadRemainder(int& remainderLength)
+{
+	const auto byteOffset = Utility::Min<int>((bitPosition + 7) >> 3, length);
+	remainderLength = length - byteOffset;
+	bitPosition = length * 8;
+	return reinterpret_cast<const char*>(data + byteOffset);
+}
+
+const bool BitReader::Failed() const { return failed; }
\ No newline at end of file
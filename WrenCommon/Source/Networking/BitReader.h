@@ -0,0 +1,23 @@
+#pragma once
+
+// Reads values written by BitWriter. Reading past the end doesn't throw, since the input comes off
+// the network: it returns zeros and marks the reader as failed, which handlers check once at the end.
+class BitReader
+{
+	const unsigned char* data;
+	int length;
+	int bitPosition{ 0 };
+	bool failed{ false };
+
+public:
+	BitReader(const char* data, const int length);
+	const unsigned int ReadBits(const int bits);
+	const bool ReadBool();
+	const int ReadRangedInt(const int min, const int max);
+	const float ReadQuantizedFloat(const float min, const float max, const int bits);
+	const float ReadFloat();
+	const XMFLOAT3 ReadDirection();
+	const std::string ReadString();
+	const char* ReadRemainder(int& remainderLength);
+	const bool Failed() const;
+};
\ No newline at end of file
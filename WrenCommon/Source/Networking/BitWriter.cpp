@@ -0,0 +1,102 @@
+#include "stdafx.h"
+#include "BitWriter.h"
+#include "Direction.h"
+#include <Utility.h>
+
+void BitWriter::WriteBits(const unsigned int value, const int bits)
+{
+	const auto mask = bits == 32 ? 0xFFFFFFFFull : (1ull << bits) - 1;
+	scratch |= (static_cast<unsigned __int64>(value) & mask) << scratchBits;
+	scratchBits += bits;
+	bitsWritten += bits;
+
+	while (scratchBits >= 8)
+	{
+		data.push_back(static_cast<unsigned char>(scratch & 0xFF));
+		scratch >>= 8;
+		scratchBits -= 8;
+	}
+}
+
+void BitWriter::WriteBool(const bool value)
+{
+	WriteBits(value ? 1 : 0, 1);
+}
+
+// Values outside [min, max] are clamped.
+void BitWriter::WriteRangedInt(const int value, const int min, const int max)
+{
+	const auto clamped = Utility::Min<int>(max, Utility::Max<int>(min, value));
+	WriteBits(static_cast<unsigned int>(clamped - min), BitsRequired(static_cast<unsigned int>(max - min)));
+}
+
+// Maps [min, max] onto 2^bits evenly spaced steps, so the error is at most half a step.
+void BitWriter::WriteQuantizedFloat(const float value, const float min, const float max, const int bits)
+{
+	const auto steps = static_cast<unsigned int>((1ull << bits) - 1);
+	const auto normalized = (Utility::Min<float>(max, Utility::Max<float>(min, value)) - min) / (max - min);
+	WriteBits(static_cast<unsigned int>(normalized * steps + 0.5f), bits);
+}
+
+void BitWriter::WriteFloat(const float value)
+{
+	unsigned int bits;
+	memcpy(&bits, &value, sizeof(float));
+	WriteBits(bits, 32);
+}
+
+// Movement vectors are almost always one of the nine VEC_* constants, which fit in 4 bits.
+// Anything else is sent as raw floats behind an escape code.
+void BitWriter::WriteDirection(const XMFLOAT3& direction)
+{
+	const auto index = Direction::ToIndex(direction);
+	WriteBits(static_cast<unsigned int>(index), DIRECTION_BITS);
+	if (index == DIRECTION_ESCAPE)
+	{
+		WriteFloat(direction.x);
+		WriteFloat(direction.y);
+		WriteFloat(direction.z);
+	}
+}
+
+// Strings longer than 255 bytes are truncated.
+void BitWriter::WriteString(const std::string& value)
+{
+	const auto length = Utility::Min<int>(255, static_cast<int>(value.length()));
+	WriteBits(static_cast<unsigned int>(length), 8);
+	for (auto i = 0; i < length; i++)
+		WriteBits(static_cast<unsigned char>(value[i]), 8);
+}
+
+// Pads the last partial byte with zeros; call before GetData.
+void BitWriter::Flush()
+{
+	if (scratchBits > 0)
+	{
+		data.push_back(static_cast<unsigned char>(scratch & 0xFF));
+		scratch = 0;
+		scratchBits = 0;
+	}
+}
+
+void BitWriter::Reset()
+{
+	data.clear();
+	scratch = 0;
+	scratchBits = 0;
+	bitsWritten = 0;
+}
+
+const char* BitWriter::GetData() const { return reinterpret_cast<const char*>(data.data()); }
+
+const int BitWriter::GetLength() const { return static_cast<int>(data.size()); }
+
+const int BitWriter::GetBitsWritten() const { return bitsWritten; }
+
+const int BitWriter::BitsRequired(const unsigned int range)
+{
+	auto bits = 0;
+	while (bits < 32 && (range >> bits) != 0)
+		bits++;
+	return bits;
+}
\ No newline at end of file
@@ -0,0 +1,27 @@
+#pragma once
+
+// Packs values into a byte buffer using only as many bits as each one needs. The quantizing
+// writes must be read back by BitReader with the same ranges and bit counts.
+class BitWriter
+{
+	std::vector<unsigned char> data;
+	unsigned __int64 scratch{ 0 };
+	int scratchBits{ 0 };
+	int bitsWritten{ 0 };
+
+public:
+	void WriteBits(const unsigned int value, const int bits);
+	void WriteBool(const bool value);
+	void WriteRangedInt(const int value, const int min, const int max);
+	void WriteQuantizedFloat(const float value, const float min, const float max, const int bits);
+	void WriteFloat(const float value);
+	void WriteDirection(const XMFLOAT3& direction);
+	void WriteString(const std::string& value);
+	void Flush();
+	void Reset();
+	const char* GetData() const;
+	const int GetLength() const;
+	const int GetBitsWritten() const;
+
+	static const int BitsRequired(const unsigned int range);
+};
\ No newline at end of file
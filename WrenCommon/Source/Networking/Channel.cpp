@@ -0,0 +1,30 @@
+#include "stdafx.h"
+#include "Channel.h"
+
+const Channel GetChannel(const OpCode opCode)
+{
+	switch (opCode)
+	{
+		// high-rate state that is superseded by the next update anyway; each carries its entity's own
+		// sequence, so the receiver drops stale updates per entity (see EntitySequences)
+		case OpCode::NpcUpdate:
+		case OpCode::PlayerUpdate:
+		case OpCode::PlayerCorrection:
+		case OpCode::ZoneBorderUpdate:
+		// periodic or purely cosmetic messages where a resend would arrive too late to matter
+		case OpCode::Heartbeat:
+		case OpCode::Ping:
+		case OpCode::Pong:
+		case OpCode::AttackHit:
+		case OpCode::AttackMiss:
+		// every PlayerInput repeats the last few inputs, so the next one covers for a lost one
+		case OpCode::PlayerInput:
+		// carries a forwarded message that was unreliable to begin with
+		case OpCode::GatewayForwardUnreliable:
+			return Channel::Unreliable;
+
+		// logins, character management, inventory, chat and player input must never be lost or reordered
+		default:
+			return Channel::ReliableOrdered;
+	}
+}
\ No newline at end of file
@@ -0,0 +1,13 @@
+#pragma once
+
+#include <OpCodes.h>
+
+// Delivery guarantees a message can be sent with. Every OpCode is assigned to exactly one
+// channel, so both sides agree without having to negotiate it per message.
+enum class Channel : unsigned char
+{
+	Unreliable,     // fire and forget, may arrive out of order or not at all
+	ReliableOrdered // resent until acknowledged and delivered in the order it was sent
+};
+
+const Channel GetChannel(const OpCode opCode);
\ No newline at end of file
@@ -0,0 +1,100 @@
+#include "stdafx.h"
+#include "ClockSync.h"
+#include <Utility.h>
+
+// first and count are in order of age, oldest first
+const int ClockSync::FindBestSample(const int first, const int count) const
+{
+	const auto oldest = (nextSample - sampleCount + CLOCK_SYNC_SAMPLES) % CLOCK_SYNC_SAMPLES;
+	auto best = -1;
+	for (auto i = first; i < first + count; i++)
+	{
+		const auto index = (oldest + i) % CLOCK_SYNC_SAMPLES;
+		if (best == -1 || samples[index].rtt < samples[best].rtt)
+			best = index;
+	}
+	return best;
+}
+
+// sendTime and receiveTime are local; serverTime is when the server answered the Ping.
+void ClockSync::AddSample(const double sendTime, const double serverTime, const double receiveTime)
+{
+	const auto sampleRtt = Utility::Max<double>(receiveTime - sendTime, 0.0);
+	const auto localTime = sendTime + sampleRtt / 2.0;
+	const auto offset = serverTime - localTime;
+
+	// each sample puts the true offset within half its round trip of its own; if this one can't agree
+	// with the best so far, the server's clock has jumped, e.g. a gateway moved us to another zone
+	if (totalSamples > 0 && std::abs(offset - anchor.offset) > (sampleRtt + anchor.rtt) / 2.0 + CLOCK_SYNC_SNAP_THRESHOLD)
+	{
+		const auto previousRtt = rtt;
+		const auto previousJitter = jitter;
+		Reset();
+		rtt = previousRtt;
+		jitter = previousJitter;
+	}
+
+	// RFC 3550 style: a running average of how much consecutive round trips differ
+	if (rtt > 0.0)
+		jitter += (std::abs(sampleRtt - rtt) - jitter) / 16.0;
+	rtt = sampleRtt;
+
+	samples[nextSample] = ClockSample{ localTime, offset, sampleRtt };
+	nextSample = (nextSample + 1) % CLOCK_SYNC_SAMPLES;
+	sampleCount = Utility::Min<int>(sampleCount + 1, CLOCK_SYNC_SAMPLES);
+	totalSamples++;
+
+	anchor = samples[FindBestSample(0, sampleCount)];
+
+	const auto half = sampleCount / 2;
+	if (half > 0)
+	{
+		const ClockSample& older = samples[FindBestSample(0, half)];
+		const ClockSample& newer = samples[FindBestSample(half, sampleCount - half)];
+		const auto span = newer.localTime - older.localTime;
+		if (span >= CLOCK_SYNC_MIN_DRIFT_SPAN)
+			drift = Utility::Max<double>(-CLOCK_SYNC_MAX_DRIFT, Utility::Min<double>((newer.offset - older.offset) / span, CLOCK_SYNC_MAX_DRIFT));
+	}
+
+	// the first sample is all there is to go on
+	if (totalSamples == 1)
+	{
+		appliedOffset = anchor.offset;
+		lastUpdateTime = localTime;
+	}
+}
+
+// For a new server, e.g. after a zone handoff, whose clock has nothing to do with the last one's.
+void ClockSync::Reset()
+{
+	*this = ClockSync{};
+}
+
+// Seconds on the server's tick timeline, so the server tick is GetServerTime / UPDATE_FREQUENCY.
+// Call it with a local time that doesn't go backwards; each call moves the clock towards the estimate.
+const double ClockSync::GetServerTime(const double localTime)
+{
+	if (totalSamples == 0)
+		return localTime;
+
+	const auto targetOffset = anchor.offset + drift * (localTime - anchor.localTime);
+	const auto error = targetOffset - appliedOffset;
+	const auto maxCorrection = Utility::Max<double>(localTime - lastUpdateTime, 0.0) * CLOCK_SYNC_MAX_SLEW;
+
+	if (std::abs(error) > CLOCK_SYNC_SNAP_THRESHOLD)
+		appliedOffset = targetOffset;
+	else
+		appliedOffset += Utility::Max<double>(-maxCorrection, Utility::Min<double>(error, maxCorrection));
+	lastUpdateTime = localTime;
+
+	return localTime + appliedOffset;
+}
+
+const bool ClockSync::IsSynced() const { return totalSamples >= CLOCK_SYNC_FAST_SAMPLES; }
+
+const double ClockSync::GetPingInterval() const { return IsSynced() ? CLOCK_SYNC_INTERVAL : CLOCK_SYNC_FAST_INTERVAL; }
+
+// The latest round trip, in seconds.
+const double ClockSync::GetRtt() const { return rtt; }
+
+const double ClockSync::GetJitter() const { return jitter; }
\ No newline at end of file
@@ -0,0 +1,46 @@
+#pragma once
+
+constexpr auto CLOCK_SYNC_SAMPLES = 16;           // round trips kept for filtering and drift estimates
+constexpr auto CLOCK_SYNC_INTERVAL = 1.0;         // seconds between pings once synced
+constexpr auto CLOCK_SYNC_FAST_INTERVAL = 0.25;   // seconds between pings until there are CLOCK_SYNC_FAST_SAMPLES
+constexpr auto CLOCK_SYNC_FAST_SAMPLES = 8;
+constexpr auto CLOCK_SYNC_MAX_SLEW = 0.05;        // the clock runs at most 5% fast or slow while it catches up
+constexpr auto CLOCK_SYNC_SNAP_THRESHOLD = 0.25;  // seconds of error that are corrected with a jump instead
+constexpr auto CLOCK_SYNC_MIN_DRIFT_SPAN = 8.0;   // seconds between samples before drift is estimated
+constexpr auto CLOCK_SYNC_MAX_DRIFT = 0.0005;     // seconds per second; anything more is noise
+
+struct ClockSample
+{
+	double localTime; // halfway through the round trip
+	double offset;    // server time minus localTime
+	double rtt;
+};
+
+// NTP-style estimate of the server's clock from Ping/Pong round trips. Queuing delay is rarely the same
+// both ways, so only the offset of the sample with the smallest round trip in the window is trusted.
+// The best samples of the older and newer half of the window give the drift between the two clocks.
+// The clock is slewed towards the estimate rather than stepped, so it doesn't run backwards, unless
+// it's further off than CLOCK_SYNC_SNAP_THRESHOLD.
+class ClockSync
+{
+	ClockSample samples[CLOCK_SYNC_SAMPLES];
+	int sampleCount{ 0 };
+	int nextSample{ 0 };
+	int totalSamples{ 0 };
+	ClockSample anchor{ 0.0, 0.0, 0.0 }; // the best sample in the window
+	double drift{ 0.0 };
+	double appliedOffset{ 0.0 };
+	double lastUpdateTime{ 0.0 };
+	double rtt{ 0.0 };
+	double jitter{ 0.0 };
+
+	const int FindBestSample(const int first, const int count) const;
+public:
+	void AddSample(const double sendTime, const double serverTime, const double receiveTime);
+	void Reset();
+	const double GetServerTime(const double localTime);
+	const bool IsSynced() const;
+	const double GetPingInterval() const;
+	const double GetRtt() const;
+	const double GetJitter() const;
+};
\ No newline at end of file
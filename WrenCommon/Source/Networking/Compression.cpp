@@ -0,0 +1,175 @@
+#include "stdafx.h"
+#include "Compression.h"
+
+constexpr auto MIN_MATCH = 4;
+constexpr auto MAX_OFFSET = 65535;
+constexpr auto HASH_BITS = 12;
+
+static const unsigned int Read32(const unsigned char* p)
+{
+	unsigned int value;
+	memcpy(&value, p, sizeof(unsigned int));
+	return value;
+}
+
+static const unsigned int Hash(const unsigned int sequence)
+{
+	return (sequence * 2654435761u) >> (32 - HASH_BITS);
+}
+
+static unsigned char* WriteLength(unsigned char* op, int length)
+{
+	while (length >= 255)
+	{
+		*op++ = 255;
+		length -= 255;
+	}
+	*op++ = static_cast<unsigned char>(length);
+	return op;
+}
+
+const int Compression::GetMaxCompressedSize(const int length)
+{
+	return length + length / 255 + 16;
+}
+
+const int Compression::Compress(const char* src, const int srcLength, char* dst, const int dstCapacity)
+{
+	if (dstCapacity < GetMaxCompressedSize(srcLength))
+		return 0;
+
+	const auto* const input = reinterpret_cast<const unsigned char*>(src);
+	const auto* const inputEnd = input + srcLength;
+	// leave room so a match never reads past the end of the input
+	const auto* const matchLimit = srcLength > MIN_MATCH ? inputEnd - MIN_MATCH : input;
+	auto* op = reinterpret_cast<unsigned char*>(dst);
+
+	int hashTable[1 << HASH_BITS];
+	for (auto i = 0; i < (1 << HASH_BITS); i++)
+		hashTable[i] = -1;
+
+	const unsigned char* anchor = input;
+	const unsigned char* ip = input;
+	while (ip < matchLimit)
+	{
+		const auto sequence = Read32(ip);
+		const auto hash = Hash(sequence);
+		const auto candidateIndex = hashTable[hash];
+		hashTable[hash] = static_cast<int>(ip - input);
+
+		if (candidateIndex < 0 || (ip - input) - candidateIndex > MAX_OFFSET || Read32(input + candidateIndex) != sequence)
+		{
+			ip++;
+			continue;
+		}
+
+		const unsigned char* match = input + candidateIndex;
+		auto matchLength = MIN_MATCH;
+		while (ip + matchLength < inputEnd && ip[matchLength] == match[matchLength])
+			matchLength++;
+
+		const auto literalLength = static_cast<int>(ip - anchor);
+		unsigned char* token = op++;
+		*token = static_cast<unsigned char>((literalLength < 15 ? literalLength : 15) << 4);
+		if (literalLength >= 15)
+			op = WriteLength(op, literalLength - 15);
+		memcpy(op, anchor, literalLength);
+		op += literalLength;
+
+		const auto offset = static_cast<unsigned short>(ip - match);
+		memcpy(op, &offset, sizeof(unsigned short));
+		op += sizeof(unsigned short);
+
+		const auto extraLength = matchLength - MIN_MATCH;
+		*token |= static_cast<unsigned char>(extraLength < 15 ? extraLength : 15);
+		if (extraLength >= 15)
+			op = WriteLength(op, extraLength - 15);
+
+		ip += matchLength;
+		anchor = ip;
+	}
+
+	// the last sequence is just the remaining literals
+	const auto literalLength = static_cast<int>(inputEnd - anchor);
+	*op++ = static_cast<unsigned char>((literalLength < 15 ? literalLength : 15) << 4);
+	if (literalLength >= 15)
+		op = WriteLength(op, literalLength - 15);
+	memcpy(op, anchor, literalLength);
+	op += literalLength;
+
+	return static_cast<int>(op - reinterpret_cast<unsigned char*>(dst));
+}
+
+const bool Compression::Decompress(const char* src, const int srcLength, char* dst, const int dstLength)
+{
+	const auto* ip = reinterpret_cast<const unsigned char*>(src);
+	const auto* const inputEnd = ip + srcLength;
+	auto* op = reinterpret_cast<unsigned char*>(dst);
+	auto* const outputStart = op;
+	auto* const outputEnd = op + dstLength;
+
+	// a stream cut short after a match would otherwise still decode whenever the match happened to finish the output
+	auto ended = false;
+	while (ip < inputEnd)
+	{
+		const auto token = *ip++;
+
+		int literalLength = token >> 4;
+		if (literalLength == 15)
+		{
+			unsigned char extra;
+			do
+			{
+				if (ip >= inputEnd)
+					return false;
+				extra = *ip++;
+				literalLength += extra;
+			} while (extra == 255);
+		}
+
+		if (literalLength > inputEnd - ip || literalLength > outputEnd - op)
+			return false;
+		memcpy(op, ip, literalLength);
+		ip += literalLength;
+		op += literalLength;
+
+		// the last sequence has no match
+		if (ip == inputEnd)
+		{
+			ended = true;
+			break;
+		}
+
+		if (inputEnd - ip < static_cast<int>(sizeof(unsigned short)))
+			return false;
+		unsigned short offset;
+		memcpy(&offset, ip, sizeof(unsigned short));
+		ip += sizeof(unsigned short);
+		if (offset == 0 || offset > op - outputStart)
+			return false;
+
+		int matchLength = token & 15;
+		if (matchLength == 15)
+		{
+			unsigned char extra;
+			do
+			{
+				if (ip >= inputEnd)
+					return false;
+				extra = *ip++;
+				matchLength += extra;
+			} while (extra == 255);
+		}
+		matchLength += MIN_MATCH;
+
+		if (matchLength > outputEnd - op)
+			return false;
+
+		// byte by byte, since matches may overlap the bytes they produce
+		const unsigned char* match = op - offset;
+		for (auto i = 0; i < matchLength; i++)
+			*op++ = *match++;
+	}
+
+	return ended && op == outputEnd;
+}
@@ -0,0 +1,18 @@
+#pragma once
+
+constexpr auto COMPRESSION_THRESHOLD = 128; // default size in bytes below which messages are sent as is
+
+// Small LZ77 codec in the style of LZ4's block format: a stream of sequences, each a token byte
+// (literal count in the high nibble, match length - 4 in the low nibble, 15 meaning "more bytes follow"),
+// the literals, then a 2 byte backwards offset. The last sequence has literals only.
+// Our messages are '|' delimited text with lots of repeated field shapes, which this handles well
+// for next to no CPU.
+class Compression
+{
+public:
+	static const int GetMaxCompressedSize(const int length);
+	// returns the compressed size, or 0 if the output wouldn't fit in dstCapacity
+	static const int Compress(const char* src, const int srcLength, char* dst, const int dstCapacity);
+	// returns false if the input is malformed, doesn't end with a literals-only sequence or doesn't decode to exactly dstLength bytes
+	static const bool Decompress(const char* src, const int srcLength, char* dst, const int dstLength);
+};
@@ -0,0 +1,288 @@
+#include "stdafx.h"
+#include "Connection.h"
+#include <Utility.h>
+
+const bool SequenceGreaterThan(const unsigned short l, const unsigned short r)
+{
+	return ((l > r) && (l - r <= 32768)) || ((l < r) && (r - l > 32768));
+}
+
+// Takes a reference to the Packet that is held until it has been sent (or acked, if reliable).
+// Messages too big for one datagram are split into fragments that each take a reliable message id,
+// so they are resent individually and arrive in order. Losing one fragment would lose the whole
+// message, so oversized messages always go reliable regardless of their channel.
+void Connection::Queue(Packet& packet, const Channel channel)
+{
+	const auto length = packet.GetLength();
+	if (length > MAX_FRAGMENT_SIZE)
+	{
+		const auto fragmentCount = static_cast<unsigned char>((length + MAX_FRAGMENT_SIZE - 1) / MAX_FRAGMENT_SIZE);
+		for (unsigned char i = 0; i < fragmentCount; i++)
+		{
+			packet.AddRef();
+			const auto offset = i * MAX_FRAGMENT_SIZE;
+			const auto fragmentLength = Utility::Min<int>(MAX_FRAGMENT_SIZE, length - offset);
+			reliableMessages.push_back(ReliableMessage{ &packet, nextReliableMessageId++, -1.0, -1.0, false, offset, fragmentLength, i, fragmentCount });
+		}
+		return;
+	}
+
+	packet.AddRef();
+
+	if (channel == Channel::ReliableOrdered)
+		reliableMessages.push_back(ReliableMessage{ &packet, nextReliableMessageId++, -1.0, -1.0, false, 0, length, 0, 1 });
+	else
+		outgoingMessages.push_back(OutgoingMessage{ &packet, channel });
+}
+
+void Connection::ReleasePackets()
+{
+	for (auto i = 0; i < outgoingMessages.size(); i++)
+		outgoingMessages[i].packet->Release();
+	outgoingMessages.clear();
+
+	for (auto i = 0; i < reliableMessages.size(); i++)
+		reliableMessages[i].packet->Release();
+	reliableMessages.clear();
+}
+
+const unsigned short Connection::NextSequence()
+{
+	return localSequence++;
+}
+
+void Connection::OnDatagramSent(const unsigned short sequence, const double sendTime, const std::vector<unsigned short>& reliableMessageIds)
+{
+	SentDatagram& sentDatagram = sentDatagrams[sequence % SENT_DATAGRAM_BUFFER_SIZE];
+	sentDatagram.sequence = sequence;
+	sentDatagram.valid = true;
+	sentDatagram.acked = false;
+	sentDatagram.sendTime = sendTime;
+	sentDatagram.reliableMessageIds = reliableMessageIds;
+}
+
+// Every datagram carries the newest sequence the peer has received from us plus a bitfield for
+// the 32 before it, so a single lost ack is covered by the next datagram that arrives.
+void Connection::ProcessAcks(const unsigned short ack, const unsigned int ackBits, const double now)
+{
+	AckDatagram(ack, now);
+	for (auto i = 0; i < 32; i++)
+	{
+		if (ackBits & (1u << i))
+			AckDatagram(static_cast<unsigned short>(ack - 1 - i), now);
+	}
+
+	// reliable messages are acked out of order, but only released from the front so the deque stays sorted by id
+	while (!reliableMessages.empty() && reliableMessages.front().acked)
+	{
+		reliableMessages.front().packet->Release();
+		reliableMessages.pop_front();
+	}
+}
+
+void Connection::AckDatagram(const unsigned short sequence, const double now)
+{
+	SentDatagram& sentDatagram = sentDatagrams[sequence % SENT_DATAGRAM_BUFFER_SIZE];
+	if (!sentDatagram.valid || sentDatagram.sequence != sequence || sentDatagram.acked)
+		return;
+
+	sentDatagram.acked = true;
+
+	// resends always go out in a new datagram, so every sample is unambiguous (Karn's algorithm)
+	const auto sample = static_cast<float>(now - sentDatagram.sendTime);
+	if (!hasRttSample)
+	{
+		smoothedRtt = sample;
+		rttVariance = sample / 2.0f;
+		hasRttSample = true;
+	}
+	else
+	{
+		rttVariance = 0.75f * rttVariance + 0.25f * std::abs(smoothedRtt - sample);
+		smoothedRtt = 0.875f * smoothedRtt + 0.125f * sample;
+	}
+
+	if (reliableMessages.empty())
+		return;
+
+	const auto firstId = reliableMessages.front().messageId;
+	for (auto i = 0; i < sentDatagram.reliableMessageIds.size(); i++)
+	{
+		const auto offset = static_cast<unsigned short>(sentDatagram.reliableMessageIds[i] - firstId);
+		if (offset < reliableMessages.size())
+			reliableMessages[offset].acked = true;
+	}
+}
+
+const bool Connection::HasAck() const { return receivedAnyDatagram; }
+
+const unsigned short Connection::GetAck() const { return remoteSequence; }
+
+const unsigned short Connection::GetRemoteSalt() const { return remoteSalt; }
+
+const unsigned int Connection::GetAckBits() const { return receivedBits; }
+
+const float Connection::GetResendTimeout() const
+{
+	if (!hasRttSample)
+		return MAX_RESEND_TIMEOUT / 4.0f;
+
+	const auto timeout = smoothedRtt + 4.0f * rttVariance;
+	if (timeout < MIN_RESEND_TIMEOUT)
+		return MIN_RESEND_TIMEOUT;
+	if (timeout > MAX_RESEND_TIMEOUT)
+		return MAX_RESEND_TIMEOUT;
+	return timeout;
+}
+
+const float Connection::GetRtt() const { return smoothedRtt; }
+
+// True once the oldest unacked reliable message, or the handshake if there isn't one yet, has gone
+// CONNECTION_TIMEOUT without an answer. Messages are sent in id order, so the front is the oldest.
+const bool Connection::HasTimedOut(const double now) const
+{
+	if (!connected)
+		return firstHandshakeTime >= 0.0 && now - firstHandshakeTime > CONNECTION_TIMEOUT;
+
+	return !reliableMessages.empty() && reliableMessages.front().firstSendTime >= 0.0
+		&& now - reliableMessages.front().firstSendTime > CONNECTION_TIMEOUT;
+}
+
+// A new salt means the peer dropped its state for us (restart or timeout), so we start over in both
+// directions: it expects our reliable stream from 0 again, and will send its own from 0.
+void Connection::SetRemoteSalt(const unsigned short remoteSalt)
+{
+	if (hasRemoteSalt && remoteSalt != this->remoteSalt)
+	{
+		ResetReceiveState();
+		ResetSendState();
+	}
+	this->remoteSalt = remoteSalt;
+	hasRemoteSalt = true;
+}
+
+// Anything goes until the first datagram or handshake Response has told us the peer's salt.
+const bool Connection::MatchesRemoteSalt(const unsigned short remoteSalt) const
+{
+	return !hasRemoteSalt || remoteSalt == this->remoteSalt;
+}
+
+// Returns false for duplicates and for datagrams too old to be tracked by the ack bitfield.
+const bool Connection::OnDatagramReceived(const unsigned short sequence)
+{
+	if (!receivedAnyDatagram)
+	{
+		receivedAnyDatagram = true;
+		remoteSequence = sequence;
+		receivedBits = 0;
+		return true;
+	}
+
+	if (SequenceGreaterThan(sequence, remoteSequence))
+	{
+		const auto shift = static_cast<unsigned short>(sequence - remoteSequence);
+		if (shift < 32)
+			receivedBits = (receivedBits << shift) | (1u << (shift - 1));
+		else if (shift == 32)
+			receivedBits = 1u << 31;
+		else
+			receivedBits = 0;
+		remoteSequence = sequence;
+		return true;
+	}
+
+	const auto age = static_cast<unsigned short>(remoteSequence - sequence);
+	if (age == 0 || age > 32)
+		return false;
+
+	const auto bit = 1u << (age - 1);
+	if (receivedBits & bit)
+		return false;
+
+	receivedBits |= bit;
+	return true;
+}
+
+void Connection::ResetReceiveState()
+{
+	receivedAnyDatagram = false;
+	receivedBits = 0;
+	nextExpectedReliableMessageId = 0;
+	bufferedReliableMessages.clear();
+	reassemblyFragmentCount = 0;
+	reassemblyBuffer.clear();
+}
+
+// Unacked reliable messages are renumbered from 0 and sent again in full, since acks from the
+// previous peer say nothing about what this one has. Our old datagram sequences can't be acked now.
+void Connection::ResetSendState()
+{
+	for (auto i = 0; i < SENT_DATAGRAM_BUFFER_SIZE; i++)
+		sentDatagrams[i].valid = false;
+
+	// the rest of a message whose first fragments were already released can't be reassembled
+	while (!reliableMessages.empty() && reliableMessages.front().fragmentIndex != 0)
+	{
+		reliableMessages.front().packet->Release();
+		reliableMessages.pop_front();
+	}
+
+	nextReliableMessageId = 0;
+	for (auto i = 0; i < reliableMessages.size(); i++)
+	{
+		ReliableMessage& message = reliableMessages[i];
+		message.messageId = nextReliableMessageId++;
+		message.lastSendTime = -1.0;
+		message.firstSendTime = -1.0;
+		message.acked = false;
+	}
+}
+
+const bool Connection::IsNextReliableMessage(const unsigned short messageId) const
+{
+	return messageId == nextExpectedReliableMessageId;
+}
+
+const bool Connection::IsFutureReliableMessage(const unsigned short messageId) const
+{
+	return SequenceGreaterThan(messageId, nextExpectedReliableMessageId);
+}
+
+void Connection::AdvanceReliableMessageId()
+{
+	nextExpectedReliableMessageId++;
+}
+
+const unsigned short Connection::GetNextExpectedReliableMessageId() const { return nextExpectedReliableMessageId; }
+
+// Fragments are delivered by the reliable channel in order, so reassembly only has to append them,
+// and a partial message never has to be timed out: the rest is on its way, or the Connection times out.
+// Returns true once the last fragment is in; anything inconsistent throws the partial message away.
+const bool Connection::AddFragment(const unsigned char fragmentIndex, const unsigned char fragmentCount, const char* data, const int length)
+{
+	if (fragmentIndex == 0)
+	{
+		reassemblyBuffer.clear();
+		reassemblyFragmentCount = fragmentCount;
+		nextFragmentIndex = 0;
+	}
+
+	if (reassemblyFragmentCount == 0 || fragmentCount != reassemblyFragmentCount || fragmentIndex != nextFragmentIndex
+		|| fragmentCount > MAX_FRAGMENT_COUNT || reassemblyBuffer.size() + length > MAX_MESSAGE_SIZE)
+	{
+		reassemblyFragmentCount = 0;
+		reassemblyBuffer.clear();
+		return false;
+	}
+
+	reassemblyBuffer.insert(reassemblyBuffer.end(), data, data + length);
+	nextFragmentIndex++;
+
+	if (nextFragmentIndex < reassemblyFragmentCount)
+		return false;
+
+	reassemblyFragmentCount = 0;
+	return true;
+}
+
+const std::vector<char>& Connection::GetReassembledMessage() const { return reassemblyBuffer; }
\ No newline at end of file
@@ -0,0 +1,148 @@
+#pragma once
+
+#include "Packet.h"
+#include "Channel.h"
+
+// checksum, salt, flags, sequence, ack, ack bitfield, ack salt
+constexpr auto DATAGRAM_HEADER_SIZE = static_cast<int>(sizeof(OpCode) + sizeof(unsigned short) + sizeof(unsigned char) + sizeof(unsigned short) * 2 + sizeof(unsigned int) + sizeof(unsigned short));
+// set on every datagram from a peer that can decompress messages, so both sides know without a handshake;
+// it says nothing about whether the sender compresses its own messages
+constexpr unsigned char DATAGRAM_FLAG_COMPRESSION = 0x01;
+// set once the sender has received a datagram from us; until then its ack, ack bitfield and ack salt mean nothing
+constexpr unsigned char DATAGRAM_FLAG_ACK = 0x02;
+// channel, payload length, message id (omitted for Channel::Unreliable), fragment index and count (fragments only)
+constexpr auto MAX_MESSAGE_HEADER_SIZE = static_cast<int>(sizeof(Channel) + sizeof(unsigned short) * 2 + sizeof(unsigned char) * 2);
+// set on the channel byte of a reliable message that is one fragment of a larger message
+constexpr unsigned char FRAGMENT_FLAG = 0x80;
+// set on the channel byte of a message (or every fragment of one) whose payload is compressed
+constexpr unsigned char COMPRESSED_FLAG = 0x40;
+// largest payload that still fits in a single datagram
+constexpr auto MAX_FRAGMENT_SIZE = MAX_DATAGRAM_SIZE - DATAGRAM_HEADER_SIZE - MAX_MESSAGE_HEADER_SIZE;
+constexpr auto MAX_FRAGMENT_COUNT = (MAX_MESSAGE_SIZE + MAX_FRAGMENT_SIZE - 1) / MAX_FRAGMENT_SIZE;
+
+constexpr auto SENT_DATAGRAM_BUFFER_SIZE = 256;
+constexpr auto MAX_BUFFERED_RELIABLE_MESSAGES = 256;
+// only the oldest this many unacked reliable messages are sent; the peer acks whatever it buffers, so sending
+// further ahead than it can buffer would get messages acked that it had to drop
+constexpr auto MAX_RELIABLE_MESSAGES_IN_FLIGHT = MAX_BUFFERED_RELIABLE_MESSAGES;
+constexpr auto MIN_RESEND_TIMEOUT = 0.05f; // seconds
+constexpr auto MAX_RESEND_TIMEOUT = 2.0f;  // seconds
+constexpr auto CONNECTION_TIMEOUT = 10.0;  // seconds a reliable message or handshake can go unanswered before the peer is given up on
+
+// Datagram sequence numbers and message ids are 16 bits and wrap around.
+const bool SequenceGreaterThan(const unsigned short l, const unsigned short r);
+
+struct OutgoingMessage
+{
+	Packet* packet;
+	Channel channel;
+};
+
+struct ReliableMessage
+{
+	Packet* packet;
+	unsigned short messageId;
+	double lastSendTime; // negative until the message has been sent once
+	double firstSendTime;
+	bool acked;
+	int fragmentOffset;
+	int fragmentLength;
+	unsigned char fragmentIndex;
+	unsigned char fragmentCount; // 1 for messages that weren't split
+};
+
+struct MessageHeader
+{
+	Channel channel{ Channel::Unreliable };
+	unsigned short messageId{ 0 };
+	unsigned char fragmentIndex{ 0 };
+	unsigned char fragmentCount{ 1 };
+	bool compressed{ false };
+};
+
+struct BufferedReliableMessage
+{
+	MessageHeader header;
+	std::vector<char> data;
+};
+
+struct SentDatagram
+{
+	unsigned short sequence{ 0 };
+	bool valid{ false };
+	bool acked{ false };
+	double sendTime{ 0.0 };
+	std::vector<unsigned short> reliableMessageIds;
+};
+
+// Transport state for one remote endpoint: messages waiting for the next flush, reliable messages
+// that haven't been acknowledged yet, and the sequence/ack bookkeeping for both directions.
+// Reliable message ids start at 0 for each pair of salts, so both ends always agree where a stream starts.
+// Once the remote salt is known, only a handshake Response can change it.
+class Connection
+{
+	// sending
+	unsigned short localSequence{ 0 };
+	unsigned short nextReliableMessageId{ 0 };
+	SentDatagram sentDatagrams[SENT_DATAGRAM_BUFFER_SIZE];
+	float smoothedRtt{ 0.0f };
+	float rttVariance{ 0.0f };
+	bool hasRttSample{ false };
+
+	// receiving
+	unsigned short remoteSalt{ 0 };
+	bool hasRemoteSalt{ false };
+	unsigned short remoteSequence{ 0 };
+	unsigned int receivedBits{ 0 };
+	bool receivedAnyDatagram{ false };
+	unsigned short nextExpectedReliableMessageId{ 0 };
+	std::vector<char> reassemblyBuffer;
+	unsigned char reassemblyFragmentCount{ 0 };
+	unsigned char nextFragmentIndex{ 0 };
+
+	void AckDatagram(const unsigned short sequence, const double now);
+	void ResetReceiveState();
+	void ResetSendState();
+public:
+	sockaddr_in address;
+	unsigned short salt{ 0 };
+	bool ackPending{ false };
+	bool peerSupportsCompression{ false };
+	bool compressionEnabled{ true }; // off for links where CPU matters more than bytes, e.g. loopback
+	bool closing{ false };
+	bool connected{ false };         // the handshake is done, or the peer proved it had done it by sending data
+	double lastHandshakeTime{ -1.0 }; // when we last sent a handshake request, negative if never
+	double firstHandshakeTime{ -1.0 };
+	int datagramsReceived{ 0 }; // inbound counters since the last SocketManager::ResetNetworkStats
+	int messagesReceived{ 0 };
+	__int64 bytesReceived{ 0 };
+	double statsStartTime{ 0.0 };
+	std::vector<OutgoingMessage> outgoingMessages;
+	std::deque<ReliableMessage> reliableMessages;
+	std::map<unsigned short, BufferedReliableMessage> bufferedReliableMessages;
+
+	void Queue(Packet& packet, const Channel channel);
+	void ReleasePackets();
+
+	const unsigned short NextSequence();
+	void OnDatagramSent(const unsigned short sequence, const double sendTime, const std::vector<unsigned short>& reliableMessageIds);
+	void ProcessAcks(const unsigned short ack, const unsigned int ackBits, const double now);
+	const bool HasAck() const;
+	const unsigned short GetAck() const;
+	const unsigned short GetRemoteSalt() const;
+	const unsigned int GetAckBits() const;
+	const float GetResendTimeout() const;
+	const float GetRtt() const;
+	const bool HasTimedOut(const double now) const;
+
+	void SetRemoteSalt(const unsigned short remoteSalt);
+	const bool MatchesRemoteSalt(const unsigned short remoteSalt) const;
+	const bool OnDatagramReceived(const unsigned short sequence);
+	const bool IsNextReliableMessage(const unsigned short messageId) const;
+	const bool IsFutureReliableMessage(const unsigned short messageId) const;
+	void AdvanceReliableMessageId();
+	const unsigned short GetNextExpectedReliableMessageId() const;
+
+	const bool AddFragment(const unsigned char fragmentIndex, const unsigned char fragmentCount, const char* data, const int length);
+	const std::vector<char>& GetReassembledMessage() const;
+};
\ No newline at end of file
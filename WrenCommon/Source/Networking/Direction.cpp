@@ -0,0 +1,23 @@
+#include "stdafx.h"
+#include "Direction.h"
+
+static const XMFLOAT3 DIRECTIONS[DIRECTION_COUNT]
+{
+	VEC_ZERO, VEC_SOUTHWEST, VEC_SOUTH, VEC_SOUTHEAST, VEC_EAST, VEC_NORTHEAST, VEC_NORTH, VEC_NORTHWEST, VEC_WEST
+};
+
+const int Direction::ToIndex(const XMFLOAT3& direction)
+{
+	for (auto i = 0; i < DIRECTION_COUNT; i++)
+	{
+		if (DIRECTIONS[i] == direction)
+			return i;
+	}
+
+	return DIRECTION_ESCAPE;
+}
+
+const XMFLOAT3 Direction::FromIndex(const int index)
+{
+	return DIRECTIONS[index];
+}
\ No newline at end of file
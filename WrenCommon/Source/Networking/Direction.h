@@ -0,0 +1,15 @@
+#pragma once
+
+#include <Constants.h>
+
+constexpr auto DIRECTION_BITS = 4;
+constexpr auto DIRECTION_COUNT = 9;    // VEC_ZERO plus the eight compass directions
+constexpr auto DIRECTION_ESCAPE = 15;  // followed by the raw vector
+
+// Maps the VEC_* movement vectors to small indices for the wire.
+class Direction
+{
+public:
+	static const int ToIndex(const XMFLOAT3& direction);
+	static const XMFLOAT3 FromIndex(const int index);
+};
\ No newline at end of file
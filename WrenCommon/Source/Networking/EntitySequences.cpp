@@ -0,0 +1,19 @@
+#include "stdafx.h"
+#include "EntitySequences.h"
+#include "Connection.h"
+
+const bool EntitySequences::Accept(const OpCode opCode, const int entityId, const unsigned short sequence, const double now)
+{
+	const auto key = static_cast<unsigned __int64>(opCode) << 32 | static_cast<unsigned int>(entityId);
+	const auto it = lastUpdates.find(key);
+	if (it != lastUpdates.end() && now - it->second.time < ENTITY_SEQUENCE_TIMEOUT && !SequenceGreaterThan(sequence, it->second.sequence))
+		return false;
+
+	lastUpdates[key] = LastUpdate{ sequence, now };
+	return true;
+}
+
+void EntitySequences::Clear()
+{
+	lastUpdates.clear();
+}
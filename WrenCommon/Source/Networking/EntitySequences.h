@@ -0,0 +1,24 @@
+#pragma once
+
+#include <OpCodes.h>
+
+constexpr auto ENTITY_SEQUENCE_TIMEOUT = 1.0; // seconds without an update before an entity's next one is taken whatever its sequence
+
+// The newest sequence received for each entity's updates, per OpCode. Entity updates share a Connection
+// but go unreliable, so an update that was overtaken by a newer one for the same entity is stale and
+// dropped, without affecting any other entity. An entity that hasn't been heard from for a while may
+// have been replaced, e.g. by the same player logging back in, so its sequence starts over.
+class EntitySequences
+{
+	struct LastUpdate
+	{
+		unsigned short sequence;
+		double time;
+	};
+
+	std::map<unsigned __int64, LastUpdate> lastUpdates;
+
+public:
+	const bool Accept(const OpCode opCode, const int entityId, const unsigned short sequence, const double now);
+	void Clear();
+};
@@ -0,0 +1,74 @@
+#include "stdafx.h"
+#include "EntityState.h"
+
+constexpr auto MAP_MAX_X = TILE_SIZE * MAP_WIDTH;
+constexpr auto MAP_MAX_Z = TILE_SIZE * MAP_HEIGHT;
+
+void EntityState::Write(BitWriter& writer, const bool isPlayer) const
+{
+	writer.WriteBits(sequence, 16);
+	writer.WriteBits(static_cast<unsigned int>(id), 32);
+
+	writer.WriteQuantizedFloat(position.x, 0.0f, MAP_MAX_X, POSITION_BITS);
+	writer.WriteQuantizedFloat(position.z, 0.0f, MAP_MAX_Z, POSITION_BITS);
+	// everything currently lives on the ground plane, so y is nearly always zero
+	writer.WriteBool(position.y != 0.0f);
+	if (position.y != 0.0f)
+		writer.WriteFloat(position.y);
+
+	writer.WriteDirection(movementVector);
+
+	if (isPlayer)
+	{
+		writer.WriteRangedInt(modelId, 0, MAX_ASSET_ID);
+		writer.WriteRangedInt(textureId, 0, MAX_ASSET_ID);
+		writer.WriteString(name);
+	}
+
+	writer.WriteRangedInt(agility, 0, MAX_ATTRIBUTE_VALUE);
+	writer.WriteRangedInt(strength, 0, MAX_ATTRIBUTE_VALUE);
+	writer.WriteRangedInt(wisdom, 0, MAX_ATTRIBUTE_VALUE);
+	writer.WriteRangedInt(intelligence, 0, MAX_ATTRIBUTE_VALUE);
+	writer.WriteRangedInt(charisma, 0, MAX_ATTRIBUTE_VALUE);
+	writer.WriteRangedInt(luck, 0, MAX_ATTRIBUTE_VALUE);
+	writer.WriteRangedInt(endurance, 0, MAX_ATTRIBUTE_VALUE);
+	writer.WriteRangedInt(health, 0, MAX_VITAL_VALUE);
+	writer.WriteRangedInt(maxHealth, 0, MAX_VITAL_VALUE);
+	writer.WriteRangedInt(mana, 0, MAX_VITAL_VALUE);
+	writer.WriteRangedInt(maxMana, 0, MAX_VITAL_VALUE);
+	writer.WriteRangedInt(stamina, 0, MAX_VITAL_VALUE);
+	writer.WriteRangedInt(maxStamina, 0, MAX_VITAL_VALUE);
+}
+
+void EntityState::Read(BitReader& reader, const bool isPlayer)
+{
+	sequence = static_cast<unsigned short>(reader.ReadBits(16));
+	id = static_cast<int>(reader.ReadBits(32));
+
+	position.x = reader.ReadQuantizedFloat(0.0f, MAP_MAX_X, POSITION_BITS);
+	position.z = reader.ReadQuantizedFloat(0.0f, MAP_MAX_Z, POSITION_BITS);
+	position.y = reader.ReadBool() ? reader.ReadFloat() : 0.0f;
+
+	movementVector = reader.ReadDirection();
+
+	if (isPlayer)
+	{
+		modelId = reader.ReadRangedInt(0, MAX_ASSET_ID);
+		textureId = reader.ReadRangedInt(0, MAX_ASSET_ID);
+		name = reader.ReadString();
+	}
+
+	agility = reader.ReadRangedInt(0, MAX_ATTRIBUTE_VALUE);
+	strength = reader.ReadRangedInt(0, MAX_ATTRIBUTE_VALUE);
+	wisdom = reader.ReadRangedInt(0, MAX_ATTRIBUTE_VALUE);
+	intelligence = reader.ReadRangedInt(0, MAX_ATTRIBUTE_VALUE);
+	charisma = reader.ReadRangedInt(0, MAX_ATTRIBUTE_VALUE);
+	luck = reader.ReadRangedInt(0, MAX_ATTRIBUTE_VALUE);
+	endurance = reader.ReadRangedInt(0, MAX_ATTRIBUTE_VALUE);
+	health = reader.ReadRangedInt(0, MAX_VITAL_VALUE);
+	maxHealth = reader.ReadRangedInt(0, MAX_VITAL_VALUE);
+	mana = reader.ReadRangedInt(0, MAX_VITAL_VALUE);
+	maxMana = reader.ReadRangedInt(0, MAX_VITAL_VALUE);
+	stamina = reader.ReadRangedInt(0, MAX_VITAL_VALUE);
+	maxStamina = reader.ReadRangedInt(0, MAX_VITAL_VALUE);
+}
\ No newline at end of file
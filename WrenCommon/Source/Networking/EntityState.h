@@ -0,0 +1,43 @@
+#pragma once
+
+#include <Constants.h>
+#include "BitWriter.h"
+#include "BitReader.h"
+
+constexpr auto POSITION_BITS = 17;        // ~0.02 units over the whole map
+constexpr auto MAX_ATTRIBUTE_VALUE = 1023; // agility, strength, etc.
+constexpr auto MAX_VITAL_VALUE = 65535;    // health, mana, stamina and their maximums
+constexpr auto MAX_ASSET_ID = 65535;       // model and texture ids
+
+// Replicated state of an Npc or Player, as sent in NpcUpdate and PlayerUpdate. Positions are
+// quantized to the map bounds, movement vectors are direction-coded and stats are range-limited,
+// which brings an update from ~150 bytes of text down to ~30 bytes. The sequence counts this
+// entity's updates, so the receiver can drop one that arrives after a newer one.
+struct EntityState
+{
+	unsigned short sequence{ 0 };
+	int id{ 0 };
+	XMFLOAT3 position{ VEC_ZERO };
+	XMFLOAT3 movementVector{ VEC_ZERO };
+	int agility{ 0 };
+	int strength{ 0 };
+	int wisdom{ 0 };
+	int intelligence{ 0 };
+	int charisma{ 0 };
+	int luck{ 0 };
+	int endurance{ 0 };
+	int health{ 0 };
+	int maxHealth{ 0 };
+	int mana{ 0 };
+	int maxMana{ 0 };
+	int stamina{ 0 };
+	int maxStamina{ 0 };
+
+	// players only
+	int modelId{ 0 };
+	int textureId{ 0 };
+	std::string name{ "" };
+
+	void Write(BitWriter& writer, const bool isPlayer) const;
+	void Read(BitReader& reader, const bool isPlayer);
+};
\ No newline at end of file
@@ -0,0 +1,73 @@
+#include "stdafx.h"
+#include "Handshake.h"
+
+namespace
+{
+	inline unsigned __int64 RotateLeft(const unsigned __int64 value, const int bits)
+	{
+		return (value << bits) | (value >> (64 - bits));
+	}
+
+	inline void SipRound(unsigned __int64& v0, unsigned __int64& v1, unsigned __int64& v2, unsigned __int64& v3)
+	{
+		v0 += v1; v1 = RotateLeft(v1, 13); v1 ^= v0; v0 = RotateLeft(v0, 32);
+		v2 += v3; v3 = RotateLeft(v3, 16); v3 ^= v2;
+		v0 += v3; v3 = RotateLeft(v3, 21); v3 ^= v0;
+		v2 += v1; v1 = RotateLeft(v1, 17); v1 ^= v2; v2 = RotateLeft(v2, 32);
+	}
+
+	// SipHash-2-4 of a message that's a whole number of 64 bit little endian words.
+	const unsigned __int64 SipHash(const unsigned __int64 key0, const unsigned __int64 key1, const unsigned __int64* words, const int wordCount)
+	{
+		auto v0 = key0 ^ 0x736f6d6570736575ull;
+		auto v1 = key1 ^ 0x646f72616e646f6dull;
+		auto v2 = key0 ^ 0x6c7967656e657261ull;
+		auto v3 = key1 ^ 0x7465646279746573ull;
+
+		for (auto i = 0; i < wordCount; i++)
+		{
+			v3 ^= words[i];
+			SipRound(v0, v1, v2, v3);
+			SipRound(v0, v1, v2, v3);
+			v0 ^= words[i];
+		}
+
+		const auto lastWord = static_cast<unsigned __int64>(wordCount * 8) << 56;
+		v3 ^= lastWord;
+		SipRound(v0, v1, v2, v3);
+		SipRound(v0, v1, v2, v3);
+		v0 ^= lastWord;
+
+		v2 ^= 0xff;
+		for (auto i = 0; i < 4; i++)
+			SipRound(v0, v1, v2, v3);
+		return v0 ^ v1 ^ v2 ^ v3;
+	}
+}
+
+void HandshakeCookies::SetKey(const unsigned __int64 key0, const unsigned __int64 key1)
+{
+	this->key0 = key0;
+	this->key1 = key1;
+}
+
+const unsigned __int64 HandshakeCookies::Create(const sockaddr_in& address, const unsigned int timestamp) const
+{
+	unsigned int ip{ 0 };
+	memcpy(&ip, &address.sin_addr, sizeof(ip));
+	const unsigned __int64 words[2]
+	{
+		static_cast<unsigned __int64>(ip) | static_cast<unsigned __int64>(address.sin_port) << 32,
+		timestamp
+	};
+	return SipHash(key0, key1, words, 2);
+}
+
+// Cookies from the future are rejected too, since the timestamp is only trusted once the MAC matches.
+const bool HandshakeCookies::Verify(const sockaddr_in& address, const unsigned int timestamp, const unsigned __int64 cookie, const unsigned int now) const
+{
+	if (timestamp > now || now - timestamp > COOKIE_LIFETIME)
+		return false;
+
+	return Create(address, timestamp) == cookie;
+}
\ No newline at end of file
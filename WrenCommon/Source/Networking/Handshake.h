@@ -0,0 +1,31 @@
+#pragma once
+
+#include <OpCodes.h>
+
+// Handshake datagrams start with this in place of the usual checksum: checksum, type, timestamp, cookie, salt.
+// Requests are padded to the size of the challenge they get back, so spoofing them can't be used to
+// amplify traffic at someone else's address.
+constexpr auto HANDSHAKE_CHECKSUM = static_cast<int>(OpCode::Checksum) + 1;
+constexpr auto HANDSHAKE_DATAGRAM_SIZE = static_cast<int>(sizeof(int) + sizeof(unsigned char) + sizeof(unsigned int) + sizeof(unsigned __int64) + sizeof(unsigned short));
+constexpr auto HANDSHAKE_RESEND_INTERVAL = 0.25; // seconds between requests while waiting for a challenge
+constexpr auto COOKIE_LIFETIME = 10u;            // seconds a challenge can still be answered
+
+enum class HandshakeType : unsigned char
+{
+	Request,   // to an endpoint we have messages for, but haven't heard a challenge from
+	Challenge, // carries a cookie for the requester's endpoint; the challenger stores nothing
+	Response   // the cookie echoed back with the responder's salt, after which the challenger creates a Connection
+};
+
+// A keyed MAC (SipHash-2-4) over an endpoint and the second it was issued. Echoing one back proves the
+// peer receives datagrams at the address it sends from, without the challenger having kept any state.
+class HandshakeCookies
+{
+	unsigned __int64 key0{ 0 };
+	unsigned __int64 key1{ 0 };
+
+public:
+	void SetKey(const unsigned __int64 key0, const unsigned __int64 key1);
+	const unsigned __int64 Create(const sockaddr_in& address, const unsigned int timestamp) const;
+	const bool Verify(const sockaddr_in& address, const unsigned int timestamp, const unsigned __int64 cookie, const unsigned int now) const;
+};
\ No newline at end of file
@@ -0,0 +1,148 @@
+#include "stdafx.h"
+#include "NetworkSimulator.h"
+#include <SocketManager.h>
+#include <Utility.h>
+
+const NetworkConditions ParseNetworkConditions(const std::string& text)
+{
+	NetworkConditions conditions;
+
+	size_t start = 0;
+	while (start < text.length())
+	{
+		auto end = text.find(',', start);
+		if (end == std::string::npos)
+			end = text.length();
+
+		const auto entry = text.substr(start, end - start);
+		const auto separator = entry.find('=');
+		if (separator == std::string::npos)
+			throw std::exception("Expected network conditions as name=value,name=value,...");
+
+		const auto name = entry.substr(0, separator);
+		const auto value = std::stod(entry.substr(separator + 1));
+		if (name == "latency")
+			conditions.latency = value / 1000.0;
+		else if (name == "jitter")
+			conditions.jitter = value / 1000.0;
+		else if (name == "loss")
+			conditions.lossRate = value / 100.0;
+		else if (name == "duplicate")
+			conditions.duplicateRate = value / 100.0;
+		else if (name == "reorder")
+			conditions.reorderRate = value / 100.0;
+		else if (name == "reorderdelay")
+			conditions.reorderDelay = value / 1000.0;
+		else if (name == "bandwidth")
+			conditions.bandwidth = static_cast<int>(value);
+		else
+			throw std::exception("Unknown network condition.");
+
+		start = end + 1;
+	}
+	return conditions;
+}
+
+const bool NetworkSimulator::LaterRelease::operator()(const SimulatedDatagram& l, const SimulatedDatagram& r) const
+{
+	return l.releaseTime != r.releaseTime ? l.releaseTime > r.releaseTime : l.order > r.order;
+}
+
+NetworkSimulator::NetworkSimulator(const unsigned int seed)
+	: rng{ seed }
+{
+}
+
+void NetworkSimulator::SetConditions(const NetworkConditions& conditions) { defaultConditions = conditions; }
+
+// Overrides the default conditions for one endpoint.
+void NetworkSimulator::SetConditions(const sockaddr_in& address, const NetworkConditions& conditions)
+{
+	endpointConditions[SocketManager::GetEndpointKey(address)] = conditions;
+}
+
+void NetworkSimulator::ClearConditions(const sockaddr_in& address)
+{
+	endpointConditions.erase(SocketManager::GetEndpointKey(address));
+}
+
+const NetworkConditions& NetworkSimulator::GetConditions() const { return defaultConditions; }
+
+const NetworkConditions& NetworkSimulator::GetConditions(const unsigned __int64 endpointKey) const
+{
+	const auto it = endpointConditions.find(endpointKey);
+	return it != endpointConditions.end() ? it->second : defaultConditions;
+}
+
+// Copies the datagram, since the buffers it's gathered from are reused as soon as this returns.
+void NetworkSimulator::Submit(const SimulatedDirection direction, const sockaddr_in& address, const WSABUF* buffers, const int bufferCount, const double now)
+{
+	const auto endpointKey = SocketManager::GetEndpointKey(address);
+	const NetworkConditions& conditions = GetConditions(endpointKey);
+
+	if (chance(rng) < conditions.lossRate)
+	{
+		stats.datagramsLost++;
+		return;
+	}
+
+	std::vector<char> data;
+	for (auto i = 0; i < bufferCount; i++)
+		data.insert(data.end(), buffers[i].buf, buffers[i].buf + buffers[i].len);
+
+	if (chance(rng) < conditions.duplicateRate)
+	{
+		stats.datagramsDuplicated++;
+		Schedule(direction, endpointKey, conditions, address, data, now);
+	}
+	Schedule(direction, endpointKey, conditions, address, std::move(data), now);
+}
+
+// A bandwidth-capped link sends one datagram after another, so each one waits for the backlog
+// ahead of it before its latency even starts.
+void NetworkSimulator::Schedule(const SimulatedDirection direction, const unsigned __int64 endpointKey, const NetworkConditions& conditions, const sockaddr_in& address, std::vector<char> data, const double now)
+{
+	auto departureTime = now;
+	if (conditions.bandwidth > 0)
+	{
+		double& linkFreeTime = linkFreeTimes[static_cast<int>(direction)][endpointKey];
+		departureTime = Utility::Max<double>(now, linkFreeTime) + static_cast<double>(data.size()) / conditions.bandwidth;
+		if (departureTime - now > MAX_SIMULATED_QUEUE_DELAY)
+		{
+			stats.datagramsOverCapacity++;
+			return;
+		}
+		linkFreeTime = departureTime;
+	}
+
+	auto releaseTime = departureTime + conditions.latency + chance(rng) * conditions.jitter;
+	if (chance(rng) < conditions.reorderRate)
+	{
+		stats.datagramsReordered++;
+		releaseTime += conditions.reorderDelay;
+	}
+
+	datagrams.push(SimulatedDatagram{ releaseTime, nextOrder++, direction, address, std::move(data) });
+}
+
+// Pops the next datagram that is due by now, in release order; returns false once none are.
+const bool NetworkSimulator::Release(const double now, SimulatedDatagram& datagram)
+{
+	if (datagrams.empty() || datagrams.top().releaseTime > now)
+		return false;
+
+	// the queue only hands out const references, but the datagram is popped straight away
+	datagram = std::move(const_cast<SimulatedDatagram&>(datagrams.top()));
+	datagrams.pop();
+	return true;
+}
+
+// When the next held datagram is due, or the largest double if nothing is held.
+const double NetworkSimulator::GetNextReleaseTime() const
+{
+	return datagrams.empty() ? std::numeric_limits<double>::max() : datagrams.top().releaseTime;
+}
+
+const NetworkSimulatorStats& NetworkSimulator::GetStats() const { return stats; }
+
+void NetworkSimulator::ResetStats() { stats = NetworkSimulatorStats{}; }
\ No newline at end of file
@@ -0,0 +1,77 @@
+#pragma once
+
+constexpr auto MAX_SIMULATED_QUEUE_DELAY = 1.0; // seconds of backlog a bandwidth-capped link holds before it drops datagrams
+
+// How bad the simulated link to an endpoint is. Applied separately to each direction, so the
+// round trip sees twice the latency.
+struct NetworkConditions
+{
+	double latency{ 0.0 };       // seconds, one way
+	double jitter{ 0.0 };        // seconds, up to this much extra delay per datagram
+	double lossRate{ 0.0 };      // 0 to 1
+	double duplicateRate{ 0.0 }; // 0 to 1
+	double reorderRate{ 0.0 };   // 0 to 1, chance a datagram is held back by reorderDelay
+	double reorderDelay{ 0.05 }; // seconds
+	int bandwidth{ 0 };          // bytes per second, 0 for unlimited
+};
+
+// Parses e.g. "latency=100,jitter=20,loss=2,duplicate=1,reorder=5,bandwidth=64000",
+// with times in milliseconds, rates in percent and bandwidth in bytes per second.
+const NetworkConditions ParseNetworkConditions(const std::string& text);
+
+enum class SimulatedDirection : unsigned char
+{
+	Outbound,
+	Inbound
+};
+
+struct SimulatedDatagram
+{
+	double releaseTime;
+	unsigned __int64 order; // keeps datagrams released at the same time in submission order
+	SimulatedDirection direction;
+	sockaddr_in address;
+	std::vector<char> data;
+};
+
+struct NetworkSimulatorStats
+{
+	int datagramsLost{ 0 };
+	int datagramsOverCapacity{ 0 }; // dropped because a bandwidth-capped link's queue was full
+	int datagramsDuplicated{ 0 };
+	int datagramsReordered{ 0 };
+};
+
+// Holds datagrams back according to the NetworkConditions of their endpoint, so netcode can be
+// tested against a bad network on a single machine. All randomness comes from one seeded engine:
+// the same datagrams submitted at the same times come out the same way.
+class NetworkSimulator
+{
+	struct LaterRelease
+	{
+		const bool operator()(const SimulatedDatagram& l, const SimulatedDatagram& r) const;
+	};
+
+	NetworkConditions defaultConditions;
+	std::map<unsigned __int64, NetworkConditions> endpointConditions;
+	std::map<unsigned __int64, double> linkFreeTimes[2]; // when each direction of each link is done sending its backlog
+	std::priority_queue<SimulatedDatagram, std::vector<SimulatedDatagram>, LaterRelease> datagrams;
+	std::mt19937 rng;
+	std::uniform_real_distribution<double> chance{ 0.0, 1.0 };
+	unsigned __int64 nextOrder{ 0 };
+	NetworkSimulatorStats stats;
+
+	const NetworkConditions& GetConditions(const unsigned __int64 endpointKey) const;
+	void Schedule(const SimulatedDirection direction, const unsigned __int64 endpointKey, const NetworkConditions& conditions, const sockaddr_in& address, std::vector<char> data, const double now);
+public:
+	NetworkSimulator(const unsigned int seed);
+	void SetConditions(const NetworkConditions& conditions);
+	void SetConditions(const sockaddr_in& address, const NetworkConditions& conditions);
+	void ClearConditions(const sockaddr_in& address);
+	const NetworkConditions& GetConditions() const;
+	void Submit(const SimulatedDirection direction, const sockaddr_in& address, const WSABUF* buffers, const int bufferCount, const double now);
+	const bool Release(const double now, SimulatedDatagram& datagram);
+	const double GetNextReleaseTime() const;
+	const NetworkSimulatorStats& GetStats() const;
+	void ResetStats();
+};
\ No newline at end of file
@@ -0,0 +1,119 @@
+#include "stdafx.h"
+#include "Packet.h"
+#include "PacketPool.h"
+#include <Utility.h>
+#include "Compression.h"
+
+Packet::Packet()
+	: buffer(PACKET_SIZE)
+{
+}
+
+void Packet::Append(const char* data, const int dataLength)
+{
+	if (length + dataLength > MAX_MESSAGE_SIZE)
+		throw std::exception("Packet size exceeded.");
+
+	// pooled packets keep whatever capacity they grew to, so this only allocates for the first few large messages
+	if (length + dataLength > static_cast<int>(buffer.size()))
+		buffer.resize(Utility::Max<int>(length + dataLength, static_cast<int>(buffer.size()) * 2));
+
+	memcpy(buffer.data() + length, data, dataLength);
+	length += dataLength;
+}
+
+Packet& Packet::Begin(const OpCode opCode)
+{
+	if (compressedPacket)
+		compressedPacket->Release();
+	compressedPacket = nullptr;
+	compressionAttempted = false;
+	compressed = false;
+	length = 0;
+	Append(reinterpret_cast<const char*>(&opCode), sizeof(OpCode));
+	return *this;
+}
+
+Packet& Packet::Write(const std::string& arg)
+{
+	Append(arg.c_str(), static_cast<int>(arg.length()));
+	Append("|", 1);
+	return *this;
+}
+
+Packet& Packet::Write(const char* arg)
+{
+	Append(arg, static_cast<int>(strlen(arg)));
+	Append("|", 1);
+	return *this;
+}
+
+Packet& Packet::Write(const int arg)
+{
+	return Write(std::to_string(arg));
+}
+
+Packet& Packet::Write(const float arg)
+{
+	return Write(std::to_string(arg));
+}
+
+// Appends the raw bits with no delimiter; the whole message must then be read with a BitReader.
+Packet& Packet::Write(const BitWriter& writer)
+{
+	Append(writer.GetData(), writer.GetLength());
+	return *this;
+}
+
+// Appends raw bytes with no delimiter, e.g. another encoded message that's being forwarded whole.
+Packet& Packet::Write(const char* data, const int dataLength)
+{
+	Append(data, dataLength);
+	return *this;
+}
+
+void Packet::AddRef()
+{
+	refCount++;
+}
+
+void Packet::Release()
+{
+	if (--refCount > 0)
+		return;
+
+	if (compressedPacket)
+		compressedPacket->Release();
+	pool->Return(*this);
+}
+
+const OpCode Packet::GetOpCode() const
+{
+	OpCode opCode{ };
+	memcpy(&opCode, buffer.data(), sizeof(OpCode));
+	return opCode;
+}
+
+const char* Packet::GetData() const { return buffer.data(); }
+
+const int Packet::GetLength() const { return length; }
+
+const bool Packet::IsCompressed() const { return compressed; }
+
+// Fills this Packet with the uncompressed length followed by the compressed payload of source.
+// Returns false if that wouldn't be any smaller than sending source as is.
+const bool Packet::CompressFrom(const Packet& source)
+{
+	const auto capacity = static_cast<int>(sizeof(int)) + Compression::GetMaxCompressedSize(source.length);
+	if (static_cast<int>(buffer.size()) < capacity)
+		buffer.resize(capacity);
+
+	memcpy(buffer.data(), &source.length, sizeof(int));
+	const auto compressedLength = Compression::Compress(source.buffer.data(), source.length, buffer.data() + sizeof(int), capacity - sizeof(int));
+	if (compressedLength == 0 || static_cast<int>(sizeof(int)) + compressedLength >= source.length)
+		return false;
+
+	length = static_cast<int>(sizeof(int)) + compressedLength;
+	compressed = true;
+	return true;
+}
\ No newline at end of file
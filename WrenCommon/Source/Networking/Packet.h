@@ -0,0 +1,43 @@
+#pragma once
+
+#include <OpCodes.h>
+#include <Constants.h>
+
+#include "BitWriter.h"
+
+class PacketPool;
+
+// Encoded message payload (OpCode followed by '|' delimited args). A Packet is encoded once
+// and can be sent to any number of endpoints; it goes back to its PacketPool when the last
+// reference is released. The buffer grows past PACKET_SIZE as needed, up to MAX_MESSAGE_SIZE.
+class Packet
+{
+	std::vector<char> buffer;
+	int length{ 0 };
+	int refCount{ 0 };
+	PacketPool* pool{ nullptr };
+	bool compressed{ false };
+	bool compressionAttempted{ false };
+	Packet* compressedPacket{ nullptr };
+
+	void Append(const char* data, const int dataLength);
+
+	friend class PacketPool;
+	friend class SocketManager;
+public:
+	Packet();
+	Packet& Begin(const OpCode opCode);
+	Packet& Write(const std::string& arg);
+	Packet& Write(const char* arg);
+	Packet& Write(const int arg);
+	Packet& Write(const float arg);
+	Packet& Write(const BitWriter& writer);
+	Packet& Write(const char* data, const int dataLength);
+	void AddRef();
+	void Release();
+	const OpCode GetOpCode() const;
+	const char* GetData() const;
+	const int GetLength() const;
+	const bool IsCompressed() const;
+	const bool CompressFrom(const Packet& source);
+};
\ No newline at end of file
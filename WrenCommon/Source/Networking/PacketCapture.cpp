@@ -0,0 +1,86 @@
+#include "stdafx.h"
+#include "PacketCapture.h"
+
+constexpr unsigned __int64 FNV_PRIME = 1099511628211ull;
+
+PacketCaptureWriter::PacketCaptureWriter(const std::string& path, const unsigned int seed)
+	: file{ path, std::ios::binary | std::ios::trunc }
+{
+	if (!file)
+		throw std::exception("Failed to open packet capture for writing.");
+
+	WriteRaw(&PACKET_CAPTURE_MAGIC, sizeof(unsigned int));
+	WriteRaw(&PACKET_CAPTURE_VERSION, sizeof(unsigned int));
+	WriteRaw(&seed, sizeof(unsigned int));
+}
+
+void PacketCaptureWriter::WriteRaw(const void* data, const int length)
+{
+	const auto bytes = static_cast<const unsigned char*>(data);
+	for (auto i = 0; i < length; i++)
+		digest = (digest ^ bytes[i]) * FNV_PRIME;
+
+	file.write(static_cast<const char*>(data), length);
+}
+
+void PacketCaptureWriter::SetTick(const unsigned int tick) { this->tick = tick; }
+
+void PacketCaptureWriter::Write(const sockaddr_in& address, const char* data, const int length)
+{
+	WSABUF buffer;
+	buffer.buf = const_cast<CHAR*>(data);
+	buffer.len = length;
+	Write(address, &buffer, 1, length);
+}
+
+// Takes the same scattered buffers SocketManager hands to WSASendTo, so outgoing datagrams aren't copied first.
+void PacketCaptureWriter::Write(const sockaddr_in& address, const WSABUF* buffers, const int bufferCount, const int length)
+{
+	const auto datagramLength = static_cast<unsigned short>(length);
+	WriteRaw(&tick, sizeof(unsigned int));
+	WriteRaw(&address.sin_addr.s_addr, sizeof(address.sin_addr.s_addr));
+	WriteRaw(&address.sin_port, sizeof(address.sin_port));
+	WriteRaw(&datagramLength, sizeof(unsigned short));
+	for (auto i = 0; i < bufferCount; i++)
+		WriteRaw(buffers[i].buf, buffers[i].len);
+
+	datagramCount++;
+}
+
+const unsigned __int64 PacketCaptureWriter::GetDigest() const { return digest; }
+
+const int PacketCaptureWriter::GetDatagramCount() const { return datagramCount; }
+
+PacketCaptureReader::PacketCaptureReader(const std::string& path)
+	: file{ path, std::ios::binary }
+{
+	unsigned int magic{ 0 };
+	unsigned int version{ 0 };
+	file.read((char*)&magic, sizeof(unsigned int));
+	file.read((char*)&version, sizeof(unsigned int));
+	file.read((char*)&seed, sizeof(unsigned int));
+	if (!file || magic != PACKET_CAPTURE_MAGIC)
+		throw std::exception("Not a packet capture.");
+	if (version != PACKET_CAPTURE_VERSION)
+		throw std::exception("Unsupported packet capture version.");
+}
+
+// Returns false at the end of the capture, or at a record that was cut short.
+const bool PacketCaptureReader::Read(CapturedDatagram& datagram)
+{
+	unsigned short length{ 0 };
+	datagram.address = sockaddr_in{};
+	datagram.address.sin_family = AF_INET;
+	file.read((char*)&datagram.tick, sizeof(unsigned int));
+	file.read((char*)&datagram.address.sin_addr.s_addr, sizeof(datagram.address.sin_addr.s_addr));
+	file.read((char*)&datagram.address.sin_port, sizeof(datagram.address.sin_port));
+	file.read((char*)&length, sizeof(unsigned short));
+	if (!file || length > MAX_DATAGRAM_SIZE)
+		return false;
+
+	datagram.data.resize(length);
+	file.read(datagram.data.data(), length);
+	return static_cast<bool>(file);
+}
+
+const unsigned int PacketCaptureReader::GetSeed() const { return seed; }
\ No newline at end of file
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <Constants.h>
+
+constexpr unsigned int PACKET_CAPTURE_MAGIC = 0x5041434e; // "NCAP"
+constexpr unsigned int PACKET_CAPTURE_VERSION = 1;
+
+struct CapturedDatagram
+{
+	unsigned int tick{ 0 };
+	sockaddr_in address{};
+	std::vector<char> data;
+};
+
+// Binary log of datagrams, each tagged with the tick it was received (or sent) in and the remote
+// endpoint. The file starts with the magic, version and the RNG seed the recording was made with,
+// followed by one record per datagram: tick, IPv4 address, port, length and the raw bytes.
+class PacketCaptureWriter
+{
+	std::ofstream file;
+	unsigned int tick{ 0 };
+	unsigned __int64 digest{ 14695981039346656037ull }; // FNV-1a over every record
+	int datagramCount{ 0 };
+
+	void WriteRaw(const void* data, const int length);
+public:
+	PacketCaptureWriter(const std::string& path, const unsigned int seed);
+	void SetTick(const unsigned int tick);
+	void Write(const sockaddr_in& address, const char* data, const int length);
+	void Write(const sockaddr_in& address, const WSABUF* buffers, const int bufferCount, const int length);
+	const unsigned __int64 GetDigest() const;
+	const int GetDatagramCount() const;
+};
+
+class PacketCaptureReader
+{
+	std::ifstream file;
+	unsigned int seed{ 0 };
+
+public:
+	PacketCaptureReader(const std::string& path);
+	const bool Read(CapturedDatagram& datagram);
+	const unsigned int GetSeed() const;
+};
\ No newline at end of file
@@ -0,0 +1,44 @@
+#include "stdafx.h"
+#include "PacketPool.h"
+#include <Utility.h>
+
+PacketPool::PacketPool(const int initialSize)
+{
+	Grow(initialSize);
+}
+
+void PacketPool::Grow(const int count)
+{
+	for (auto i = 0; i < count; i++)
+	{
+		packets.push_back(std::make_unique<Packet>());
+		Packet* packet = packets.back().get();
+		packet->pool = this;
+		freePackets.push_back(packet);
+	}
+}
+
+// The returned Packet starts with a single reference owned by the caller.
+Packet& PacketPool::Acquire()
+{
+	if (freePackets.empty())
+		Grow(Utility::Max<int>(1, static_cast<int>(packets.size())));
+
+	Packet* packet = freePackets.back();
+	freePackets.pop_back();
+	packet->length = 0;
+	packet->refCount = 1;
+	packet->compressed = false;
+	packet->compressionAttempted = false;
+	packet->compressedPacket = nullptr;
+	return *packet;
+}
+
+void PacketPool::Return(Packet& packet)
+{
+	freePackets.push_back(&packet);
+}
+
+const int PacketPool::GetSize() const { return static_cast<int>(packets.size()); }
+
+const int PacketPool::GetFreeCount() const { return static_cast<int>(freePackets.size()); }
\ No newline at end of file
@@ -0,0 +1,19 @@
+#pragma once
+
+#include "Packet.h"
+
+// Recycles Packet buffers so the send path doesn't allocate. The pool grows when it runs dry
+// and never shrinks, so after warm-up every Acquire is a pop from the free list.
+class PacketPool
+{
+	std::vector<std::unique_ptr<Packet>> packets;
+	std::vector<Packet*> freePackets;
+
+	void Grow(const int count);
+public:
+	PacketPool(const int initialSize = 64);
+	Packet& Acquire();
+	void Return(Packet& packet);
+	const int GetSize() const;
+	const int GetFreeCount() const;
+};
\ No newline at end of file
@@ -0,0 +1,141 @@
+#include "stdafx.h"
+#include "RateLimiter.h"
+#include <Utility.h>
+
+const RateLimitClass GetRateLimitClass(const OpCode opCode)
+{
+	switch (opCode)
+	{
+		case OpCode::Connect:
+		case OpCode::CreateAccount:
+		case OpCode::CreateCharacter:
+		case OpCode::DeleteCharacter:
+		case OpCode::EnterWorld:
+			return RateLimitClass::Login;
+
+		case OpCode::SendChatMessage:
+			return RateLimitClass::Chat;
+
+		case OpCode::SetTarget:
+		case OpCode::UnsetTarget:
+		case OpCode::ActivateAbility:
+			return RateLimitClass::Targeting;
+
+		case OpCode::LootItem:
+		case OpCode::MoveItem:
+			return RateLimitClass::Items;
+
+		case OpCode::Ping:
+		case OpCode::Heartbeat:
+			return RateLimitClass::Ping;
+
+		// sent every tick while a player moves
+		case OpCode::PlayerInput:
+		case OpCode::PlayerUpdate:
+		case OpCode::PlayerRightMouseDown:
+		case OpCode::PlayerRightMouseUp:
+		case OpCode::PlayerRightMouseDirChange:
+			return RateLimitClass::Input;
+
+		default:
+			return RateLimitClass::Count;
+	}
+}
+
+const RateLimits ParseRateLimits(const std::string& text)
+{
+	static const std::string classNames[static_cast<int>(RateLimitClass::Count)]{ "login", "chat", "targeting", "items", "ping", "input" };
+
+	RateLimits rateLimits;
+
+	size_t start = 0;
+	while (start < text.length())
+	{
+		auto end = text.find(',', start);
+		if (end == std::string::npos)
+			end = text.length();
+
+		const auto entry = text.substr(start, end - start);
+		const auto separator = entry.find('=');
+		const auto burstSeparator = entry.find(':');
+		if (separator == std::string::npos || burstSeparator == std::string::npos || burstSeparator < separator)
+			throw std::exception("Expected rate limits as class=rate:burst,class=rate:burst,...");
+
+		const auto className = entry.substr(0, separator);
+		const auto classIt = std::find(std::begin(classNames), std::end(classNames), className);
+		if (classIt == std::end(classNames))
+			throw std::exception("Unknown rate limit class.");
+
+		RateLimit& limit = rateLimits.limits[classIt - std::begin(classNames)];
+		limit.rate = std::stod(entry.substr(separator + 1, burstSeparator - separator - 1));
+		limit.burst = Utility::Max<double>(std::stod(entry.substr(burstSeparator + 1)), 1.0);
+
+		start = end + 1;
+	}
+	return rateLimits;
+}
+
+const bool TokenBucket::Take(const RateLimit& limit, const double now)
+{
+	tokens = Utility::Min<double>(tokens + (now - updateTime) * limit.rate, limit.burst);
+	updateTime = now;
+	if (tokens < 1.0)
+		return false;
+
+	tokens -= 1.0;
+	return true;
+}
+
+void RateLimiter::SetLimits(const RateLimits& limits)
+{
+	this->limits = limits;
+	enabled = std::any_of(std::begin(limits.limits), std::end(limits.limits), [](const RateLimit& limit) { return limit.rate > 0.0; });
+	sessions.clear();
+}
+
+// Takes a token from the session's bucket for the OpCode's class, if there's one to take.
+const bool RateLimiter::Allow(const unsigned __int64 sessionKey, const OpCode opCode, const double now)
+{
+	if (!enabled)
+		return true;
+
+	const auto rateLimitClass = GetRateLimitClass(opCode);
+	if (rateLimitClass == RateLimitClass::Count)
+		return true;
+
+	const RateLimit& limit = limits.limits[static_cast<int>(rateLimitClass)];
+	if (limit.rate <= 0.0)
+		return true;
+
+	auto it = sessions.find(sessionKey);
+	if (it == sessions.end())
+	{
+		it = sessions.emplace(sessionKey, Session{}).first;
+		for (auto i = 0; i < static_cast<int>(RateLimitClass::Count); i++)
+			it->second.buckets[i] = TokenBucket{ limits.limits[i].burst, now };
+	}
+
+	Session& session = it->second;
+	TokenBucket& bucket = session.buckets[static_cast<int>(rateLimitClass)];
+	if (!bucket.Take(limit, now))
+		return false;
+
+	session.fullTime = Utility::Max<double>(session.fullTime, now + (limit.burst - bucket.tokens) / limit.rate);
+	return true;
+}
+
+void RateLimiter::Sweep(const double now)
+{
+	if (now - lastSweepTime < RATE_LIMIT_SWEEP_INTERVAL)
+		return;
+
+	lastSweepTime = now;
+	auto it = sessions.begin();
+	while (it != sessions.end())
+	{
+		if (it->second.fullTime <= now)
+			it = sessions.erase(it);
+		else
+			it++;
+	}
+}
\ No newline at end of file
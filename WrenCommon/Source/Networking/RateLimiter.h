@@ -0,0 +1,68 @@
+#pragma once
+
+#include <OpCodes.h>
+
+constexpr auto RATE_LIMIT_SWEEP_INTERVAL = 1.0; // seconds between passes that drop idle sessions' buckets
+// messages per second:burst for each class; logins hash a password and chat is broadcast to every player
+constexpr auto DEFAULT_RATE_LIMITS = "login=1:5,chat=2:5,targeting=10:20,items=10:20,ping=4:8,input=120:240";
+
+// Groups of client requests that share a token bucket. Each OpCode is in at most one class, and
+// OpCodes without one (server to server traffic, replies) are never limited.
+enum class RateLimitClass : unsigned char
+{
+	Login,
+	Chat,
+	Targeting,
+	Items,
+	Ping,
+	Input,
+	Count
+};
+
+const RateLimitClass GetRateLimitClass(const OpCode opCode);
+
+// A session can send burst messages of a class back to back, then rate per second. A rate of 0 turns
+// the limit off.
+struct RateLimit
+{
+	double rate{ 0.0 };
+	double burst{ 0.0 };
+};
+
+// Refills at the limit's rate up to its burst, and lets a message through for every whole token.
+struct TokenBucket
+{
+	double tokens{ 0.0 };
+	double updateTime{ 0.0 };
+
+	const bool Take(const RateLimit& limit, const double now);
+};
+
+struct RateLimits
+{
+	RateLimit limits[static_cast<int>(RateLimitClass::Count)];
+};
+
+// Parses e.g. "chat=2:5,targeting=10:20"; classes that aren't listed aren't limited.
+const RateLimits ParseRateLimits(const std::string& text);
+
+// Token buckets per session and RateLimitClass. A session's buckets are dropped once they've all
+// refilled, since a full bucket behaves exactly like a new one.
+class RateLimiter
+{
+	struct Session
+	{
+		TokenBucket buckets[static_cast<int>(RateLimitClass::Count)];
+		double fullTime{ 0.0 }; // when every bucket will have refilled
+	};
+
+	RateLimits limits;
+	bool enabled{ false };
+	std::map<unsigned __int64, Session> sessions;
+	double lastSweepTime{ 0.0 };
+
+public:
+	void SetLimits(const RateLimits& limits);
+	const bool Allow(const unsigned __int64 sessionKey, const OpCode opCode, const double now);
+	void Sweep(const double now);
+};
\ No newline at end of file
@@ -0,0 +1,71 @@
+#include "stdafx.h"
+#include "SnapshotBuffer.h"
+
+const Snapshot& SnapshotBuffer::Get(const int i) const
+{
+	return snapshots[(head + i) % SNAPSHOT_BUFFER_SIZE];
+}
+
+// Snapshots arriving out of order are dropped; EntitySequences already filters most stale updates.
+void SnapshotBuffer::Add(const double time, const XMFLOAT3& position, const XMFLOAT3& movementVector)
+{
+	if (count > 0 && time <= GetNewestTime())
+		return;
+
+	if (count == SNAPSHOT_BUFFER_SIZE)
+	{
+		head = (head + 1) % SNAPSHOT_BUFFER_SIZE;
+		count--;
+	}
+
+	snapshots[(head + count) % SNAPSHOT_BUFFER_SIZE] = Snapshot{ time, position, movementVector };
+	count++;
+}
+
+// Interpolates between the two snapshots around renderTime. Past the newest snapshot the entity keeps
+// moving along its last movement vector for up to maxExtrapolation seconds, then holds still until
+// new data arrives.
+const XMFLOAT3 SnapshotBuffer::Sample(const double renderTime, const float speed, const double maxExtrapolation) const
+{
+	if (count == 0)
+		return VEC_ZERO;
+
+	const Snapshot& oldest = Get(0);
+	if (renderTime <= oldest.time)
+		return oldest.position;
+
+	for (auto i = 1; i < count; i++)
+	{
+		const Snapshot& to = Get(i);
+		if (renderTime <= to.time)
+		{
+			const Snapshot& from = Get(i - 1);
+			const auto t = static_cast<float>((renderTime - from.time) / (to.time - from.time));
+			return XMFLOAT3
+			{
+				from.position.x + (to.position.x - from.position.x) * t,
+				from.position.y + (to.position.y - from.position.y) * t,
+				from.position.z + (to.position.z - from.position.z) * t
+			};
+		}
+	}
+
+	const Snapshot& newest = Get(count - 1);
+	const auto elapsed = static_cast<float>(renderTime - newest.time < maxExtrapolation ? renderTime - newest.time : maxExtrapolation);
+	return XMFLOAT3
+	{
+		newest.position.x + newest.movementVector.x * speed * elapsed,
+		newest.position.y + newest.movementVector.y * speed * elapsed,
+		newest.position.z + newest.movementVector.z * speed * elapsed
+	};
+}
+
+const bool SnapshotBuffer::IsEmpty() const { return count == 0; }
+
+const double SnapshotBuffer::GetNewestTime() const { return Get(count - 1).time; }
+
+void SnapshotBuffer::Clear()
+{
+	head = 0;
+	count = 0;
+}
\ No newline at end of file
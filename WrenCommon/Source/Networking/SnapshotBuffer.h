@@ -0,0 +1,28 @@
+#pragma once
+
+#include <Constants.h>
+
+constexpr auto SNAPSHOT_BUFFER_SIZE = 32;
+
+struct Snapshot
+{
+	double time;
+	XMFLOAT3 position;
+	XMFLOAT3 movementVector;
+};
+
+// The most recent timestamped states received for one remote entity, oldest first.
+class SnapshotBuffer
+{
+	Snapshot snapshots[SNAPSHOT_BUFFER_SIZE];
+	int head{ 0 };  // index of the oldest snapshot
+	int count{ 0 };
+
+	const Snapshot& Get(const int i) const;
+public:
+	void Add(const double time, const XMFLOAT3& position, const XMFLOAT3& movementVector);
+	const XMFLOAT3 Sample(const double renderTime, const float speed, const double maxExtrapolation) const;
+	const bool IsEmpty() const;
+	const double GetNewestTime() const;
+	void Clear();
+};
\ No newline at end of file
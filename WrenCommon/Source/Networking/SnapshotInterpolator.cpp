@@ -0,0 +1,45 @@
+#include "stdafx.h"
+#include "SnapshotInterpolator.h"
+
+void SnapshotInterpolator::AddSnapshot(const int gameObjectId, const double time, const XMFLOAT3& position, const XMFLOAT3& movementVector)
+{
+	buffers[gameObjectId].Add(time, position, movementVector);
+}
+
+const bool SnapshotInterpolator::TryGetPosition(const int gameObjectId, const double now, const float speed, XMFLOAT3& position) const
+{
+	const auto it = buffers.find(gameObjectId);
+	if (it == buffers.end() || it->second.IsEmpty())
+		return false;
+
+	position = it->second.Sample(now - interpolationDelay, speed, maxExtrapolation);
+	return true;
+}
+
+void SnapshotInterpolator::Remove(const int gameObjectId)
+{
+	buffers.erase(gameObjectId);
+}
+
+void SnapshotInterpolator::RemoveExpired(const double now)
+{
+	auto it = buffers.begin();
+	while (it != buffers.end())
+	{
+		if (it->second.IsEmpty() || now - it->second.GetNewestTime() > SNAPSHOT_EXPIRY_TIME)
+			it = buffers.erase(it);
+		else
+			it++;
+	}
+}
+
+void SnapshotInterpolator::Clear()
+{
+	buffers.clear();
+}
+
+void SnapshotInterpolator::SetInterpolationDelay(const double delay) { interpolationDelay = delay; }
+
+void SnapshotInterpolator::SetMaxExtrapolation(const double maxExtrapolation) { this->maxExtrapolation = maxExtrapolation; }
+
+const double SnapshotInterpolator::GetInterpolationDelay() const { return interpolationDelay; }
\ No newline at end of file
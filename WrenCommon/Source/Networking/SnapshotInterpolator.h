@@ -0,0 +1,28 @@
+#pragma once
+
+#include "SnapshotBuffer.h"
+
+constexpr auto DEFAULT_INTERPOLATION_DELAY = 0.1;  // seconds; should cover at least two server updates
+constexpr auto DEFAULT_MAX_EXTRAPOLATION = 0.25;   // seconds
+constexpr auto SNAPSHOT_EXPIRY_TIME = 10.0;        // seconds without an update before an entity's buffer is dropped
+
+// Renders remote entities slightly in the past so there are (almost) always two snapshots to
+// interpolate between, which hides jitter and lets the server send updates at well under the
+// client's frame rate. Times are on any monotonic clock, as long as AddSnapshot and GetPosition
+// use the same one. Nothing here touches the renderer, so it can be driven headless.
+class SnapshotInterpolator
+{
+	std::map<int, SnapshotBuffer> buffers;
+	double interpolationDelay{ DEFAULT_INTERPOLATION_DELAY };
+	double maxExtrapolation{ DEFAULT_MAX_EXTRAPOLATION };
+
+public:
+	void AddSnapshot(const int gameObjectId, const double time, const XMFLOAT3& position, const XMFLOAT3& movementVector);
+	const bool TryGetPosition(const int gameObjectId, const double now, const float speed, XMFLOAT3& position) const;
+	void Remove(const int gameObjectId);
+	void RemoveExpired(const double now);
+	void Clear();
+	void SetInterpolationDelay(const double delay);
+	void SetMaxExtrapolation(const double maxExtrapolation);
+	const double GetInterpolationDelay() const;
+};
\ No newline at end of file
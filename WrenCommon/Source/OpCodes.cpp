@@ -0,0 +1,57 @@
+#include "stdafx.h"
+#include "OpCodes.h"
+
+const char* GetOpCodeName(const OpCode opCode)
+{
+	switch (opCode)
+	{
+		case OpCode::Connect: return "Connect";
+		case OpCode::Disconnect: return "Disconnect";
+		case OpCode::LoginSuccess: return "LoginSuccess";
+		case OpCode::LoginFailure: return "LoginFailure";
+		case OpCode::CreateAccount: return "CreateAccount";
+		case OpCode::CreateAccountSuccess: return "CreateAccountSuccess";
+		case OpCode::CreateAccountFailure: return "CreateAccountFailure";
+		case OpCode::CreateCharacter: return "CreateCharacter";
+		case OpCode::CreateCharacterSuccess: return "CreateCharacterSuccess";
+		case OpCode::CreateCharacterFailure: return "CreateCharacterFailure";
+		case OpCode::Heartbeat: return "Heartbeat";
+		case OpCode::EnterWorld: return "EnterWorld";
+		case OpCode::EnterWorldSuccess: return "EnterWorldSuccess";
+		case OpCode::DeleteCharacter: return "DeleteCharacter";
+		case OpCode::DeleteCharacterSuccess: return "DeleteCharacterSuccess";
+		case OpCode::PlayerUpdate: return "PlayerUpdate";
+		case OpCode::SkillIncrease: return "SkillIncrease";
+		case OpCode::NpcUpdate: return "NpcUpdate";
+		case OpCode::ActivateAbility: return "ActivateAbility";
+		case OpCode::SendChatMessage: return "SendChatMessage";
+		case OpCode::PropagateChatMessage: return "PropagateChatMessage";
+		case OpCode::SetTarget: return "SetTarget";
+		case OpCode::UnsetTarget: return "UnsetTarget";
+		case OpCode::ServerMessage: return "ServerMessage";
+		case OpCode::ActivateAbilitySuccess: return "ActivateAbilitySuccess";
+		case OpCode::AttackHit: return "AttackHit";
+		case OpCode::AttackMiss: return "AttackMiss";
+		case OpCode::Ping: return "Ping";
+		case OpCode::Pong: return "Pong";
+		case OpCode::PlayerRightMouseDown: return "PlayerRightMouseDown";
+		case OpCode::PlayerRightMouseUp: return "PlayerRightMouseUp";
+		case OpCode::PlayerRightMouseDirChange: return "PlayerRightMouseDirChange";
+		case OpCode::NpcDeath: return "NpcDeath";
+		case OpCode::LootItem: return "LootItem";
+		case OpCode::LootItemSuccess: return "LootItemSuccess";
+		case OpCode::MoveItem: return "MoveItem";
+		case OpCode::MoveItemSuccess: return "MoveItemSuccess";
+		case OpCode::PlayerInput: return "PlayerInput";
+		case OpCode::PlayerCorrection: return "PlayerCorrection";
+		case OpCode::ZoneHandoff: return "ZoneHandoff";
+		case OpCode::ZoneHandoffAccepted: return "ZoneHandoffAccepted";
+		case OpCode::ZoneTransfer: return "ZoneTransfer";
+		case OpCode::ZoneBorderUpdate: return "ZoneBorderUpdate";
+		case OpCode::GatewayForward: return "GatewayForward";
+		case OpCode::GatewayForwardUnreliable: return "GatewayForwardUnreliable";
+		case OpCode::GatewayLogin: return "GatewayLogin";
+		case OpCode::GatewayDisconnect: return "GatewayDisconnect";
+		default: return "Unknown";
+	}
+}
\ No newline at end of file
@@ -39,6 +39,19 @@ enum class OpCode : int
 	LootItemSuccess,
 	MoveItem,
 	MoveItemSuccess,
+	PlayerInput,
+	PlayerCorrection,
+	ZoneHandoff,
+	ZoneHandoffAccepted,
+	ZoneTransfer,
+	ZoneBorderUpdate,
+	GatewayForward,
+	GatewayForwardUnreliable,
+	GatewayLogin,
+	GatewayDisconnect,
 
 	Checksum = 65836216
 };
+
+// For stats and logs; returns "Unknown" for anything that isn't listed above.
+const char* GetOpCodeName(const OpCode opCode);
@@ -0,0 +1,50 @@
+#include "stdafx.h"
+#include "PlayerMovement.h"
+
+const bool PlayerMovement::TryStartMove(GameObject& player, const XMFLOAT3& direction, GameMap* gameMap)
+{
+	if (player.movementVector != VEC_ZERO || direction == VEC_ZERO)
+		return false;
+
+	const auto delta = XMFLOAT3{ direction.x * TILE_SIZE, direction.y * TILE_SIZE, direction.z * TILE_SIZE };
+	const auto proposedPos = player.localPosition + delta;
+
+	if (Utility::CheckOutOfBounds(proposedPos) || (gameMap && gameMap->IsTileOccupied(proposedPos)))
+		return false;
+
+	player.movementVector = direction;
+	player.destination = proposedPos;
+	return true;
+}
+
+void PlayerMovement::Step(GameObject& player, const XMFLOAT3& direction, GameMap* gameMap)
+{
+	TryStartMove(player, direction, gameMap);
+	player.Update();
+}
+
+void PlayerMovement::WriteCorrection(BitWriter& writer, const unsigned short sequence, const unsigned int inputSequence, const GameObject& player)
+{
+	writer.WriteBits(sequence, 16);
+	writer.WriteBits(inputSequence, 32);
+	writer.WriteFloat(player.localPosition.x);
+	writer.WriteFloat(player.localPosition.y);
+	writer.WriteFloat(player.localPosition.z);
+	writer.WriteDirection(player.movementVector);
+	writer.WriteFloat(player.destination.x);
+	writer.WriteFloat(player.destination.y);
+	writer.WriteFloat(player.destination.z);
+}
+
+void PlayerMovement::ReadCorrection(BitReader& reader, unsigned short& sequence, unsigned int& inputSequence, XMFLOAT3& position, XMFLOAT3& movementVector, XMFLOAT3& destination)
+{
+	sequence = static_cast<unsigned short>(reader.ReadBits(16));
+	inputSequence = reader.ReadBits(32);
+	position.x = reader.ReadFloat();
+	position.y = reader.ReadFloat();
+	position.z = reader.ReadFloat();
+	movementVector = reader.ReadDirection();
+	destination.x = reader.ReadFloat();
+	destination.y = reader.ReadFloat();
+	destination.z = reader.ReadFloat();
+}
\ No newline at end of file
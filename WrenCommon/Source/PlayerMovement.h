@@ -0,0 +1,34 @@
+#pragma once
+
+#include "GameObject.h"
+#include "GameMap/GameMap.h"
+#include "Networking/BitWriter.h"
+#include "Networking/BitReader.h"
+
+constexpr auto MAX_REDUNDANT_INPUTS = 8;   // each PlayerInput repeats this many recent inputs, so a lost datagram costs nothing
+constexpr auto MAX_QUEUED_INPUTS = 8;      // the server drops the oldest inputs past this, so a burst can't add permanent latency
+constexpr auto MAX_PREDICTED_INPUTS = 128; // unacknowledged inputs the client keeps for replay
+
+// The movement input held down during one fixed update tick.
+struct PlayerInput
+{
+	unsigned int sequence;
+	XMFLOAT3 direction;
+};
+
+// Player movement shared by the server simulation and the client's prediction, so replaying the
+// same inputs on both sides ends in the same place.
+class PlayerMovement
+{
+public:
+	// Starts a one tile move in the held direction if the player is standing still. Tile occupancy
+	// is only checked when a GameMap is passed, since the client's occupancy data is incomplete.
+	static const bool TryStartMove(GameObject& player, const XMFLOAT3& direction, GameMap* gameMap);
+	// One full tick for the local player: what PlayerComponentManager::Update and ObjectManager::Update do on the server.
+	static void Step(GameObject& player, const XMFLOAT3& direction, GameMap* gameMap);
+
+	// PlayerCorrection: the player's update sequence, the last input the server applied and the resulting movement state. Positions
+	// aren't quantized, since the client replays its remaining inputs on top of them.
+	static void WriteCorrection(BitWriter& writer, const unsigned short sequence, const unsigned int inputSequence, const GameObject& player);
+	static void ReadCorrection(BitReader& reader, unsigned short& sequence, unsigned int& inputSequence, XMFLOAT3& position, XMFLOAT3& movementVector, XMFLOAT3& destination);
+};
@@ -0,0 +1,85 @@
+#include "stdafx.h"
+#include "Histogram.h"
+#include <Utility.h>
+
+Histogram::Histogram()
+	: counts(HISTOGRAM_BUCKET_COUNT, 0)
+{
+}
+
+const int Histogram::GetBucketIndex(const unsigned __int64 value)
+{
+	if (value < HISTOGRAM_SUB_BUCKET_COUNT)
+		return static_cast<int>(value);
+
+	auto magnitude = HISTOGRAM_SUB_BUCKET_BITS;
+	while ((value >> (magnitude + 1)) != 0)
+		magnitude++;
+
+	// the top HISTOGRAM_SUB_BUCKET_BITS - 1 bits below the leading one pick the sub bucket
+	const auto shift = magnitude - HISTOGRAM_SUB_BUCKET_BITS + 1;
+	const auto subBucket = static_cast<int>(value >> shift) - HISTOGRAM_SUB_BUCKET_HALF;
+	return HISTOGRAM_SUB_BUCKET_COUNT + (shift - 1) * HISTOGRAM_SUB_BUCKET_HALF + subBucket;
+}
+
+const unsigned __int64 Histogram::GetBucketUpperBound(const int index)
+{
+	if (index < HISTOGRAM_SUB_BUCKET_COUNT)
+		return index;
+
+	const auto offset = index - HISTOGRAM_SUB_BUCKET_COUNT;
+	const auto shift = offset / HISTOGRAM_SUB_BUCKET_HALF + 1;
+	const auto subBucket = static_cast<unsigned __int64>(offset % HISTOGRAM_SUB_BUCKET_HALF + HISTOGRAM_SUB_BUCKET_HALF);
+	return ((subBucket + 1) << shift) - 1;
+}
+
+void Histogram::Record(const double seconds)
+{
+	RecordNanoseconds(static_cast<unsigned __int64>(Utility::Max<double>(0.0, seconds) * 1000000000.0));
+}
+
+void Histogram::RecordNanoseconds(unsigned __int64 value)
+{
+	const auto largest = (1ull << HISTOGRAM_MAX_MAGNITUDE) - 1;
+	if (value > largest)
+		value = largest;
+
+	counts[GetBucketIndex(value)]++;
+	totalCount++;
+	sum += static_cast<double>(value);
+	if (value > max)
+		max = value;
+}
+
+// Reports the top of the bucket the percentile falls in, so it never understates a latency,
+// but never more than the largest value actually recorded.
+const double Histogram::GetValueAtPercentile(const double percentile) const
+{
+	if (totalCount == 0)
+		return 0.0;
+
+	const auto target = Utility::Max<unsigned __int64>(1, static_cast<unsigned __int64>(std::ceil(percentile * totalCount)));
+	unsigned __int64 cumulativeCount{ 0 };
+	for (auto i = 0; i < HISTOGRAM_BUCKET_COUNT; i++)
+	{
+		cumulativeCount += counts[i];
+		if (cumulativeCount >= target)
+			return Utility::Min<unsigned __int64>(GetBucketUpperBound(i), max) / 1000000000.0;
+	}
+
+	return max / 1000000000.0;
+}
+
+const double Histogram::GetMax() const { return max / 1000000000.0; }
+
+const double Histogram::GetMean() const { return totalCount == 0 ? 0.0 : sum / totalCount / 1000000000.0; }
+
+const unsigned __int64 Histogram::GetCount() const { return totalCount; }
+
+void Histogram::Reset()
+{
+	std::fill(counts.begin(), counts.end(), 0);
+	totalCount = 0;
+	max = 0;
+	sum = 0.0;
+}
\ No newline at end of file
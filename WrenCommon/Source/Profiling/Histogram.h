@@ -0,0 +1,30 @@
+#pragma once
+
+constexpr auto HISTOGRAM_SUB_BUCKET_BITS = 7;
+constexpr auto HISTOGRAM_SUB_BUCKET_COUNT = 1 << HISTOGRAM_SUB_BUCKET_BITS;
+constexpr auto HISTOGRAM_SUB_BUCKET_HALF = HISTOGRAM_SUB_BUCKET_COUNT / 2;
+constexpr auto HISTOGRAM_MAX_MAGNITUDE = 40; // values are clamped below 2^40ns, about 18 minutes
+constexpr auto HISTOGRAM_BUCKET_COUNT = HISTOGRAM_SUB_BUCKET_COUNT + (HISTOGRAM_MAX_MAGNITUDE - HISTOGRAM_SUB_BUCKET_BITS) * HISTOGRAM_SUB_BUCKET_HALF;
+
+// HDR-style histogram of durations in nanoseconds. Values below HISTOGRAM_SUB_BUCKET_COUNT get a
+// bucket each; above that every power of two is split into HISTOGRAM_SUB_BUCKET_HALF buckets, so
+// percentiles are within 1/64 of the recorded value at any magnitude. Recording never allocates.
+class Histogram
+{
+	std::vector<unsigned int> counts;
+	unsigned __int64 totalCount{ 0 };
+	unsigned __int64 max{ 0 };
+	double sum{ 0.0 };
+
+	static const int GetBucketIndex(const unsigned __int64 value);
+	static const unsigned __int64 GetBucketUpperBound(const int index);
+public:
+	Histogram();
+	void Record(const double seconds);
+	void RecordNanoseconds(unsigned __int64 value);
+	const double GetValueAtPercentile(const double percentile) const; // seconds
+	const double GetMax() const;
+	const double GetMean() const;
+	const unsigned __int64 GetCount() const;
+	void Reset();
+};
\ No newline at end of file
@@ -0,0 +1,166 @@
+#include "stdafx.h"
+#include "TickProfiler.h"
+
+TickProfiler::TickProfiler(const double tickBudget, const int traceArg)
+	: tickBudget{ tickBudget },
+	  traceArg{ traceArg },
+	  intervalStart{ GetTime() }
+{
+}
+
+// Add every phase before the first tick; the returned index is what Record and ProfilerScope take.
+const int TickProfiler::AddPhase(const std::string& name)
+{
+	phases.push_back(ProfilerPhase{ name });
+	return static_cast<int>(phases.size()) - 1;
+}
+
+void TickProfiler::BeginTick()
+{
+	tickStart = GetTime();
+	tickTraceStart = Trace::GetTimestamp();
+}
+
+// Returns how long the tick took, in seconds.
+const double TickProfiler::EndTick()
+{
+	const auto duration = GetTime() - tickStart;
+	tickHistogram.Record(duration);
+	totalTicks++;
+	if (duration > tickBudget)
+	{
+		overruns++;
+		totalOverruns++;
+	}
+
+	if (Trace::IsEnabled())
+		Trace::Record("Tick", tickTraceStart, Trace::GetTimestamp(), traceArg);
+
+	return duration;
+}
+
+void TickProfiler::Record(const int phase, const double seconds)
+{
+	phases[phase].histogram.Record(seconds);
+}
+
+// Ticks the main loop gave up on after falling too far behind, e.g. across a debugger break.
+void TickProfiler::SkipTicks(const int count)
+{
+	skippedTicks += count;
+	totalSkippedTicks += count;
+}
+
+// Phases must all be added before the first tick, since trace events keep pointers to their names.
+const char* TickProfiler::GetPhaseName(const int phase) const
+{
+	return phases[phase].name.c_str();
+}
+
+const int TickProfiler::GetTraceArg() const { return traceArg; }
+
+const int TickProfiler::GetPhaseCount() const { return static_cast<int>(phases.size()); }
+
+const Histogram& TickProfiler::GetPhaseHistogram(const int phase) const { return phases[phase].histogram; }
+
+// The histograms only cover the ticks since the last Reset.
+const Histogram& TickProfiler::GetTickHistogram() const { return tickHistogram; }
+
+const unsigned __int64 TickProfiler::GetTotalTicks() const { return totalTicks; }
+
+const unsigned __int64 TickProfiler::GetTotalOverruns() const { return totalOverruns; }
+
+const unsigned __int64 TickProfiler::GetTotalSkippedTicks() const { return totalSkippedTicks; }
+
+void TickProfiler::Report(std::ostream& out) const
+{
+	out << std::fixed << std::setprecision(3)
+		<< "Ticks: " << tickHistogram.GetCount() << " ticks, " << overruns << " over " << tickBudget * 1000.0 << "ms, " << skippedTicks << " skipped, "
+		<< "p50 " << tickHistogram.GetValueAtPercentile(0.5) * 1000.0 << "ms, "
+		<< "p99 " << tickHistogram.GetValueAtPercentile(0.99) * 1000.0 << "ms, "
+		<< "max " << tickHistogram.GetMax() * 1000.0 << "ms\n";
+
+	for (auto i = 0; i < phases.size(); i++)
+	{
+		const Histogram& histogram = phases[i].histogram;
+		out << "  " << std::left << std::setw(24) << phases[i].name << std::right
+			<< "p50 " << histogram.GetValueAtPercentile(0.5) * 1000.0 << "ms, "
+			<< "p99 " << histogram.GetValueAtPercentile(0.99) * 1000.0 << "ms, "
+			<< "max " << histogram.GetMax() * 1000.0 << "ms\n";
+	}
+}
+
+// Appends one JSON object per report, with durations in microseconds, so a run can be graphed
+// or compared with another one afterwards. label tells apart profilers reporting to the same file.
+void TickProfiler::WriteReport(const std::string& path, const std::string& label) const
+{
+	std::ofstream file{ path, std::ios::app };
+	if (!file)
+		return;
+
+	const auto writeHistogram = [&file](const Histogram& histogram)
+	{
+		file << "{\"count\":" << histogram.GetCount()
+			<< ",\"mean\":" << histogram.GetMean() * 1000000.0
+			<< ",\"p50\":" << histogram.GetValueAtPercentile(0.5) * 1000000.0
+			<< ",\"p90\":" << histogram.GetValueAtPercentile(0.9) * 1000000.0
+			<< ",\"p99\":" << histogram.GetValueAtPercentile(0.99) * 1000000.0
+			<< ",\"p999\":" << histogram.GetValueAtPercentile(0.999) * 1000000.0
+			<< ",\"max\":" << histogram.GetMax() * 1000000.0 << "}";
+	};
+
+	file << std::fixed << std::setprecision(1)
+		<< "{\"time\":" << std::time(nullptr);
+	if (!label.empty())
+		file << ",\"label\":\"" << label << "\"";
+	file << ",\"interval\":" << GetTime() - intervalStart
+		<< ",\"budget\":" << tickBudget * 1000000.0
+		<< ",\"overruns\":" << overruns
+		<< ",\"skipped\":" << skippedTicks
+		<< ",\"tick\":";
+	writeHistogram(tickHistogram);
+	file << ",\"phases\":{";
+	for (auto i = 0; i < phases.size(); i++)
+	{
+		if (i > 0)
+			file << ",";
+		file << "\"" << phases[i].name << "\":";
+		writeHistogram(phases[i].histogram);
+	}
+	file << "}}\n";
+}
+
+void TickProfiler::Reset()
+{
+	tickHistogram.Reset();
+	for (auto i = 0; i < phases.size(); i++)
+		phases[i].histogram.Reset();
+	overruns = 0;
+	skippedTicks = 0;
+	intervalStart = GetTime();
+}
+
+const double TickProfiler::GetTime()
+{
+	return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+ProfilerScope::ProfilerScope(TickProfiler& profiler, const int phase)
+	: profiler{ profiler },
+	  phase{ phase },
+	  start{ TickProfiler::GetTime() },
+	  traceStart{ Trace::IsEnabled() ? Trace::GetTimestamp() : 0 }
+{
+}
+
+ProfilerScope::~ProfilerScope()
+{
+	profiler.Record(phase, TickProfiler::GetTime() - start);
+
+	if (traceStart == 0 || !Trace::IsEnabled())
+		return;
+
+	const auto traceEnd = Trace::GetTimestamp();
+	if (traceEnd - traceStart >= PROFILER_MIN_TRACE_DURATION)
+		Trace::Record(profiler.GetPhaseName(phase), traceStart, traceEnd, profiler.GetTraceArg());
+}
\ No newline at end of file
@@ -0,0 +1,68 @@
+#pragma once
+
+#include <Constants.h>
+#include "Histogram.h"
+#include "Trace.h"
+
+// the main loop wakes for every datagram, so tracing every short ProcessPackets/FlushPackets would flush the trace buffer in seconds
+constexpr auto PROFILER_MIN_TRACE_DURATION = 5; // microseconds
+
+struct ProfilerPhase
+{
+	std::string name;
+	Histogram histogram;
+};
+
+// Wall time per phase of the main loop, and per tick. A tick that takes longer than the tick
+// budget is an overrun: the loop falls behind and has to catch up on the following iterations.
+// Phases are timed each time they run, so phases outside the fixed update (like ProcessPackets)
+// get one sample per loop iteration rather than per tick.
+class TickProfiler
+{
+	std::vector<ProfilerPhase> phases;
+	Histogram tickHistogram;
+	const double tickBudget;
+	const int traceArg; // on every trace event, e.g. to tell apart profilers ticking on the same thread
+	double tickStart{ 0.0 };
+	__int64 tickTraceStart{ 0 };
+	int overruns{ 0 };
+	int skippedTicks{ 0 };
+	double intervalStart;
+	unsigned __int64 totalTicks{ 0 };    // unlike everything else, not cleared by Reset
+	unsigned __int64 totalOverruns{ 0 };
+	unsigned __int64 totalSkippedTicks{ 0 };
+
+public:
+	TickProfiler(const double tickBudget = UPDATE_FREQUENCY, const int traceArg = TRACE_NO_ARG);
+	const int AddPhase(const std::string& name);
+	void BeginTick();
+	const double EndTick();
+	void Record(const int phase, const double seconds);
+	void SkipTicks(const int count);
+	const char* GetPhaseName(const int phase) const;
+	const int GetTraceArg() const;
+	const int GetPhaseCount() const;
+	const Histogram& GetPhaseHistogram(const int phase) const;
+	const Histogram& GetTickHistogram() const;
+	const unsigned __int64 GetTotalTicks() const;
+	const unsigned __int64 GetTotalOverruns() const;
+	const unsigned __int64 GetTotalSkippedTicks() const;
+	void Report(std::ostream& out) const;
+	void WriteReport(const std::string& path, const std::string& label = "") const;
+	void Reset();
+
+	static const double GetTime();
+};
+
+// Records the time until it goes out of scope against one phase of a TickProfiler, and as a trace zone.
+class ProfilerScope
+{
+	TickProfiler& profiler;
+	const int phase;
+	const double start;
+	const __int64 traceStart;
+
+public:
+	ProfilerScope(TickProfiler& profiler, const int phase);
+	~ProfilerScope();
+};
\ No newline at end of file
@@ -0,0 +1,86 @@
+#include "stdafx.h"
+#include "Trace.h"
+#include <mutex>
+
+std::atomic<bool> Trace::enabled{ false };
+
+static std::mutex bufferListMutex;
+static std::vector<std::unique_ptr<TraceBuffer>> buffers;
+
+TraceBuffer& Trace::GetThreadBuffer()
+{
+	thread_local TraceBuffer* buffer{ nullptr };
+	if (!buffer)
+	{
+		std::lock_guard<std::mutex> lock{ bufferListMutex };
+		buffers.push_back(std::make_unique<TraceBuffer>());
+		buffer = buffers.back().get();
+		buffer->threadId = static_cast<int>(buffers.size());
+	}
+	return *buffer;
+}
+
+void Trace::SetEnabled(const bool enabled) { Trace::enabled.store(enabled, std::memory_order_relaxed); }
+
+const bool Trace::IsEnabled() { return enabled.load(std::memory_order_relaxed); }
+
+void Trace::Record(const char* name, const __int64 start, const __int64 end, const int arg)
+{
+	TraceBuffer& buffer = GetThreadBuffer();
+	const auto index = buffer.writeIndex.load(std::memory_order_relaxed);
+	buffer.events[index & (TRACE_BUFFER_SIZE - 1)] = TraceEvent{ name, start, end - start, arg };
+	buffer.writeIndex.store(index + 1, std::memory_order_release);
+}
+
+// Writes whatever is still in every thread's ring buffer, oldest first. Threads keep recording
+// while this runs; their new events are left for the next export.
+const bool Trace::Export(const std::string& path)
+{
+	std::ofstream file{ path };
+	if (!file)
+		return false;
+
+	file << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+	auto first = true;
+
+	std::lock_guard<std::mutex> lock{ bufferListMutex };
+	for (auto i = 0; i < buffers.size(); i++)
+	{
+		const TraceBuffer& buffer = *buffers[i];
+		const auto end = buffer.writeIndex.load(std::memory_order_acquire);
+		const auto count = end < TRACE_BUFFER_SIZE ? end : TRACE_BUFFER_SIZE;
+
+		for (auto j = end - count; j != end; j++)
+		{
+			const TraceEvent& event = buffer.events[j & (TRACE_BUFFER_SIZE - 1)];
+			file << (first ? "" : ",")
+				<< "\n{\"name\":\"" << event.name << "\",\"cat\":\"wren\",\"ph\":\"X\",\"pid\":1,\"tid\":" << buffer.threadId
+				<< ",\"ts\":" << event.start << ",\"dur\":" << event.duration;
+			if (event.arg != TRACE_NO_ARG)
+				file << ",\"args\":{\"id\":" << event.arg << "}";
+			file << "}";
+			first = false;
+		}
+	}
+
+	file << "\n]}\n";
+	return true;
+}
+
+const __int64 Trace::GetTimestamp()
+{
+	return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+TraceZone::TraceZone(const char* name, const int arg)
+	: name{ name },
+	  arg{ arg },
+	  start{ Trace::IsEnabled() ? Trace::GetTimestamp() : 0 }
+{
+}
+
+TraceZone::~TraceZone()
+{
+	if (start != 0 && Trace::IsEnabled())
+		Trace::Record(name, start, Trace::GetTimestamp(), arg);
+}
\ No newline at end of file
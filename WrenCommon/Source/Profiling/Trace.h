@@ -0,0 +1,52 @@
+#pragma once
+
+#include <atomic>
+
+constexpr auto TRACE_BUFFER_SIZE = 1 << 16; // events kept per thread, must be a power of two
+constexpr auto TRACE_NO_ARG = -1;
+
+// name must outlive the trace, in practice a string literal
+struct TraceEvent
+{
+	const char* name;
+	__int64 start;    // microseconds
+	__int64 duration; // microseconds
+	int arg;          // e.g. the OpCode or EventType, TRACE_NO_ARG if none
+};
+
+// Each thread writes to its own ring buffer, so recording takes no lock: the writer fills the next
+// slot and publishes it by bumping writeIndex. Buffers are only registered (under a mutex) the first
+// time a thread records anything. An export running alongside a writer may see a slot that is being
+// overwritten, which only ever affects the oldest events in the buffer.
+struct TraceBuffer
+{
+	TraceEvent events[TRACE_BUFFER_SIZE];
+	std::atomic<unsigned int> writeIndex{ 0 };
+	int threadId{ 0 };
+};
+
+// Scoped trace zones, exported as Chrome trace_event JSON (load it in chrome://tracing or Perfetto).
+// Recording is off until SetEnabled(true), and a disabled zone costs one atomic load.
+class Trace
+{
+	static std::atomic<bool> enabled;
+
+	static TraceBuffer& GetThreadBuffer();
+public:
+	static void SetEnabled(const bool enabled);
+	static const bool IsEnabled();
+	static void Record(const char* name, const __int64 start, const __int64 end, const int arg = TRACE_NO_ARG);
+	static const bool Export(const std::string& path);
+	static const __int64 GetTimestamp();
+};
+
+class TraceZone
+{
+	const char* name;
+	const int arg;
+	const __int64 start;
+
+public:
+	TraceZone(const char* name, const int arg = TRACE_NO_ARG);
+	~TraceZone();
+};
\ No newline at end of file
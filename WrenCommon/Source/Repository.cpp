@@ -8,6 +8,8 @@ Repository::Repository(const char* dbName)
 
 sqlite3* Repository::GetConnection()
 {
+    TraceZone zone{ "Repository::GetConnection" };
+
     sqlite3* dbConnection;
     if (sqlite3_open(dbName, &dbConnection) != SQLITE_OK)
         throw std::exception("Failed to open database.");
@@ -17,6 +19,8 @@ sqlite3* Repository::GetConnection()
 
 sqlite3_stmt* Repository::PrepareStatement(sqlite3* dbConnection, std::span<const char> query)
 {
+    TraceZone zone{ "Repository::PrepareStatement" };
+
     sqlite3_stmt* statement;
     if (sqlite3_prepare_v2(dbConnection, query.data(), -1, &statement, nullptr) != SQLITE_OK)
     {
@@ -31,4 +35,24 @@ sqlite3_stmt* Repository::PrepareStatement(sqlite3* dbConnection, std::span<cons
 void Repository::PrintLastError(sqlite3* dbConnection)
 {
 	std::cout << sqlite3_errmsg(dbConnection) << std::endl;
+}
+
+const std::map<std::string, Histogram>& Repository::GetQueryLatencies() const { return queryLatencies; }
+
+QueryScope::QueryScope(Repository& repository, const char* name)
+	: repository{ repository },
+	  name{ name },
+	  start{ GetTime() },
+	  zone{ name }
+{
+}
+
+QueryScope::~QueryScope()
+{
+	repository.queryLatencies[name].Record(GetTime() - start);
+}
+
+const double QueryScope::GetTime()
+{
+	return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
 }
\ No newline at end of file
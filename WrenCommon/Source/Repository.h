@@ -1,6 +1,8 @@
 #pragma once
 
 #include <Span.h>
+#include "Profiling/Histogram.h"
+#include "Profiling/Trace.h"
 
 constexpr auto FAILED_TO_PREPARE = "Failed to prepare SQLite statement.";
 constexpr auto FAILED_TO_EXECUTE = "Failed to execute statement.";
@@ -8,10 +10,28 @@ constexpr auto FAILED_TO_EXECUTE = "Failed to execute statement.";
 class Repository
 {
 	const char* dbName;
+	std::map<std::string, Histogram> queryLatencies;
+
+	friend class QueryScope;
 protected:
 	sqlite3* GetConnection();
 	sqlite3_stmt* PrepareStatement(sqlite3* dbConnection, std::span<const char> query);
 	void PrintLastError(sqlite3* dbConnection);
 public:
 	Repository(const char* dbName);
+	const std::map<std::string, Histogram>& GetQueryLatencies() const;
+};
+
+// Times one repository method, both as a trace zone and in the repository's per-query latency histograms.
+class QueryScope
+{
+	Repository& repository;
+	const char* name;
+	const double start;
+	TraceZone zone;
+
+	static const double GetTime();
+public:
+	QueryScope(Repository& repository, const char* name);
+	~QueryScope();
 };
@@ -1,6 +1,16 @@
 #include "stdafx.h"
 #include "SocketManager.h"
 #include "Constants.h"
+#include <Utility.h>
+#include "Profiling/Trace.h"
+
+constexpr auto FORWARD_HEADER_SIZE = static_cast<int>(sizeof(in_addr) + sizeof(u_short)); // the endpoint a forwarded message is for
+
+// CPU costs are timed on the real clock, even when GetTime is simulated, e.g. in tests and replays
+static const double GetCpuTime()
+{
+	return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
 
 SocketManager::SocketManager(EventHandler& eventHandler, const int localPort)
 	: eventHandler{ eventHandler }
@@ -24,12 +34,17 @@ SocketManager::SocketManager(EventHandler& eventHandler, const int localPort)
 	bind(sock, (sockaddr*)& local, sockaddr_in_len);
 	DWORD nonBlocking = 1;
 	ioctlsocket(sock, FIONBIO, &nonBlocking);
+
+	// the cookie key only has to outlive the challenges it signs, so a fresh one per process is fine
+	std::random_device device;
+	handshakeCookies.SetKey(static_cast<unsigned __int64>(device()) << 32 | device(), static_cast<unsigned __int64>(device()) << 32 | device());
+
+	networkStats.startTime = GetTime();
 }
 
 bool SocketManager::TryRecieveMessage()
 {
-	char buffer[1024];
-	ZeroMemory(buffer, sizeof(buffer));
+	char buffer[MAX_DATAGRAM_SIZE];
 	const auto result = recvfrom(sock, buffer, sizeof(buffer), 0, (sockaddr*)& from, &sockaddr_in_len);
 	if (result == SOCKET_ERROR)
 	{
@@ -40,76 +55,994 @@ bool SocketManager::TryRecieveMessage()
 
 		throw std::exception("WrenServer SocketManager error receiving packet. Error code: " + errorCode);
 	}
-	else
+
+	if (networkSimulator)
 	{
-		int offset{ 0 };
+		WSABUF datagram;
+		datagram.buf = buffer;
+		datagram.len = result;
+		networkSimulator->Submit(SimulatedDirection::Inbound, from, &datagram, 1, GetTime());
+		return true;
+	}
 
-		// if the checksum is wrong, ignore the packet
-		int checksum{ 0 };
-		memcpy(&checksum, buffer, sizeof(OpCode));
-		offset += sizeof(OpCode);
-		if (checksum != static_cast<int>(OpCode::Checksum))
-			return true;
+	DeliverDatagram(from, buffer, result);
+	return true;
+}
 
-		OpCode opCode{ };
-		memcpy(&opCode, buffer + offset, sizeof(OpCode));
-		offset += sizeof(OpCode);
+void SocketManager::DeliverDatagram(const sockaddr_in& address, const char* buffer, const int length)
+{
+	from = address;
+	if (inboundCapture)
+		inboundCapture->Write(from, buffer, length);
+
+	ReceiveDatagram(buffer, length);
+}
+
+// Parses one datagram from the endpoint in from and hands its messages to the channel they were sent on.
+void SocketManager::ReceiveDatagram(const char* buffer, const int length)
+{
+	if (length < DATAGRAM_HEADER_SIZE)
+	{
+		networkStats.malformedDatagrams++;
+		return;
+	}
+
+	int offset{ 0 };
 
-		std::vector<std::string> args;
-		const auto bufferLength = strlen(buffer + offset);
-		if (bufferLength > 0)
+	// if the checksum is wrong, ignore the packet
+	int checksum{ 0 };
+	memcpy(&checksum, buffer, sizeof(OpCode));
+	offset += sizeof(OpCode);
+	if (checksum == HANDSHAKE_CHECKSUM)
+	{
+		ReceiveHandshake(buffer, length);
+		return;
+	}
+	if (checksum != static_cast<int>(OpCode::Checksum))
+	{
+		networkStats.checksumRejects++;
+		return;
+	}
+
+	unsigned short salt{ 0 };
+	memcpy(&salt, buffer + offset, sizeof(unsigned short));
+	offset += sizeof(unsigned short);
+
+	unsigned char flags{ 0 };
+	memcpy(&flags, buffer + offset, sizeof(unsigned char));
+	offset += sizeof(unsigned char);
+
+	unsigned short sequence{ 0 };
+	memcpy(&sequence, buffer + offset, sizeof(unsigned short));
+	offset += sizeof(unsigned short);
+
+	unsigned short ack{ 0 };
+	memcpy(&ack, buffer + offset, sizeof(unsigned short));
+	offset += sizeof(unsigned short);
+
+	unsigned int ackBits{ 0 };
+	memcpy(&ackBits, buffer + offset, sizeof(unsigned int));
+	offset += sizeof(unsigned int);
+
+	unsigned short ackSalt{ 0 };
+	memcpy(&ackSalt, buffer + offset, sizeof(unsigned short));
+	offset += sizeof(unsigned short);
+
+	// nothing is allocated for an endpoint until it has echoed a cookie, so spoofed floods stop here
+	Connection* existingConnection = FindConnection(from);
+	if (!existingConnection && handshakeRequired)
+	{
+		// challenge it anyway, since a real peer may just be talking to us after we dropped its Connection
+		networkStats.handshakeRejects++;
+		if (length >= HANDSHAKE_DATAGRAM_SIZE)
+			SendChallenge();
+		return;
+	}
+
+	Connection& connection = existingConnection ? *existingConnection : GetConnection(from);
+
+	// a peer that has started over has to say so in a Response to our challenge, or a late datagram from
+	// its previous run, or anyone spoofing its address, could reset the stream
+	if (!connection.MatchesRemoteSalt(salt))
+	{
+		networkStats.handshakeRejects++;
+		if (length >= HANDSHAKE_DATAGRAM_SIZE)
+			SendChallenge();
+		return;
+	}
+
+	connection.connected = true; // a peer that already has our challenge's answer may beat its Response here
+	connection.SetRemoteSalt(salt);
+	connection.peerSupportsCompression = (flags & DATAGRAM_FLAG_COMPRESSION) != 0;
+	connection.datagramsReceived++;
+	connection.bytesReceived += length;
+
+	// a peer still talking to a previous Connection of ours numbers its stream for that one; answer so it
+	// sees our new salt and starts over, but don't take its acks or messages until it has
+	const auto hasAck = (flags & DATAGRAM_FLAG_ACK) != 0;
+	if (hasAck && ackSalt != connection.salt)
+	{
+		connection.OnDatagramReceived(sequence);
+		connection.ackPending = true;
+		return;
+	}
+
+	if (hasAck)
+		connection.ProcessAcks(ack, ackBits, GetTime());
+
+	// duplicated datagrams still carry useful acks, but their messages were already handled
+	if (!connection.OnDatagramReceived(sequence))
+		return;
+
+	// the rest of the datagram is a sequence of messages, each with its own channel header
+	while (offset + static_cast<int>(sizeof(Channel) + sizeof(unsigned short)) <= length)
+	{
+		MessageHeader header;
+
+		unsigned char channelByte{ 0 };
+		memcpy(&channelByte, buffer + offset, sizeof(Channel));
+		offset += sizeof(Channel);
+		header.channel = static_cast<Channel>(channelByte & ~(FRAGMENT_FLAG | COMPRESSED_FLAG));
+		header.compressed = (channelByte & COMPRESSED_FLAG) != 0;
+		const auto isFragment = (channelByte & FRAGMENT_FLAG) != 0;
+
+		unsigned short messageLength{ 0 };
+		memcpy(&messageLength, buffer + offset, sizeof(unsigned short));
+		offset += sizeof(unsigned short);
+
+		if (header.channel != Channel::Unreliable)
+		{
+			if (offset + static_cast<int>(sizeof(unsigned short)) > length)
+			{
+				networkStats.malformedDatagrams++;
+				break;
+			}
+			memcpy(&header.messageId, buffer + offset, sizeof(unsigned short));
+			offset += sizeof(unsigned short);
+		}
+
+		if (isFragment)
 		{
-			std::string arg = "";
-			for (unsigned int i = offset; i < offset + bufferLength; i++)
+			if (header.channel != Channel::ReliableOrdered || offset + static_cast<int>(sizeof(unsigned char) * 2) > length)
 			{
-				if (buffer[i] == '|')
-				{
-					args.push_back(arg);
-					arg = "";
-				}
-				else
-					arg += buffer[i];
+				networkStats.malformedDatagrams++;
+				break;
 			}
+			header.fragmentIndex = static_cast<unsigned char>(buffer[offset++]);
+			header.fragmentCount = static_cast<unsigned char>(buffer[offset++]);
 		}
 
-		const auto fun = messageHandlers[opCode];
-		if (fun)
+		// a truncated or corrupt length means we can't trust anything after it
+		if (messageLength == 0 || offset + messageLength > length)
 		{
-			fun(args);
-			return true;
+			networkStats.malformedDatagrams++;
+			break;
 		}
 
-		return false;
+		connection.messagesReceived++;
+		ReceiveMessage(connection, header, buffer + offset, messageLength);
+		offset += messageLength;
 	}
+
 }
 
-void SocketManager::SendPacket(const sockaddr_in& to, const OpCode opCode, const std::vector<std::string>& args)
+// Handshake datagrams are a fixed size and never get a reply larger than themselves.
+void SocketManager::ReceiveHandshake(const char* buffer, const int length)
+{
+	if (length != HANDSHAKE_DATAGRAM_SIZE)
+	{
+		networkStats.malformedDatagrams++;
+		return;
+	}
+
+	int offset{ sizeof(int) };
+	unsigned char type{ 0 };
+	memcpy(&type, buffer + offset, sizeof(unsigned char));
+	offset += sizeof(unsigned char);
+
+	unsigned int timestamp{ 0 };
+	memcpy(&timestamp, buffer + offset, sizeof(unsigned int));
+	offset += sizeof(unsigned int);
+
+	unsigned __int64 cookie{ 0 };
+	memcpy(&cookie, buffer + offset, sizeof(unsigned __int64));
+	offset += sizeof(unsigned __int64);
+
+	unsigned short salt{ 0 };
+	memcpy(&salt, buffer + offset, sizeof(unsigned short));
+
+	switch (static_cast<HandshakeType>(type))
+	{
+	case HandshakeType::Request:
+		SendChallenge();
+		break;
+	case HandshakeType::Challenge:
+	{
+		// only answer endpoints we have something to say to, so a spoofed challenge can't make us reflect it
+		Connection* connection = FindConnection(from);
+		if (connection)
+		{
+			SendHandshake(from, HandshakeType::Response, timestamp, cookie, connection->salt);
+			connection->connected = true;
+		}
+		break;
+	}
+	case HandshakeType::Response:
+	{
+		if (handshakeRequired && !handshakeCookies.Verify(from, timestamp, cookie, static_cast<unsigned int>(GetTime())))
+		{
+			networkStats.handshakeRejects++;
+			break;
+		}
+		// the only way a peer that has started over gets its new salt accepted
+		Connection& connection = GetConnection(from);
+		connection.connected = true;
+		connection.SetRemoteSalt(salt);
+		break;
+	}
+	default:
+		networkStats.malformedDatagrams++;
+		break;
+	}
+}
+
+// Stateless: everything needed to check the Response is in the cookie.
+void SocketManager::SendChallenge()
 {
-	char buffer[PACKET_SIZE];
-	memset(buffer, 0, sizeof(buffer));
+	const auto timestamp = static_cast<unsigned int>(GetTime());
+	SendHandshake(from, HandshakeType::Challenge, timestamp, handshakeCookies.Create(from, timestamp), 0);
+}
+
+// salt is only read from a Response; the other types leave it 0.
+void SocketManager::SendHandshake(const sockaddr_in& to, const HandshakeType type, const unsigned int timestamp, const unsigned __int64 cookie, const unsigned short salt)
+{
+	char datagram[HANDSHAKE_DATAGRAM_SIZE];
 	int offset{ 0 };
+	memcpy(datagram + offset, &HANDSHAKE_CHECKSUM, sizeof(int));
+	offset += sizeof(int);
+	memcpy(datagram + offset, &type, sizeof(unsigned char));
+	offset += sizeof(unsigned char);
+	memcpy(datagram + offset, &timestamp, sizeof(unsigned int));
+	offset += sizeof(unsigned int);
+	memcpy(datagram + offset, &cookie, sizeof(unsigned __int64));
+	offset += sizeof(unsigned __int64);
+	memcpy(datagram + offset, &salt, sizeof(unsigned short));
+
+	WSABUF buffer;
+	buffer.buf = datagram;
+	buffer.len = HANDSHAKE_DATAGRAM_SIZE;
+	SendDatagram(to, &buffer, 1, HANDSHAKE_DATAGRAM_SIZE);
+	compressionStats.bytesSent += HANDSHAKE_DATAGRAM_SIZE;
+}
+
+void SocketManager::ReceiveMessage(Connection& connection, const MessageHeader& header, const char* message, const int length)
+{
+	switch (header.channel)
+	{
+		case Channel::Unreliable:
+		{
+			DeliverMessage(header.compressed, message, length);
+			break;
+		}
+		case Channel::ReliableOrdered:
+		{
+			// the sender needs an ack even if this turns out to be a resend we've already delivered
+			connection.ackPending = true;
+
+			if (connection.IsNextReliableMessage(header.messageId))
+			{
+				connection.AdvanceReliableMessageId();
+				ReceiveReliableMessage(connection, header, message, length);
+				DeliverBufferedReliableMessages(connection);
+			}
+			else if (connection.IsFutureReliableMessage(header.messageId) && connection.bufferedReliableMessages.size() < MAX_BUFFERED_RELIABLE_MESSAGES)
+			{
+				auto& bufferedMessage = connection.bufferedReliableMessages[header.messageId];
+				bufferedMessage.header = header;
+				bufferedMessage.data.assign(message, message + length);
+			}
+			break;
+		}
+	}
+}
+
+// Called in reliable message id order; whole messages go straight to their handler while
+// fragments are collected on the Connection until the message is complete.
+void SocketManager::ReceiveReliableMessage(Connection& connection, const MessageHeader& header, const char* message, const int length)
+{
+	if (header.fragmentCount <= 1)
+	{
+		DeliverMessage(header.compressed, message, length);
+		return;
+	}
+
+	if (connection.AddFragment(header.fragmentIndex, header.fragmentCount, message, length))
+	{
+		const auto& reassembledMessage = connection.GetReassembledMessage();
+		DeliverMessage(header.compressed, reassembledMessage.data(), static_cast<int>(reassembledMessage.size()));
+	}
+}
+
+void SocketManager::DeliverBufferedReliableMessages(Connection& connection)
+{
+	auto& bufferedMessages = connection.bufferedReliableMessages;
+	auto it = bufferedMessages.find(connection.GetNextExpectedReliableMessageId());
+	while (it != bufferedMessages.end())
+	{
+		const BufferedReliableMessage message{ std::move(it->second) };
+		bufferedMessages.erase(it);
+
+		connection.AdvanceReliableMessageId();
+		ReceiveReliableMessage(connection, message.header, message.data.data(), static_cast<int>(message.data.size()));
+
+		it = bufferedMessages.find(connection.GetNextExpectedReliableMessageId());
+	}
+}
+
+// Compressed payloads start with their uncompressed length; anything that doesn't decode cleanly is dropped.
+void SocketManager::DeliverMessage(const bool compressed, const char* message, const int length)
+{
+	if (!compressed)
+	{
+		HandleMessage(message, length, length);
+		return;
+	}
+
+	if (length <= static_cast<int>(sizeof(int)))
+	{
+		networkStats.decompressionFailures++;
+		return;
+	}
+
+	int uncompressedLength{ 0 };
+	memcpy(&uncompressedLength, message, sizeof(int));
+	if (uncompressedLength < static_cast<int>(sizeof(OpCode)) || uncompressedLength > MAX_MESSAGE_SIZE)
+	{
+		networkStats.decompressionFailures++;
+		return;
+	}
+
+	const auto start = GetCpuTime();
+	decompressionBuffer.resize(uncompressedLength);
+	const auto decompressed = Compression::Decompress(message + sizeof(int), length - sizeof(int), decompressionBuffer.data(), uncompressedLength);
+	compressionStats.decompressTime += GetCpuTime() - start;
+	if (!decompressed)
+	{
+		networkStats.decompressionFailures++;
+		return;
+	}
+
+	compressionStats.messagesDecompressed++;
+	HandleMessage(decompressionBuffer.data(), uncompressedLength, length);
+}
+
+// wireLength is the size the message arrived as, before decompression.
+void SocketManager::HandleMessage(const char* message, const int length, const int wireLength)
+{
+	if (length < static_cast<int>(sizeof(OpCode)))
+	{
+		networkStats.malformedDatagrams++;
+		return;
+	}
+
+	OpCode opCode{ };
+	memcpy(&opCode, message, sizeof(OpCode));
+
+	// before any lookup, string parsing or forwarding, so flooding a message costs its sender more than us
+	if (!rateLimiter.Allow(GetEndpointKey(from), opCode, GetTime()))
+	{
+		networkStats.opCodes[opCode].rateLimited++;
+		return;
+	}
+
+	// only OpCodes with a handler get an entry, so garbage from the wire can't grow the map
+	const auto binaryHandler = binaryMessageHandlers.find(opCode);
+	const auto isBinary = binaryHandler != binaryMessageHandlers.end();
+	const auto handler = messageHandlers.find(opCode);
+	if (!isBinary && (handler == messageHandlers.end() || !handler->second))
+	{
+		if (unhandledMessageHandler)
+			unhandledMessageHandler(opCode, message, length);
+		else
+			networkStats.unknownOpCodes++;
+		return;
+	}
+
+	TraceZone zone{ "HandleMessage", static_cast<int>(opCode) };
+
+	OpCodeStats& stats = networkStats.opCodes[opCode];
+	stats.received.messages++;
+	stats.received.bytes += wireLength;
+	const auto start = GetTime();
+
+	// bit-packed messages skip the '|' delimited parsing entirely
+	if (isBinary)
+	{
+		BitReader reader{ message + sizeof(OpCode), length - static_cast<int>(sizeof(OpCode)) };
+		binaryHandler->second(reader);
+		if (reader.Failed())
+			stats.decodeFailures++;
+		stats.handlerTime += GetTime() - start;
+		return;
+	}
+
+	std::vector<std::string> args;
+	std::string arg = "";
+	for (auto i = static_cast<int>(sizeof(OpCode)); i < length; i++)
+	{
+		if (message[i] == '|')
+		{
+			args.push_back(arg);
+			arg = "";
+		}
+		else
+			arg += message[i];
+	}
+
+	handler->second(args);
+	stats.handlerTime += GetTime() - start;
+}
+
+void SocketManager::AddNetworkStats(NetworkStats& total, const NetworkStats& stats)
+{
+	for (const auto& pair : stats.opCodes)
+	{
+		OpCodeStats& opCodeStats = total.opCodes[pair.first];
+		opCodeStats.sent.messages += pair.second.sent.messages;
+		opCodeStats.sent.bytes += pair.second.sent.bytes;
+		opCodeStats.received.messages += pair.second.received.messages;
+		opCodeStats.received.bytes += pair.second.received.bytes;
+		opCodeStats.handlerTime += pair.second.handlerTime;
+		opCodeStats.decodeFailures += pair.second.decodeFailures;
+		opCodeStats.rateLimited += pair.second.rateLimited;
+	}
+	total.checksumRejects += stats.checksumRejects;
+	total.malformedDatagrams += stats.malformedDatagrams;
+	total.decompressionFailures += stats.decompressionFailures;
+	total.unknownOpCodes += stats.unknownOpCodes;
+	total.handshakeRejects += stats.handshakeRejects;
+	total.connectionTimeouts += stats.connectionTimeouts;
+}
+
+const unsigned __int64 SocketManager::GetEndpointKey(const sockaddr_in& address)
+{
+	return (static_cast<unsigned __int64>(address.sin_addr.s_addr) << 16) | address.sin_port;
+}
+
+// Parses a comma separated list of ip:port endpoints, e.g. from the command line.
+const std::vector<sockaddr_in> SocketManager::ParseAddresses(const std::string& addresses)
+{
+	std::vector<sockaddr_in> parsedAddresses;
+	size_t start = 0;
+	while (start < addresses.length())
+	{
+		auto end = addresses.find(',', start);
+		if (end == std::string::npos)
+			end = addresses.length();
+
+		const auto entry = addresses.substr(start, end - start);
+		const auto separator = entry.find(':');
+		if (separator == std::string::npos)
+			throw std::exception("Expected ip:port,ip:port,...");
 
-	memcpy(buffer, &CHECKSUM, sizeof(OpCode));
-	offset += int{ sizeof(OpCode) };
+		sockaddr_in address;
+		ZeroMemory(&address, sizeof(address));
+		address.sin_family = AF_INET;
+		address.sin_port = htons(static_cast<u_short>(std::stoi(entry.substr(separator + 1))));
+		if (inet_pton(AF_INET, entry.substr(0, separator).c_str(), &address.sin_addr) != 1)
+			throw std::exception("Invalid ip address.");
 
-	memcpy(buffer + offset, &opCode, sizeof(OpCode));
-	offset += int{ sizeof(OpCode) };
+		parsedAddresses.push_back(address);
+		start = end + 1;
+	}
+	return parsedAddresses;
+}
+
+Connection& SocketManager::GetConnection(const sockaddr_in& address)
+{
+	const auto key = GetEndpointKey(address);
+	const auto it = connections.find(key);
+	if (it != connections.end())
+		return it->second;
+
+	// the salt tells the peer when we've thrown away our state for it
+	Connection& connection = connections[key];
+	connection.address = address;
+	connection.salt = static_cast<unsigned short>(rng());
+	connection.statsStartTime = GetTime();
+	connection.connected = !handshakeRequired;
+	return connection;
+}
 
-	std::string packet{ "" };
+Connection* SocketManager::FindConnection(const sockaddr_in& address)
+{
+	const auto it = connections.find(GetEndpointKey(address));
+	return it != connections.end() ? &it->second : nullptr;
+}
+
+// The Connection is only erased on the next FlushPackets, after its pending acks have gone out,
+// so it's safe to call this from inside a message handler.
+void SocketManager::RemoveConnection(const sockaddr_in& address)
+{
+	const auto it = connections.find(GetEndpointKey(address));
+	if (it != connections.end())
+		it->second.closing = true;
+}
+
+// The returned Packet holds one reference; call Release() once it has been sent to every recipient.
+Packet& SocketManager::CreatePacket(const OpCode opCode, const std::vector<std::string>& args)
+{
+	Packet& packet = packetPool.Acquire();
+	packet.Begin(opCode);
 	for (auto i = 0; i < args.size(); i++)
-		packet += args[i] + "|";
+		packet.Write(args[i]);
+	return packet;
+}
+
+void SocketManager::SendPacket(const sockaddr_in& to, const OpCode opCode, const std::vector<std::string>& args)
+{
+	Packet& packet = CreatePacket(opCode, args);
+	SendPacket(to, packet);
+	packet.Release();
+}
+
+// Nothing goes on the wire here: the Packet is queued on the endpoint's Connection, on the channel
+// its OpCode belongs to, and coalesced with everything else for that endpoint when FlushPackets runs.
+void SocketManager::SendPacket(const sockaddr_in& to, Packet& packet)
+{
+	Connection& connection = GetConnection(to);
+	const auto channel = GetChannel(packet.GetOpCode());
+
+	Packet* compressedPacket = nullptr;
+	if (compressionEnabled && connection.compressionEnabled && connection.peerSupportsCompression && packet.GetLength() >= compressionThreshold)
+		compressedPacket = GetCompressedPacket(packet);
+
+	Packet& queuedPacket = compressedPacket ? *compressedPacket : packet;
+	connection.Queue(queuedPacket, channel);
+
+	OpCodeTraffic& sent = networkStats.opCodes[packet.GetOpCode()].sent;
+	sent.messages++;
+	sent.bytes += queuedPacket.GetLength();
+}
+
+// Only affects messages sent to address; the peer can still compress what it sends us.
+void SocketManager::SetCompressionEnabled(const sockaddr_in& address, const bool enabled)
+{
+	GetConnection(address).compressionEnabled = enabled;
+}
+
+// Wraps an encoded message (OpCode first) up for another process to deliver to, or handle on behalf
+// of, endpoint. Messages that were reliable stay reliable on the way; everything else goes unreliable.
+// The returned Packet holds one reference, like CreatePacket's.
+Packet& SocketManager::CreateForwardPacket(const sockaddr_in& endpoint, const char* message, const int length)
+{
+	OpCode messageOpCode{ };
+	memcpy(&messageOpCode, message, sizeof(OpCode));
+	const auto opCode = GetChannel(messageOpCode) == Channel::ReliableOrdered ? OpCode::GatewayForward : OpCode::GatewayForwardUnreliable;
+
+	Packet& forwardPacket = packetPool.Acquire();
+	forwardPacket.Begin(opCode)
+		.Write(reinterpret_cast<const char*>(&endpoint.sin_addr), sizeof(in_addr))
+		.Write(reinterpret_cast<const char*>(&endpoint.sin_port), sizeof(u_short))
+		.Write(message, length);
+	return forwardPacket;
+}
+
+// Unwraps a message made by CreateForwardPacket; returns false if it's too short to hold one.
+const bool SocketManager::ReadForwardedMessage(BitReader& reader, sockaddr_in& endpoint, const char*& message, int& length)
+{
+	int remainderLength{ 0 };
+	const char* remainder = reader.ReadRemainder(remainderLength);
+	if (remainderLength < FORWARD_HEADER_SIZE + static_cast<int>(sizeof(OpCode)))
+		return false;
+
+	ZeroMemory(&endpoint, sizeof(endpoint));
+	endpoint.sin_family = AF_INET;
+	memcpy(&endpoint.sin_addr, remainder, sizeof(in_addr));
+	memcpy(&endpoint.sin_port, remainder + sizeof(in_addr), sizeof(u_short));
+	message = remainder + FORWARD_HEADER_SIZE;
+	length = remainderLength - FORWARD_HEADER_SIZE;
+	return true;
+}
+
+// Runs the handler for a message forwarded on behalf of endpoint as if endpoint had sent it directly,
+// so the handler validates and replies against the original sender.
+void SocketManager::HandleForwardedMessage(const sockaddr_in& endpoint, const char* message, const int length)
+{
+	const auto forwarder = from;
+	from = endpoint;
+	HandleMessage(message, length, length);
+	from = forwarder;
+}
+
+// The compressed copy is cached on the Packet, so a message broadcast to every client is only compressed once.
+// Returns nullptr if compression doesn't make the message any smaller.
+Packet* SocketManager::GetCompressedPacket(Packet& packet)
+{
+	if (packet.compressionAttempted)
+		return packet.compressedPacket;
 
-	strcpy_s(buffer + offset, packet.length() + 1, packet.c_str());
-	const auto sentBytes = sendto(sock, buffer, sizeof(buffer), 0, (sockaddr*)& to, sockaddr_in_len);
-	if (sentBytes != sizeof(buffer))
+	packet.compressionAttempted = true;
+
+	const auto start = GetCpuTime();
+	Packet& compressedPacket = packetPool.Acquire();
+	const auto success = compressedPacket.CompressFrom(packet);
+	compressionStats.compressTime += GetCpuTime() - start;
+
+	if (!success)
+	{
+		compressedPacket.Release();
+		return nullptr;
+	}
+
+	compressionStats.messagesCompressed++;
+	compressionStats.uncompressedBytes += packet.GetLength();
+	compressionStats.compressedBytes += compressedPacket.GetLength();
+	packet.compressedPacket = &compressedPacket;
+	return packet.compressedPacket;
+}
+
+const double SocketManager::GetTime() const
+{
+	if (clock)
+		return clock();
+
+	return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void SocketManager::FlushPackets()
+{
+	const auto now = GetTime();
+
+	auto it = connections.begin();
+	while (it != connections.end())
+	{
+		FlushConnection(it->second, now);
+
+		// a peer that has gone away would otherwise keep its Connection and queued Packets forever
+		if (!it->second.closing && it->second.HasTimedOut(now))
+		{
+			networkStats.connectionTimeouts++;
+			it->second.closing = true;
+		}
+
+		if (it->second.closing)
+		{
+			it->second.ReleasePackets();
+			it = connections.erase(it);
+		}
+		else
+			it++;
+	}
+
+	rateLimiter.Sweep(now);
+}
+
+// Packs reliable messages that are new or overdue for a resend, followed by this tick's unreliable
+// messages, into as few MAX_DATAGRAM_SIZE datagrams as possible. Every datagram piggybacks our acks
+// for the peer. Payloads are handed to WSASendTo as separate buffers so shared Packets are never copied.
+void SocketManager::FlushConnection(Connection& connection, const double now)
+{
+	// until the peer has challenged us, ask for a challenge instead; unreliable messages are dropped
+	// like any other lost datagram, and reliable ones wait for the handshake
+	if (!connection.connected)
+	{
+		if (!connection.reliableMessages.empty() || !connection.outgoingMessages.empty())
+		{
+			if (connection.lastHandshakeTime < 0.0 || now - connection.lastHandshakeTime >= HANDSHAKE_RESEND_INTERVAL)
+			{
+				SendHandshake(connection.address, HandshakeType::Request, 0, 0, 0);
+				connection.lastHandshakeTime = now;
+				if (connection.firstHandshakeTime < 0.0)
+					connection.firstHandshakeTime = now;
+			}
+		}
+
+		for (auto j = 0; j < connection.outgoingMessages.size(); j++)
+			connection.outgoingMessages[j].packet->Release();
+		connection.outgoingMessages.clear();
+		return;
+	}
+
+	const auto resendTimeout = connection.GetResendTimeout();
+
+	// the rest of the queue waits until acks for the front move the window on, which also keeps every id
+	// in flight well within SequenceGreaterThan's range
+	const auto inFlightCount = Utility::Min<int>(static_cast<int>(connection.reliableMessages.size()), MAX_RELIABLE_MESSAGES_IN_FLIGHT);
+	std::vector<ReliableMessage*> dueReliableMessages;
+	for (auto i = 0; i < inFlightCount; i++)
+	{
+		ReliableMessage& message = connection.reliableMessages[i];
+		if (!message.acked && (message.lastSendTime < 0.0 || now - message.lastSendTime >= resendTimeout))
+			dueReliableMessages.push_back(&message);
+	}
+
+	auto& outgoingMessages = connection.outgoingMessages;
+	const auto messageCount = static_cast<int>(dueReliableMessages.size() + outgoingMessages.size());
+	if (messageCount == 0 && !connection.ackPending)
+		return;
+
+	// the smallest possible message is an unreliable one with an empty payload besides its OpCode
+	constexpr auto MAX_MESSAGES_PER_DATAGRAM = (MAX_DATAGRAM_SIZE - DATAGRAM_HEADER_SIZE) / static_cast<int>(sizeof(Channel) + sizeof(unsigned short) + sizeof(OpCode));
+	WSABUF buffers[1 + MAX_MESSAGES_PER_DATAGRAM * 2];
+	char header[DATAGRAM_HEADER_SIZE];
+	char messageHeaders[MAX_MESSAGES_PER_DATAGRAM][MAX_MESSAGE_HEADER_SIZE];
+	std::vector<unsigned short> reliableMessageIds;
+
+	auto i = 0;
+	do
+	{
+		const auto sequence = connection.NextSequence();
+		const auto ack = connection.GetAck();
+		const auto ackBits = connection.GetAckBits();
+		const auto ackSalt = connection.GetRemoteSalt();
+		// every build can decompress, whether or not it compresses what it sends
+		const auto flags = static_cast<unsigned char>(DATAGRAM_FLAG_COMPRESSION | (connection.HasAck() ? DATAGRAM_FLAG_ACK : 0));
+		connection.ackPending = false;
+
+		int offset{ 0 };
+		memcpy(header + offset, &CHECKSUM, sizeof(OpCode));
+		offset += sizeof(OpCode);
+		memcpy(header + offset, &connection.salt, sizeof(unsigned short));
+		offset += sizeof(unsigned short);
+		memcpy(header + offset, &flags, sizeof(unsigned char));
+		offset += sizeof(unsigned char);
+		memcpy(header + offset, &sequence, sizeof(unsigned short));
+		offset += sizeof(unsigned short);
+		memcpy(header + offset, &ack, sizeof(unsigned short));
+		offset += sizeof(unsigned short);
+		memcpy(header + offset, &ackBits, sizeof(unsigned int));
+		offset += sizeof(unsigned int);
+		memcpy(header + offset, &ackSalt, sizeof(unsigned short));
+
+		auto bufferCount = 0;
+		auto datagramMessageCount = 0;
+		auto datagramSize = DATAGRAM_HEADER_SIZE;
+		buffers[bufferCount].buf = header;
+		buffers[bufferCount++].len = DATAGRAM_HEADER_SIZE;
+		reliableMessageIds.clear();
+
+		while (i < messageCount && datagramMessageCount < MAX_MESSAGES_PER_DATAGRAM)
+		{
+			const auto isReliable = i < dueReliableMessages.size();
+			const ReliableMessage* reliableMessage = isReliable ? dueReliableMessages[i] : nullptr;
+			const OutgoingMessage* outgoingMessage = isReliable ? nullptr : &outgoingMessages[i - dueReliableMessages.size()];
+			const auto channel = isReliable ? Channel::ReliableOrdered : outgoingMessage->channel;
+			const auto messageId = isReliable ? reliableMessage->messageId : static_cast<unsigned short>(0);
+			const auto isFragment = isReliable && reliableMessage->fragmentCount > 1;
+			const auto isCompressed = isReliable ? reliableMessage->packet->IsCompressed() : outgoingMessage->packet->IsCompressed();
+			const char* payload = isReliable ? reliableMessage->packet->GetData() + reliableMessage->fragmentOffset : outgoingMessage->packet->GetData();
+			const auto payloadLength = isReliable ? reliableMessage->fragmentLength : outgoingMessage->packet->GetLength();
+
+			auto messageHeaderSize = static_cast<int>(sizeof(Channel) + sizeof(unsigned short));
+			if (channel != Channel::Unreliable)
+				messageHeaderSize += sizeof(unsigned short);
+			if (isFragment)
+				messageHeaderSize += sizeof(unsigned char) * 2;
+
+			const auto messageSize = messageHeaderSize + payloadLength;
+			if (datagramMessageCount > 0 && datagramSize + messageSize > MAX_DATAGRAM_SIZE)
+				break;
+
+			char* messageHeader = messageHeaders[datagramMessageCount];
+			auto messageHeaderOffset = 0;
+			const auto channelByte = static_cast<unsigned char>(static_cast<unsigned char>(channel) | (isFragment ? FRAGMENT_FLAG : 0) | (isCompressed ? COMPRESSED_FLAG : 0));
+			const auto messageLength = static_cast<unsigned short>(payloadLength);
+			memcpy(messageHeader + messageHeaderOffset, &channelByte, sizeof(Channel));
+			messageHeaderOffset += sizeof(Channel);
+			memcpy(messageHeader + messageHeaderOffset, &messageLength, sizeof(unsigned short));
+			messageHeaderOffset += sizeof(unsigned short);
+			if (channel != Channel::Unreliable)
+			{
+				memcpy(messageHeader + messageHeaderOffset, &messageId, sizeof(unsigned short));
+				messageHeaderOffset += sizeof(unsigned short);
+			}
+			if (isFragment)
+			{
+				messageHeader[messageHeaderOffset++] = static_cast<char>(reliableMessage->fragmentIndex);
+				messageHeader[messageHeaderOffset++] = static_cast<char>(reliableMessage->fragmentCount);
+			}
+
+			buffers[bufferCount].buf = messageHeader;
+			buffers[bufferCount++].len = messageHeaderSize;
+			buffers[bufferCount].buf = (CHAR*)payload;
+			buffers[bufferCount++].len = payloadLength;
+
+			if (isReliable)
+			{
+				if (dueReliableMessages[i]->firstSendTime < 0.0)
+					dueReliableMessages[i]->firstSendTime = now;
+				dueReliableMessages[i]->lastSendTime = now;
+				reliableMessageIds.push_back(messageId);
+			}
+
+			datagramSize += messageSize;
+			datagramMessageCount++;
+			i++;
+		}
+
+		connection.OnDatagramSent(sequence, now, reliableMessageIds);
+		SendDatagram(connection.address, buffers, bufferCount, datagramSize);
+		compressionStats.bytesSent += datagramSize;
+	} while (i < messageCount);
+
+	for (auto j = 0; j < outgoingMessages.size(); j++)
+		outgoingMessages[j].packet->Release();
+	outgoingMessages.clear();
+}
+
+void SocketManager::SendDatagram(const sockaddr_in& to, WSABUF* buffers, const int bufferCount, const int datagramSize)
+{
+	if (outboundCapture)
+	{
+		outboundCapture->Write(to, buffers, bufferCount, datagramSize);
+		return;
+	}
+
+	if (networkSimulator)
+	{
+		networkSimulator->Submit(SimulatedDirection::Outbound, to, buffers, bufferCount, GetTime());
+		return;
+	}
+
+	DWORD sentBytes{ 0 };
+	const auto result = WSASendTo(sock, buffers, bufferCount, &sentBytes, 0, (sockaddr*)& to, sockaddr_in_len, NULL, NULL);
+	if (result == SOCKET_ERROR || sentBytes != datagramSize)
 		throw std::exception("Failed to send packet.");
 }
 
 void SocketManager::ProcessPackets()
 {
 	while (TryRecieveMessage()) {}
+
+	if (networkSimulator)
+		ReleaseSimulatedDatagrams();
+}
+
+// Blocks until a datagram arrives, the simulated network has one due, or timeout seconds pass.
+// select only takes whole milliseconds here, so the timeout is rounded down and anything under a
+// millisecond returns straight away; the caller loops back round rather than oversleeping a deadline.
+void SocketManager::WaitForPackets(const double timeout)
+{
+	auto wait = timeout;
+	if (networkSimulator)
+		wait = Utility::Min(wait, networkSimulator->GetNextReleaseTime() - GetTime());
+
+	const auto milliseconds = static_cast<long>(wait * 1000.0);
+	if (milliseconds <= 0)
+		return;
+
+	fd_set readSet;
+	FD_ZERO(&readSet);
+	FD_SET(sock, &readSet);
+	timeval selectTimeout{ milliseconds / 1000, (milliseconds % 1000) * 1000 };
+
+	// the first argument is ignored by Winsock, but keeps this portable to BSD sockets
+	if (select(static_cast<int>(sock) + 1, &readSet, NULL, NULL, &selectTimeout) == SOCKET_ERROR)
+		throw std::exception("SocketManager failed waiting for packets.");
+}
+
+// Sends or handles whatever the simulated network has held back long enough.
+void SocketManager::ReleaseSimulatedDatagrams()
+{
+	SimulatedDatagram datagram;
+	while (networkSimulator && networkSimulator->Release(GetTime(), datagram))
+	{
+		if (datagram.direction == SimulatedDirection::Inbound)
+		{
+			DeliverDatagram(datagram.address, datagram.data.data(), static_cast<int>(datagram.data.size()));
+			continue;
+		}
+
+		WSABUF buffer;
+		buffer.buf = datagram.data.data();
+		buffer.len = static_cast<ULONG>(datagram.data.size());
+		DWORD sentBytes{ 0 };
+		const auto result = WSASendTo(sock, &buffer, 1, &sentBytes, 0, (sockaddr*)& datagram.address, sockaddr_in_len, NULL, NULL);
+		if (result == SOCKET_ERROR || sentBytes != buffer.len)
+			throw std::exception("Failed to send packet.");
+	}
+}
+
+// Only affects what we send; peers are still told we can decompress, so they can compress what they send us.
+void SocketManager::SetCompressionEnabled(const bool enabled) { compressionEnabled = enabled; }
+
+void SocketManager::SetCompressionThreshold(const int threshold) { compressionThreshold = threshold; }
+
+const CompressionStats& SocketManager::GetCompressionStats() const { return compressionStats; }
+
+void SocketManager::ResetCompressionStats() { compressionStats = CompressionStats{}; }
+
+const NetworkStats& SocketManager::GetNetworkStats() const { return networkStats; }
+
+// Counters since startup, unaffected by ResetNetworkStats, for anything that wants monotonic totals.
+const NetworkStats SocketManager::GetNetworkTotals() const
+{
+	NetworkStats totals{ networkTotals };
+	AddNetworkStats(totals, networkStats);
+	return totals;
+}
+
+// Inbound rates per endpoint since the last reset, or since the endpoint first sent us anything.
+const std::vector<SessionStats> SocketManager::GetSessionStats() const
+{
+	const auto now = GetTime();
+	std::vector<SessionStats> sessions;
+	for (const auto& pair : connections)
+	{
+		const Connection& connection = pair.second;
+		const auto elapsed = Utility::Max<double>(now - connection.statsStartTime, 0.001);
+		sessions.push_back(SessionStats{
+			connection.address,
+			connection.datagramsReceived / elapsed,
+			connection.messagesReceived / elapsed,
+			connection.bytesReceived / elapsed });
+	}
+	return sessions;
+}
+
+void SocketManager::ResetNetworkStats()
+{
+	const auto now = GetTime();
+	AddNetworkStats(networkTotals, networkStats);
+	networkStats = NetworkStats{};
+	networkStats.startTime = now;
+	for (auto& pair : connections)
+	{
+		Connection& connection = pair.second;
+		connection.datagramsReceived = 0;
+		connection.messagesReceived = 0;
+		connection.bytesReceived = 0;
+		connection.statsStartTime = now;
+	}
+}
+
+const int SocketManager::GetConnectionCount() const { return static_cast<int>(connections.size()); }
+
+// Handles a datagram as if it had just been received from address; used to replay captures.
+void SocketManager::InjectDatagram(const sockaddr_in& address, const char* data, const int length)
+{
+	from = address;
+	ReceiveDatagram(data, length);
+}
+
+// Records every datagram received from the socket, until set back to nullptr.
+void SocketManager::SetInboundCapture(PacketCaptureWriter* capture) { inboundCapture = capture; }
+
+// Records outgoing datagrams instead of sending them, until set back to nullptr.
+void SocketManager::SetOutboundCapture(PacketCaptureWriter* capture) { outboundCapture = capture; }
+
+// Replaces the steady clock for everything time-based in the transport, so a replay doesn't depend on how fast it runs.
+void SocketManager::SetClock(std::function<const double()> clock) { this->clock = clock; }
+
+// Also derives the cookie key from the seed, so seeded runs send the same challenges.
+void SocketManager::SeedRandom(const unsigned int seed)
+{
+	rng.seed(seed);
+	const auto key0 = static_cast<unsigned __int64>(rng()) << 32 | rng();
+	const auto key1 = static_cast<unsigned __int64>(rng()) << 32 | rng();
+	handshakeCookies.SetKey(key0, key1);
+}
+
+// Limits apply per sending endpoint, which for messages forwarded by a gateway is the client.
+void SocketManager::SetRateLimits(const RateLimits& limits) { rateLimiter.SetLimits(limits); }
+
+void SocketManager::SetHandshakeRequired(const bool required) { handshakeRequired = required; }
+
+// Routes every datagram in both directions through a simulated network until disabled. Change its
+// conditions through the returned NetworkSimulator at any time.
+NetworkSimulator& SocketManager::EnableNetworkSimulator(const unsigned int seed)
+{
+	if (!networkSimulator)
+		networkSimulator = std::make_unique<NetworkSimulator>(seed);
+	return *networkSimulator;
 }
 
+// Anything still held back by the simulator is dropped, like datagrams in flight on a link that went down.
+void SocketManager::DisableNetworkSimulator() { networkSimulator.reset(); }
+
+NetworkSimulator* SocketManager::GetNetworkSimulator() const { return networkSimulator.get(); }
+
 void SocketManager::CloseSockets()
 {
 	closesocket(sock);
@@ -2,10 +2,99 @@
 
 #include <OpCodes.h>
 #include "EventHandling/EventHandler.h"
+#include "Networking/PacketPool.h"
+#include "Networking/Connection.h"
+#include "Networking/Compression.h"
+#include "Networking/BitReader.h"
+#include "Networking/PacketCapture.h"
+#include "Networking/NetworkSimulator.h"
+#include "Networking/Handshake.h"
+#include "Networking/RateLimiter.h"
+
+// Counters for picking a compression threshold; divide by ticks and connections for per-client figures.
+struct CompressionStats
+{
+	int messagesCompressed{ 0 };
+	int messagesDecompressed{ 0 };
+	__int64 uncompressedBytes{ 0 }; // original size of the messages that were compressed
+	__int64 compressedBytes{ 0 };
+	__int64 bytesSent{ 0 };         // every datagram, headers included
+	double compressTime{ 0.0 };     // seconds
+	double decompressTime{ 0.0 };   // seconds
+};
+
+struct OpCodeTraffic
+{
+	int messages{ 0 };
+	__int64 bytes{ 0 }; // payload as it went on the wire, OpCode included
+};
+
+struct OpCodeStats
+{
+	OpCodeTraffic sent;
+	OpCodeTraffic received;
+	double handlerTime{ 0.0 }; // seconds
+	int decodeFailures{ 0 };   // binary messages whose handler read past the end of the payload
+	int rateLimited{ 0 };      // dropped because the sender was over its RateLimit
+};
+
+// Per-OpCode traffic plus the rejects that happen before a message can be attributed to an OpCode.
+struct NetworkStats
+{
+	std::map<OpCode, OpCodeStats> opCodes;
+	int checksumRejects{ 0 };
+	int malformedDatagrams{ 0 };
+	int decompressionFailures{ 0 };
+	int unknownOpCodes{ 0 };
+	int handshakeRejects{ 0 }; // datagrams from endpoints that haven't echoed a cookie, and bad cookies
+	int connectionTimeouts{ 0 }; // Connections dropped because the peer stopped acking
+	double startTime{ 0.0 };
+};
+
+struct SessionStats
+{
+	sockaddr_in address;
+	double datagramsPerSecond;
+	double messagesPerSecond;
+	double bytesPerSecond;
+};
 
 class SocketManager
 {
+	std::map<unsigned __int64, Connection> connections;
+	bool compressionEnabled{ true }; // whether we compress what we send; receiving always supports it
+	int compressionThreshold{ COMPRESSION_THRESHOLD };
+	std::vector<char> decompressionBuffer;
+	CompressionStats compressionStats;
+	NetworkStats networkStats;
+	NetworkStats networkTotals; // everything before the last ResetNetworkStats
+	std::mt19937 rng{ std::random_device{}() };
+	std::function<const double()> clock;
+	PacketCaptureWriter* inboundCapture{ nullptr };
+	PacketCaptureWriter* outboundCapture{ nullptr };
+	std::unique_ptr<NetworkSimulator> networkSimulator;
+	HandshakeCookies handshakeCookies;
+	bool handshakeRequired{ true };
+	RateLimiter rateLimiter;
+
 	bool TryRecieveMessage();
+	void DeliverDatagram(const sockaddr_in& address, const char* buffer, const int length);
+	void ReceiveDatagram(const char* buffer, const int length);
+	void ReceiveHandshake(const char* buffer, const int length);
+	void SendChallenge();
+	void SendHandshake(const sockaddr_in& to, const HandshakeType type, const unsigned int timestamp, const unsigned __int64 cookie, const unsigned short salt);
+	Connection* FindConnection(const sockaddr_in& address);
+	void ReleaseSimulatedDatagrams();
+	void ReceiveMessage(Connection& connection, const MessageHeader& header, const char* message, const int length);
+	void ReceiveReliableMessage(Connection& connection, const MessageHeader& header, const char* message, const int length);
+	void DeliverBufferedReliableMessages(Connection& connection);
+	void DeliverMessage(const bool compressed, const char* message, const int length);
+	Packet* GetCompressedPacket(Packet& packet);
+	void HandleMessage(const char* message, const int length, const int wireLength);
+	void FlushConnection(Connection& connection, const double now);
+	void SendDatagram(const sockaddr_in& to, WSABUF* buffers, const int bufferCount, const int datagramSize);
+
+	static void AddNetworkStats(NetworkStats& total, const NetworkStats& stats);
 
 protected:
 	EventHandler& eventHandler;
@@ -13,14 +102,50 @@ protected:
 	sockaddr_in local;
 	SOCKET sock;
 	sockaddr_in from;
+	PacketPool packetPool;
 	std::map<OpCode, std::function<void(std::vector<std::string>& args)>> messageHandlers;
+	std::map<OpCode, std::function<void(BitReader& reader)>> binaryMessageHandlers;
+	std::function<void(const OpCode opCode, const char* message, const int length)> unhandledMessageHandler; // gets messages no other handler takes, e.g. to forward them
 
 	SocketManager(EventHandler& eventHandler, const int localPort = 0);
 	virtual void InitializeMessageHandlers() = 0;
+	Connection& GetConnection(const sockaddr_in& address);
+	void RemoveConnection(const sockaddr_in& address);
+	Packet& CreatePacket(const OpCode opCode, const std::vector<std::string>& args);
 	void SendPacket(const sockaddr_in& to, const OpCode opCode, const std::vector<std::string>& args);
+	void SendPacket(const sockaddr_in& to, Packet& packet);
+	void SetCompressionEnabled(const sockaddr_in& address, const bool enabled);
+	Packet& CreateForwardPacket(const sockaddr_in& endpoint, const char* message, const int length);
+	void HandleForwardedMessage(const sockaddr_in& endpoint, const char* message, const int length);
+	const double GetTime() const;
+
+	static const bool ReadForwardedMessage(BitReader& reader, sockaddr_in& endpoint, const char*& message, int& length);
 
 public:
 	void ProcessPackets();
+	void WaitForPackets(const double timeout);
+	void FlushPackets();
 	void CloseSockets();
+	void SetCompressionEnabled(const bool enabled);
+	void SetCompressionThreshold(const int threshold);
+	const CompressionStats& GetCompressionStats() const;
+	void ResetCompressionStats();
+	const NetworkStats& GetNetworkStats() const;
+	const NetworkStats GetNetworkTotals() const;
+	const std::vector<SessionStats> GetSessionStats() const;
+	void ResetNetworkStats();
+	const int GetConnectionCount() const;
+	void InjectDatagram(const sockaddr_in& address, const char* data, const int length);
+	void SetInboundCapture(PacketCaptureWriter* capture);
+	void SetOutboundCapture(PacketCaptureWriter* capture);
+	void SetClock(std::function<const double()> clock);
+	void SeedRandom(const unsigned int seed);
+	void SetRateLimits(const RateLimits& limits);
+	void SetHandshakeRequired(const bool required); // off accepts endpoints that never did the handshake, e.g. when replaying a capture
+	NetworkSimulator& EnableNetworkSimulator(const unsigned int seed);
+	void DisableNetworkSimulator();
+	NetworkSimulator* GetNetworkSimulator() const;
 
+	static const unsigned __int64 GetEndpointKey(const sockaddr_in& address);
+	static const std::vector<sockaddr_in> ParseAddresses(const std::string& addresses);
 };
\ No newline at end of file
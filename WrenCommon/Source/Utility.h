@@ -13,6 +13,7 @@ public:
 	static void GetMapTileXYFromPos(const XMFLOAT3 pos, int& row, int& col);
 	static const bool AreOnAdjacentOrDiagonalTiles(const XMFLOAT3 pos1, const XMFLOAT3 pos2);
 	template <typename T> static const T Max(const T l, const T r);
+	template <typename T> static const T Min(const T l, const T r);
 };
 
 template <typename T>
@@ -21,5 +22,14 @@ const T Utility::Max(const T l, const T r)
 	if (r > l)
 		return r;
 
+	return l;
+}
+
+template <typename T>
+const T Utility::Min(const T l, const T r)
+{
+	if (r < l)
+		return r;
+
 	return l;
 }
\ No newline at end of file
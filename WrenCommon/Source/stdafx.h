@@ -23,6 +23,14 @@
 #include <map>
 #include <list>
 #include <queue>
+#include <deque>
+#include <chrono>
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <iomanip>
+#include <ctime>
+#include <random>
 #include <DirectXMath.h>
 #include <codecvt>
 #include <iostream>
@@ -0,0 +1,263 @@
+#include "stdafx.h"
+#include "GatewaySocketManager.h"
+
+constexpr auto INCORRECT_USERNAME = "Incorrect Username.";
+constexpr auto INCORRECT_PASSWORD = "Incorrect Password.";
+constexpr auto ACCOUNT_ALREADY_EXISTS = "Account already exists.";
+constexpr auto LIBSODIUM_MEMORY_ERROR = "Ran out of memory while hashing password.";
+
+GatewaySocketManager::GatewaySocketManager(EventHandler& eventHandler, ServerRepository& serverRepository, const std::vector<sockaddr_in>& simulations, const int port)
+	: SocketManager{ eventHandler, port },
+	  serverRepository{ serverRepository },
+	  simulations{ simulations }
+{
+	if (simulations.empty())
+		throw std::exception("WrenGateway needs at least one simulation.");
+
+	sodium_init();
+	InitializeMessageHandlers();
+
+	// the simulations are on loopback, where compressing costs more than it saves
+	for (const auto& simulation : simulations)
+		SetCompressionEnabled(simulation, false);
+}
+
+// Returns the index of the simulation at address, or -1 for anything else, e.g. a client.
+const int GatewaySocketManager::FindSimulation(const sockaddr_in& address) const
+{
+	const auto key = GetEndpointKey(address);
+	for (auto i = 0; i < simulations.size(); i++)
+	{
+		if (GetEndpointKey(simulations[i]) == key)
+			return i;
+	}
+	return -1;
+}
+
+const int GatewaySocketManager::GetLeastLoadedSimulation() const
+{
+	std::vector<int> sessionCounts(simulations.size(), 0);
+	for (const auto& pair : sessions)
+		sessionCounts[pair.second.simulation]++;
+
+	return static_cast<int>(std::min_element(sessionCounts.begin(), sessionCounts.end()) - sessionCounts.begin());
+}
+
+GatewaySession* GatewaySocketManager::FindSession(const sockaddr_in& address)
+{
+	const auto it = sessions.find(GetEndpointKey(address));
+	return it == sessions.end() ? nullptr : &it->second;
+}
+
+// Checks the password here, so the hashing never holds up a simulation's tick, then has the client's
+// simulation log it in. LoginSuccess comes back from the simulation like any other reply.
+void GatewaySocketManager::Login(const std::string& accountName, const std::string& password)
+{
+	std::string error;
+	const auto account = serverRepository.GetAccount(accountName);
+	if (!account)
+		error = INCORRECT_USERNAME;
+	else if (crypto_pwhash_str_verify(account->GetPassword().c_str(), password.c_str(), strlen(password.c_str())) != 0)
+		error = INCORRECT_PASSWORD;
+
+	if (error != "")
+	{
+		std::vector<std::string> args{ error };
+		SendPacket(from, OpCode::LoginFailure, args);
+		return;
+	}
+
+	// logging in again from the same endpoint stays on the same simulation
+	GatewaySession* session = FindSession(from);
+	if (!session)
+	{
+		session = &sessions[GetEndpointKey(from)];
+		session->address = from;
+		session->simulation = GetLeastLoadedSimulation();
+	}
+	session->lastReceiveTime = GetTime();
+	stats.logins++;
+
+	// the same ipAndPort the simulation would have made from the client's address itself
+	char clientAddress[INET_ADDRSTRLEN];
+	ZeroMemory(clientAddress, sizeof(clientAddress));
+	inet_ntop(AF_INET, &(from.sin_addr), clientAddress, INET_ADDRSTRLEN);
+	const auto ipAndPort = std::string{ clientAddress } + ":" + std::to_string(from.sin_port);
+
+	std::vector<std::string> args{ std::to_string(account->GetId()), ipAndPort, std::string{ clientAddress }, std::to_string(ntohs(from.sin_port)) };
+	SendPacket(simulations[session->simulation], OpCode::GatewayLogin, args);
+}
+
+void GatewaySocketManager::CreateAccount(const std::string& accountName, const std::string& password)
+{
+	if (serverRepository.AccountExists(accountName))
+	{
+		std::vector<std::string> args{ ACCOUNT_ALREADY_EXISTS };
+		SendPacket(from, OpCode::CreateAccountFailure, args);
+		return;
+	}
+
+	char hashedPassword[crypto_pwhash_STRBYTES];
+	const auto passwordArr = password.c_str();
+	const auto result = crypto_pwhash_str(
+		hashedPassword,
+		passwordArr,
+		strlen(passwordArr),
+		crypto_pwhash_OPSLIMIT_INTERACTIVE,
+		crypto_pwhash_MEMLIMIT_INTERACTIVE);
+	if (result != 0)
+		throw std::exception(LIBSODIUM_MEMORY_ERROR);
+
+	serverRepository.CreateAccount(accountName, std::string{ hashedPassword });
+	SendPacket(from, OpCode::CreateAccountSuccess, std::vector<std::string>{});
+}
+
+// Only logged in clients get anything through to a simulation.
+void GatewaySocketManager::ForwardToSimulation(const char* message, const int length)
+{
+	GatewaySession* session = FindSession(from);
+	if (!session)
+	{
+		stats.messagesDropped++;
+		return;
+	}
+	session->lastReceiveTime = GetTime();
+
+	Packet& packet = CreateForwardPacket(from, message, length);
+	SendPacket(simulations[session->simulation], packet);
+	packet.Release();
+	stats.messagesForwarded++;
+}
+
+// Sends a simulation's reply on to its client. A ZoneTransfer to another of our simulations just moves
+// the session over to it, since the client is only ever talking to the gateway.
+void GatewaySocketManager::RelayToClient(BitReader& reader)
+{
+	sockaddr_in client;
+	const char* message{ nullptr };
+	int length{ 0 };
+	const auto simulation = FindSimulation(from);
+	GatewaySession* session = nullptr;
+	if (simulation != -1 && ReadForwardedMessage(reader, client, message, length))
+		session = FindSession(client);
+
+	// a simulation that has handed the client off can still have replies in flight
+	if (!session || session->simulation != simulation)
+	{
+		stats.messagesDropped++;
+		return;
+	}
+
+	OpCode opCode{ };
+	memcpy(&opCode, message, sizeof(OpCode));
+	if (opCode == OpCode::ZoneTransfer)
+	{
+		// ip|port|
+		const std::string args{ message + sizeof(OpCode), static_cast<size_t>(length) - sizeof(OpCode) };
+		const auto separator = args.find('|');
+		const auto end = args.find('|', separator + 1);
+		if (separator != std::string::npos && end != std::string::npos)
+		{
+			const auto zone = args.substr(0, separator) + ":" + args.substr(separator + 1, end - separator - 1);
+			const auto target = FindSimulation(SocketManager::ParseAddresses(zone).front());
+			if (target != -1)
+			{
+				session->simulation = target;
+				return;
+			}
+		}
+	}
+
+	Packet& packet = packetPool.Acquire();
+	packet.Begin(opCode).Write(message + sizeof(OpCode), length - static_cast<int>(sizeof(OpCode)));
+	SendPacket(client, packet);
+	packet.Release();
+	stats.messagesRelayed++;
+}
+
+void GatewaySocketManager::CloseSession(const sockaddr_in& address)
+{
+	RemoveConnection(address);
+	sessions.erase(GetEndpointKey(address));
+}
+
+// Drops clients that have gone quiet and tells their simulation to log them out.
+void GatewaySocketManager::HandleTimeouts()
+{
+	const auto now = GetTime();
+	for (auto it = sessions.begin(); it != sessions.end();)
+	{
+		const GatewaySession& session = it->second;
+		if (now - session.lastReceiveTime <= GATEWAY_SESSION_TIMEOUT)
+		{
+			it++;
+			continue;
+		}
+
+		char clientAddress[INET_ADDRSTRLEN];
+		ZeroMemory(clientAddress, sizeof(clientAddress));
+		inet_ntop(AF_INET, &(session.address.sin_addr), clientAddress, INET_ADDRSTRLEN);
+		std::vector<std::string> args{ std::string{ clientAddress }, std::to_string(ntohs(session.address.sin_port)) };
+		SendPacket(simulations[session.simulation], OpCode::GatewayDisconnect, args);
+
+		RemoveConnection(session.address);
+		it = sessions.erase(it);
+		stats.timeouts++;
+	}
+}
+
+const int GatewaySocketManager::GetSessionCount() const { return static_cast<int>(sessions.size()); }
+
+const GatewayStats& GatewaySocketManager::GetStats() const { return stats; }
+
+void GatewaySocketManager::ResetStats() { stats = GatewayStats{}; }
+
+void GatewaySocketManager::InitializeMessageHandlers()
+{
+	messageHandlers[OpCode::Connect] = [this](const std::vector<std::string>& args)
+	{
+		const std::string& accountName = args.at(0);
+		const std::string& password = args.at(1);
+
+		Login(accountName, password);
+	};
+
+	messageHandlers[OpCode::CreateAccount] = [this](const std::vector<std::string>& args)
+	{
+		const std::string& accountName = args.at(0);
+		const std::string& password = args.at(1);
+
+		CreateAccount(accountName, password);
+	};
+
+	// heartbeats only keep the session alive, so they stop here
+	messageHandlers[OpCode::Heartbeat] = [this](const std::vector<std::string>& args)
+	{
+		GatewaySession* session = FindSession(from);
+		if (session)
+			session->lastReceiveTime = GetTime();
+	};
+
+	// everything else a client sends goes to its simulation as is
+	unhandledMessageHandler = [this](const OpCode opCode, const char* message, const int length)
+	{
+		if (FindSimulation(from) == -1)
+			ForwardToSimulation(message, length);
+	};
+
+	binaryMessageHandlers[OpCode::GatewayForward] = [this](BitReader& reader) { RelayToClient(reader); };
+	binaryMessageHandlers[OpCode::GatewayForwardUnreliable] = [this](BitReader& reader) { RelayToClient(reader); };
+
+	// the simulation logged the client out
+	messageHandlers[OpCode::GatewayDisconnect] = [this](const std::vector<std::string>& args)
+	{
+		const auto simulation = FindSimulation(from);
+		if (simulation == -1)
+			return;
+
+		const auto client = SocketManager::ParseAddresses(args.at(0) + ":" + args.at(1)).front();
+		const GatewaySession* session = FindSession(client);
+		if (session && session->simulation == simulation)
+			CloseSession(client);
+	};
+}
\ No newline at end of file
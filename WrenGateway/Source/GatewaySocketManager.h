@@ -0,0 +1,56 @@
+#pragma once
+
+#include <SocketManager.h>
+#include <OpCodes.h>
+#include <Constants.h>
+#include <EventHandling/EventHandler.h>
+#include "ServerRepository.h"
+
+constexpr auto GATEWAY_SESSION_TIMEOUT = TIMEOUT_DURATION / 1000.0; // seconds without hearing from a client before it's dropped
+
+struct GatewaySession
+{
+	sockaddr_in address;
+	int simulation;         // index of the simulation the client's messages go to
+	double lastReceiveTime;
+};
+
+struct GatewayStats
+{
+	int messagesForwarded{ 0 }; // client to simulation
+	int messagesRelayed{ 0 };   // simulation to client
+	int messagesDropped{ 0 };   // from endpoints without a session, or for sessions a simulation doesn't own
+	int logins{ 0 };
+	int timeouts{ 0 };
+};
+
+// Terminates client connections for one or more simulation processes. Clients connect to the gateway
+// exactly as they would to WrenServer. The gateway does the transport work (reliability, fragments,
+// compression), logins and account creation (password hashing) and heartbeats itself, and forwards
+// every other message to the simulation the client is logged into over a loopback link, where they're
+// batched into as few datagrams per flush as fit. Replies come back the same way and are sent on.
+class GatewaySocketManager : public SocketManager
+{
+	ServerRepository& serverRepository;
+	std::vector<sockaddr_in> simulations;
+	std::unordered_map<unsigned __int64, GatewaySession> sessions;
+	GatewayStats stats;
+
+	const int FindSimulation(const sockaddr_in& address) const;
+	const int GetLeastLoadedSimulation() const;
+	GatewaySession* FindSession(const sockaddr_in& address);
+	void Login(const std::string& accountName, const std::string& password);
+	void CreateAccount(const std::string& accountName, const std::string& password);
+	void ForwardToSimulation(const char* message, const int length);
+	void RelayToClient(BitReader& reader);
+	void CloseSession(const sockaddr_in& address);
+	void InitializeMessageHandlers() override;
+
+public:
+	GatewaySocketManager(EventHandler& eventHandler, ServerRepository& serverRepository, const std::vector<sockaddr_in>& simulations, const int port);
+
+	void HandleTimeouts();
+	const int GetSessionCount() const;
+	const GatewayStats& GetStats() const;
+	void ResetStats();
+};
\ No newline at end of file
@@ -0,0 +1,102 @@
+#include "stdafx.h"
+#include <GameTimer.h>
+#include "GatewaySocketManager.h"
+
+constexpr auto STATS_REPORT_INTERVAL = 60.0; // seconds
+constexpr auto TIMEOUT_CHECK_INTERVAL = 1.0; // seconds
+constexpr auto DEFAULT_SIMULATIONS = "127.0.0.1:27017";
+
+// Front end for one or more WrenServer simulations, which are started with --gateways pointing back at
+// it. Clients connect to the gateway's port in place of WrenServer's, e.g.
+//   WrenServer.exe --zones 127.0.0.1:27017 --zone 0 --gateways 127.0.0.1:27016
+//   WrenGateway.exe --port 27016 --simulations 127.0.0.1:27017
+// --rate-limits works as it does for WrenServer, but drops floods before they're forwarded
+struct GatewayOptions
+{
+	int port{ SERVER_PORT_NUMBER };
+	std::string simulations{ DEFAULT_SIMULATIONS }; // every simulation's ip:port
+	RateLimits rateLimits{ ParseRateLimits(DEFAULT_RATE_LIMITS) };
+};
+
+GatewayOptions ParseOptions(const int argc, char* argv[])
+{
+	GatewayOptions options;
+	for (auto i = 1; i + 1 < argc; i += 2)
+	{
+		const std::string option{ argv[i] };
+		const std::string value{ argv[i + 1] };
+
+		if (option == "--port")
+			options.port = std::stoi(value);
+		else if (option == "--simulations")
+			options.simulations = value;
+		else if (option == "--rate-limits")
+			options.rateLimits = ParseRateLimits(value);
+		else
+			throw std::exception("Unknown option.");
+	}
+	return options;
+}
+
+int main(int argc, char* argv[])
+{
+	GatewayOptions options;
+	std::vector<sockaddr_in> simulations;
+	try
+	{
+		options = ParseOptions(argc, argv);
+		simulations = SocketManager::ParseAddresses(options.simulations);
+	}
+	catch (const std::exception& e)
+	{
+		std::cout << e.what() << "\n";
+		return 1;
+	}
+
+	static EventHandler eventHandler;
+	static ServerRepository serverRepository{ "..\\..\\Databases\\WrenServer.db" };
+	static GatewaySocketManager socketManager{ eventHandler, serverRepository, simulations, options.port };
+	socketManager.SetRateLimits(options.rateLimits);
+
+	timeBeginPeriod(1);
+	std::cout << "WrenGateway listening on port " << options.port << " for " << simulations.size() << (simulations.size() == 1 ? " simulation" : " simulations") << ".\n\n";
+
+	auto lastTimeoutCheck = 0.0;
+	auto lastReport = GameTimer::GetTime();
+	while (true)
+	{
+		socketManager.ProcessPackets();
+
+		const auto now = GameTimer::GetTime();
+		if (now - lastTimeoutCheck >= TIMEOUT_CHECK_INTERVAL)
+		{
+			socketManager.HandleTimeouts();
+			lastTimeoutCheck = now;
+		}
+
+		if (now - lastReport >= STATS_REPORT_INTERVAL)
+		{
+			const auto& stats = socketManager.GetStats();
+			const auto elapsed = now - lastReport;
+			auto rateLimited = 0;
+			for (const auto& pair : socketManager.GetNetworkStats().opCodes)
+				rateLimited += pair.second.rateLimited;
+			std::cout << "Gateway: " << socketManager.GetSessionCount() << " sessions, "
+				<< stats.messagesForwarded / elapsed << " forwarded/s, "
+				<< stats.messagesRelayed / elapsed << " relayed/s, "
+				<< stats.messagesDropped << " dropped, "
+				<< stats.logins << " logins, "
+				<< stats.timeouts << " timeouts, "
+				<< rateLimited << " rate limited, "
+				<< socketManager.GetNetworkStats().connectionTimeouts << " connection timeouts\n";
+			socketManager.ResetStats();
+			socketManager.ResetNetworkStats();
+			lastReport = now;
+		}
+
+		// everything received since the last flush goes out together, so under load the forwarded
+		// messages for each simulation are packed into full datagrams
+		socketManager.FlushPackets();
+		socketManager.WaitForPackets(TIMEOUT_CHECK_INTERVAL);
+	}
+}
\ No newline at end of file
@@ -0,0 +1,187 @@
+#include "stdafx.h"
+#include "ChatChannels.h"
+
+// New members start with full buckets, like a session's RateLimiter buckets.
+ChatChannels::Member& ChatChannels::GetMember(const int accountId, const double now)
+{
+	const auto result = members.try_emplace(accountId);
+	if (result.second)
+	{
+		for (auto i = 0; i < static_cast<int>(ChatChannelType::Count); i++)
+			result.first->second.throttles[i] = TokenBucket{ CHAT_LIMITS[i].burst, now };
+	}
+	return result.first->second;
+}
+
+void ChatChannels::Join(const int accountId, const ChatChannelType type, const std::string& name, const double now)
+{
+	Leave(accountId, type);
+	GetMember(accountId, now).channels[static_cast<int>(type)] = name;
+	subscribers[static_cast<int>(type)][name].push_back(accountId);
+}
+
+const bool ChatChannels::InParty(const int accountId) const
+{
+	const auto member = members.find(accountId);
+	return member != members.end() && !member->second.channels[static_cast<int>(ChatChannelType::Party)].empty();
+}
+
+// The guild channel follows the character's guild, empty for none.
+void ChatChannels::SetGuild(const int accountId, const std::string& guildName, const double now)
+{
+	Leave(accountId, ChatChannelType::Guild);
+	if (!guildName.empty())
+		Join(accountId, ChatChannelType::Guild, guildName, now);
+}
+
+// Only a party's leader, or a player not in a party yet, can invite, and only players who aren't in a
+// party. A newer invite replaces the invitee's older one.
+const bool ChatChannels::Invite(const int leaderId, const int inviteeId, const double now)
+{
+	if (leaderId == inviteeId || InParty(inviteeId) || (InParty(leaderId) && !IsPartyLeader(leaderId)))
+		return false;
+
+	partyInvites[inviteeId] = PartyInvite{ leaderId, now };
+	return true;
+}
+
+// Joins the party of whoever last invited inviteeId, starting one if the leader wasn't in one yet.
+// Returns the leader's account id, or -1 if there's no invite that can still be accepted.
+const int ChatChannels::AcceptInvite(const int inviteeId, const double now)
+{
+	const auto invite = partyInvites.find(inviteeId);
+	if (invite == partyInvites.end())
+		return -1;
+
+	const auto leaderId = invite->second.leaderId;
+	const auto expired = now - invite->second.time > PARTY_INVITE_TIMEOUT;
+	partyInvites.erase(invite);
+	if (expired || InParty(inviteeId))
+		return -1;
+
+	// the inviter may have joined someone else's party since
+	if (!InParty(leaderId))
+		Join(leaderId, ChatChannelType::Party, std::to_string(nextPartyId++), now);
+	else if (!IsPartyLeader(leaderId))
+		return -1;
+
+	Join(inviteeId, ChatChannelType::Party, members.at(leaderId).channels[static_cast<int>(ChatChannelType::Party)], now);
+	return leaderId;
+}
+
+const bool ChatChannels::IsPartyLeader(const int accountId) const
+{
+	const auto* const party = GetSubscribers(accountId, ChatChannelType::Party);
+	return party && party->front() == accountId;
+}
+
+void ChatChannels::Leave(const int accountId, const ChatChannelType type)
+{
+	const auto member = members.find(accountId);
+	if (member == members.end())
+		return;
+
+	std::string& name = member->second.channels[static_cast<int>(type)];
+	if (name.empty())
+		return;
+
+	auto& channels = subscribers[static_cast<int>(type)];
+	const auto channel = channels.find(name);
+	if (channel != channels.end())
+	{
+		auto& accountIds = channel->second;
+		accountIds.erase(std::remove(accountIds.begin(), accountIds.end(), accountId), accountIds.end());
+		if (accountIds.empty())
+			channels.erase(channel);
+	}
+	name.clear();
+}
+
+// For players leaving this process: logouts, timeouts and zone handoffs.
+void ChatChannels::Remove(const int accountId)
+{
+	Leave(accountId, ChatChannelType::Party);
+	Leave(accountId, ChatChannelType::Guild);
+	members.erase(accountId);
+
+	partyInvites.erase(accountId);
+	for (auto it = partyInvites.begin(); it != partyInvites.end();)
+	{
+		if (it->second.leaderId == accountId)
+			it = partyInvites.erase(it);
+		else
+			it++;
+	}
+}
+
+// Everyone in the party or guild channel accountId is in, including accountId, or nullptr if it isn't in one.
+const std::vector<int>* ChatChannels::GetSubscribers(const int accountId, const ChatChannelType type) const
+{
+	const auto member = members.find(accountId);
+	if (member == members.end() || member->second.channels[static_cast<int>(type)].empty())
+		return nullptr;
+
+	const auto& channels = subscribers[static_cast<int>(type)];
+	const auto channel = channels.find(member->second.channels[static_cast<int>(type)]);
+	return channel != channels.end() ? &channel->second : nullptr;
+}
+
+const bool ChatChannels::Throttle(const int accountId, const ChatChannelType type, const double now)
+{
+	return !GetMember(accountId, now).throttles[static_cast<int>(type)].Take(CHAT_LIMITS[static_cast<int>(type)], now);
+}
+
+const ParsedChatLine ChatChannels::Parse(const std::string& line)
+{
+	ParsedChatLine parsed;
+	if (line.empty() || line[0] != '/')
+	{
+		parsed.text = line;
+		return parsed;
+	}
+
+	const auto separator = line.find(' ');
+	const auto command = line.substr(0, separator);
+	const auto rest = separator == std::string::npos ? std::string{} : line.substr(separator + 1);
+
+	if (command == "/invite" || command == "/accept" || command == "/leave")
+	{
+		parsed.type = ChatChannelType::Party;
+		parsed.text = rest;
+		if (command == "/invite")
+			parsed.command = rest.empty() ? ChatCommand::Invalid : ChatCommand::Invite;
+		else if (command == "/accept")
+			parsed.command = ChatCommand::Accept;
+		else
+			parsed.command = rest == "party" ? ChatCommand::Leave : ChatCommand::Invalid;
+		return parsed;
+	}
+
+	parsed.text = rest;
+	if (command == "/s")
+		parsed.type = ChatChannelType::Say;
+	else if (command == "/p")
+		parsed.type = ChatChannelType::Party;
+	else if (command == "/g")
+		parsed.type = ChatChannelType::Guild;
+	else if (command == "/w")
+		parsed.type = ChatChannelType::World;
+	else
+		parsed.command = ChatCommand::Invalid;
+
+	if (parsed.text.empty())
+		parsed.command = ChatCommand::Invalid;
+	return parsed;
+}
+
+// Sent along with every line so clients can label it; empty for say.
+const char* ChatChannels::GetChannelTypeName(const ChatChannelType type)
+{
+	switch (type)
+	{
+		case ChatChannelType::Party: return "Party";
+		case ChatChannelType::Guild: return "Guild";
+		case ChatChannelType::World: return "World";
+		default: return "";
+	}
+}
\ No newline at end of file
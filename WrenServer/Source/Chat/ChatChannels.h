@@ -0,0 +1,81 @@
+#pragma once
+
+#include <Constants.h>
+#include <Networking/RateLimiter.h>
+
+constexpr auto SAY_RADIUS = TILE_SIZE * 20.0f;
+
+enum class ChatChannelType : unsigned char
+{
+	Say,   // players within SAY_RADIUS of the sender, found through the World's player grid
+	Party, // subscription sets, so a line only touches the channel's members
+	Guild,
+	World, // everyone in the sender's World
+	Count
+};
+
+// Per player and channel type: a line costs a token, and tokens come back at rate per second up to burst.
+// This is on top of the per-session SendChatMessage limit, so the channels that reach the most people
+// can be held to less than that.
+constexpr RateLimit CHAT_LIMITS[static_cast<int>(ChatChannelType::Count)]{ { 2.0, 5.0 }, { 2.0, 5.0 }, { 1.0, 5.0 }, { 0.2, 2.0 } };
+
+constexpr auto PARTY_INVITE_TIMEOUT = 60.0; // seconds an /invite can be accepted for
+
+// A chat line is said unless it starts with /s, /p, /g or /w. /invite <character>, /accept and
+// /leave party change party membership instead of sending anything. Guild membership comes from
+// the character's guild and can't be changed from chat.
+enum class ChatCommand : unsigned char
+{
+	Send,
+	Invite,
+	Accept,
+	Leave,
+	Invalid
+};
+
+struct ParsedChatLine
+{
+	ChatCommand command{ ChatCommand::Send };
+	ChatChannelType type{ ChatChannelType::Say };
+	std::string text; // the line to send, or the name of the character to invite
+};
+
+// Which party and guild channel each player is in, and how much each player has said on each type of
+// channel lately. Lives on the ServerSocketManager, so a party can span the Worlds in one process.
+// A party belongs to its leader, the first of its members: only the leader can invite, and when the
+// leader leaves, the longest standing member takes over.
+class ChatChannels
+{
+	struct Member
+	{
+		std::string channels[static_cast<int>(ChatChannelType::Count)]; // empty if not in one
+		TokenBucket throttles[static_cast<int>(ChatChannelType::Count)];
+	};
+
+	struct PartyInvite
+	{
+		int leaderId;
+		double time;
+	};
+
+	std::unordered_map<int, Member> members;
+	std::unordered_map<std::string, std::vector<int>> subscribers[static_cast<int>(ChatChannelType::Count)];
+	std::unordered_map<int, PartyInvite> partyInvites; // invitee to the latest invite it was sent
+	int nextPartyId{ 0 };
+
+	Member& GetMember(const int accountId, const double now);
+	void Join(const int accountId, const ChatChannelType type, const std::string& name, const double now);
+	const bool InParty(const int accountId) const;
+	const bool IsPartyLeader(const int accountId) const;
+public:
+	void SetGuild(const int accountId, const std::string& guildName, const double now);
+	const bool Invite(const int leaderId, const int inviteeId, const double now);
+	const int AcceptInvite(const int inviteeId, const double now);
+	void Leave(const int accountId, const ChatChannelType type);
+	void Remove(const int accountId);
+	const std::vector<int>* GetSubscribers(const int accountId, const ChatChannelType type) const;
+	const bool Throttle(const int accountId, const ChatChannelType type, const double now);
+
+	static const ParsedChatLine Parse(const std::string& line);
+	static const char* GetChannelTypeName(const ChatChannelType type);
+};
\ No newline at end of file
@@ -36,8 +36,7 @@ AIComponent& AIComponentManager::CreateAIComponent(const int gameObjectId)
 
 void AIComponentManager::Update()
 {
-	std::random_device dev;
-	std::mt19937 rng(dev());
+	std::mt19937& rng = componentOrchestrator.GetRandomEngine();
 	std::uniform_int_distribution<std::mt19937::result_type> dist100(0, 99);
 	std::uniform_int_distribution<std::mt19937::result_type> dist8(0, 7);
 
@@ -68,7 +67,7 @@ void AIComponentManager::Update()
 			}
 			
 			std::vector<std::string> args{ std::to_string(gameObject.GetId()), itemIdString };
-			socketManager.SendPacketToAllClients(OpCode::NpcDeath, args);
+			socketManager.SendPacketToInterestedClients(*componentOrchestrator.GetPlayerComponentManager(), OpCode::NpcDeath, args, gameObject.GetId());
 		}
 
 		auto pos = gameObject.GetWorldPosition();
@@ -166,7 +165,7 @@ void AIComponentManager::Update()
 						eventHandler.QueueEvent(e);
 
 						std::vector<std::string> args{ std::to_string(gameObjectId), std::to_string(targetId), std::to_string(dmg) };
-						socketManager.SendPacketToAllClients(OpCode::AttackHit, args);
+						socketManager.SendPacketToInterestedClients(*componentOrchestrator.GetPlayerComponentManager(), OpCode::AttackHit, args, gameObjectId, targetId);
 					}
 					else
 					{
@@ -175,7 +174,7 @@ void AIComponentManager::Update()
 						eventHandler.QueueEvent(e);
 
 						std::vector<std::string> args{ std::to_string(gameObjectId), std::to_string(targetId)};
-						socketManager.SendPacketToAllClients(OpCode::AttackMiss, args);
+						socketManager.SendPacketToInterestedClients(*componentOrchestrator.GetPlayerComponentManager(), OpCode::AttackMiss, args, gameObjectId, targetId);
 					}
 				}
 			}
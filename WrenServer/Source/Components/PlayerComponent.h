@@ -2,6 +2,7 @@
 
 #include <Components/Component.h>
 #include "GameObject.h"
+#include <PlayerMovement.h>
 
 class PlayerComponent : public Component
 {
@@ -15,11 +16,28 @@ public:
 	int characterId{ 0 };
 	int modelId{ 0 };
 	int textureId{ 0 };
+	std::string guildName{ "" }; // from the character's guild membership, empty if it isn't in one
 	int targetId{ -1 };
 	bool autoAttackOn{ false };
 	float swingTimer{ 0.0f };
 	XMFLOAT3 rightMouseDownDir{ VEC_ZERO };
 
+	// movement inputs waiting to be applied, one per tick, oldest first
+	PlayerInput pendingInputs[MAX_QUEUED_INPUTS];
+	int pendingInputCount{ 0 };
+	unsigned int lastReceivedInputSequence{ 0 };
+	unsigned int lastProcessedInputSequence{ 0 };
+
+	// what the last PlayerCorrection told the client; a new one only goes out when its prediction could be wrong
+	bool correctionPending{ true };
+	unsigned int lastCorrectionSequence{ 0 };
+	XMFLOAT3 lastCorrectionPosition{ VEC_ZERO };
+	double lastCorrectionTime{ -1.0 };
+
+	// as measured by the client's clock sync, in seconds
+	float rtt{ 0.0f };
+	float jitter{ 0.0f };
+
 	const std::string& GetToken() const;
 	const std::string& GetIPAndPort() const;
 	const sockaddr_in& GetFromSockAddr() const;
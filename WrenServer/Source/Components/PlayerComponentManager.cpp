@@ -21,14 +21,23 @@ PlayerComponent& PlayerComponentManager::CreatePlayerComponent(const int gameObj
 	playerComponent.ipAndPort = ipAndPort;
 	playerComponent.fromSockAddr = fromSockAddr;
 	playerComponent.lastHeartbeat = lastHeartbeat;
+	playerComponent.rightMouseDownDir = VEC_ZERO;
+	playerComponent.pendingInputCount = 0;
+	playerComponent.lastReceivedInputSequence = 0;
+	playerComponent.lastProcessedInputSequence = 0;
+	playerComponent.correctionPending = true;
+	playerComponent.lastCorrectionSequence = 0;
+	playerComponent.lastCorrectionPosition = VEC_ZERO;
+	playerComponent.lastCorrectionTime = -1.0;
+	playerComponent.rtt = 0.0f;
+	playerComponent.jitter = 0.0f;
 
 	return playerComponent;
 }
 
 void PlayerComponentManager::Update()
 {
-	std::random_device dev;
-	std::mt19937 rng(dev());
+	std::mt19937& rng = componentOrchestrator.GetRandomEngine();
 	std::uniform_int_distribution<std::mt19937::result_type> dist100(0, 99);
 
 	const auto aiComponentManager = componentOrchestrator.GetAIComponentManager();
@@ -39,21 +48,28 @@ void PlayerComponentManager::Update()
 		PlayerComponent& comp = components[i];
 		GameObject& player = objectManager.GetGameObjectById(comp.gameObjectId);
 		
-		// first handle movement
-		if (player.movementVector == VEC_ZERO && comp.rightMouseDownDir != VEC_ZERO)
+		// first handle movement. the client predicts with the same inputs, one per tick, so while
+		// inputs are queued they're applied in order; otherwise the last direction is held.
+		if (comp.pendingInputCount > 0)
 		{
-			const auto delta = XMFLOAT3{ comp.rightMouseDownDir.x * TILE_SIZE, comp.rightMouseDownDir.y * TILE_SIZE, comp.rightMouseDownDir.z * TILE_SIZE };
-			const auto proposedPos = player.localPosition + delta;
-
-			if (!Utility::CheckOutOfBounds(proposedPos) && !gameMap.IsTileOccupied(proposedPos))
-			{
-				player.movementVector = comp.rightMouseDownDir;
-				player.destination = proposedPos;
+			comp.rightMouseDownDir = comp.pendingInputs[0].direction;
+			comp.lastProcessedInputSequence = comp.pendingInputs[0].sequence;
+			comp.pendingInputCount--;
+			for (auto j = 0; j < comp.pendingInputCount; j++)
+				comp.pendingInputs[j] = comp.pendingInputs[j + 1];
+		}
 
-				gameMap.SetTileOccupied(player.localPosition, false);
-				gameMap.SetTileOccupied(player.destination, true);
-			}
+		const auto previousPosition = player.localPosition;
+		const auto wasMoving = player.movementVector != VEC_ZERO;
+		if (PlayerMovement::TryStartMove(player, comp.rightMouseDownDir, &gameMap))
+		{
+			gameMap.SetTileOccupied(previousPosition, false);
+			gameMap.SetTileOccupied(player.destination, true);
+			comp.correctionPending = true;
 		}
+		// the client predicts without the map, so it will have started a move that an occupied tile stopped here
+		else if (!wasMoving && comp.rightMouseDownDir != VEC_ZERO)
+			comp.correctionPending = true;
 
 		// next handle combat
 		// if target dies, toggle off auto attack
@@ -102,7 +118,7 @@ void PlayerComponentManager::Update()
 				eventHandler.QueueEvent(e);
 
 				std::vector<std::string> args{ std::to_string(playerId), std::to_string(targetId), std::to_string(dmg) };
-				socketManager.SendPacketToAllClients(OpCode::AttackHit, args);
+				socketManager.SendPacketToInterestedClients(*this, OpCode::AttackHit, args, playerId, targetId);
 			}
 			else
 			{
@@ -111,12 +127,31 @@ void PlayerComponentManager::Update()
 				eventHandler.QueueEvent(e);
 
 				std::vector<std::string> args{ std::to_string(playerId), std::to_string(targetId) };
-				socketManager.SendPacketToAllClients(OpCode::AttackMiss, args);
+				socketManager.SendPacketToInterestedClients(*this, OpCode::AttackMiss, args, playerId, targetId);
 			}
 		}
 	}
 }
 
+// Inputs arrive several times over, since every PlayerInput repeats the last few. Anything already
+// received is ignored, and if the client gets too far ahead the oldest input is dropped.
+void PlayerComponentManager::QueueInput(PlayerComponent& comp, const PlayerInput& input)
+{
+	if (input.sequence <= comp.lastReceivedInputSequence)
+		return;
+
+	comp.lastReceivedInputSequence = input.sequence;
+
+	if (comp.pendingInputCount == MAX_QUEUED_INPUTS)
+	{
+		comp.pendingInputCount--;
+		for (auto i = 0; i < comp.pendingInputCount; i++)
+			comp.pendingInputs[i] = comp.pendingInputs[i + 1];
+	}
+
+	comp.pendingInputs[comp.pendingInputCount++] = input;
+}
+
 const XMFLOAT3 PlayerComponentManager::GetDestinationVector(const XMFLOAT3 rightMouseDownDir, const XMFLOAT3 playerPos) const
 {
 	const auto vec = XMLoadFloat3(&rightMouseDownDir);
@@ -17,6 +17,7 @@ public:
 	PlayerComponentManager(EventHandler& eventHandler, ObjectManager& objectManager, GameMap& gameMap, ServerComponentOrchestrator& componentOrchestrator, ServerSocketManager& socketManager);
 	PlayerComponent& CreatePlayerComponent(const int gameObjectId, const std::string token, const std::string ipAndPort, const sockaddr_in fromSockAddr, const unsigned __int64 lastHeartbeat);
 	void Update();
+	void QueueInput(PlayerComponent& comp, const PlayerInput& input);
 	PlayerComponent* GetPlayerComponents();
 	const int GetPlayerComponentIndex();
 };
\ No newline at end of file
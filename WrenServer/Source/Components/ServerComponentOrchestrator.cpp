@@ -20,4 +20,6 @@ AIComponentManager* ServerComponentOrchestrator::GetAIComponentManager() const {
 PlayerComponentManager* ServerComponentOrchestrator::GetPlayerComponentManager() const { return playerComponentManager; }
 SkillComponentManager* ServerComponentOrchestrator::GetSkillComponentManager() const { return skillComponentManager; }
 StatsComponentManager* ServerComponentOrchestrator::GetStatsComponentManager() const { return statsComponentManager; }
-InventoryComponentManager* ServerComponentOrchestrator::GetInventoryComponentManager() const { return inventoryComponentManager; }
\ No newline at end of file
+InventoryComponentManager* ServerComponentOrchestrator::GetInventoryComponentManager() const { return inventoryComponentManager; }
+std::mt19937& ServerComponentOrchestrator::GetRandomEngine() { return rng; }
+void ServerComponentOrchestrator::SeedRandom(const unsigned int seed) { rng.seed(seed); }
\ No newline at end of file
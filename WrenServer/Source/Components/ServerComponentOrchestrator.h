@@ -13,6 +13,7 @@ class ServerComponentOrchestrator
 	SkillComponentManager* skillComponentManager{ nullptr };
 	StatsComponentManager* statsComponentManager{ nullptr };
 	InventoryComponentManager* inventoryComponentManager{ nullptr };
+	std::mt19937 rng{ std::random_device{}() };
 
 public:
 	void InitializeComponentManagers(
@@ -28,4 +29,8 @@ public:
 	SkillComponentManager* GetSkillComponentManager() const;
 	StatsComponentManager* GetStatsComponentManager() const;
 	InventoryComponentManager* GetInventoryComponentManager() const;
+
+	// shared by all game logic, so seeding it makes a run repeatable
+	std::mt19937& GetRandomEngine();
+	void SeedRandom(const unsigned int seed);
 };
\ No newline at end of file
@@ -1,2 +1,5 @@
 #include "stdafx.h"
 #include "SkillComponent.h"
+
+
+const std::vector<std::unique_ptr<WrenServer::Skill>>& SkillComponent::GetSkills() const { return skills; }
\ No newline at end of file
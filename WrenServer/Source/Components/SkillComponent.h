@@ -11,4 +11,5 @@ class SkillComponent : public Component
 
 	friend class SkillComponentManager;
 public:
+	const std::vector<std::unique_ptr<WrenServer::Skill>>& GetSkills() const;
 };
\ No newline at end of file
@@ -43,8 +43,7 @@ const bool SkillComponentManager::HandleEvent(const Event* const event)
 
 			// TODO: handle fancy logic based on NPC's DifficultyRating, etc
 
-			std::random_device dev;
-			std::mt19937 rng(dev());
+			std::mt19937& rng = componentOrchestrator.GetRandomEngine();
 			std::uniform_int_distribution<std::mt19937::result_type> dist100(0, 99);
 
 			const auto playerComponentManager = componentOrchestrator.GetPlayerComponentManager();
@@ -0,0 +1,98 @@
+#include "stdafx.h"
+#include "MetricsServer.h"
+
+constexpr auto METRICS_REQUEST_SIZE = 1024;
+
+// Expects WSAStartup to have been called already, which the ServerSocketManager does.
+MetricsServer::MetricsServer(const int port)
+{
+	listenSocket = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+	if (listenSocket == INVALID_SOCKET)
+		throw std::exception("Failed to create metrics socket.");
+
+	sockaddr_in address{};
+	address.sin_family = AF_INET;
+	address.sin_port = htons(port);
+	inet_pton(AF_INET, "127.0.0.1", &address.sin_addr);
+
+	if (bind(listenSocket, (sockaddr*)& address, sizeof(address)) == SOCKET_ERROR || listen(listenSocket, SOMAXCONN) == SOCKET_ERROR)
+	{
+		closesocket(listenSocket);
+		throw std::exception("Failed to listen on the metrics port.");
+	}
+
+	running = true;
+	thread = std::thread{ &MetricsServer::Run, this };
+}
+
+MetricsServer::~MetricsServer()
+{
+	Stop();
+}
+
+void MetricsServer::Publish(std::string text)
+{
+	std::lock_guard<std::mutex> lock{ pageMutex };
+	page.swap(text);
+}
+
+void MetricsServer::Stop()
+{
+	if (!running.exchange(false))
+		return;
+
+	thread.join();
+	closesocket(listenSocket);
+}
+
+void MetricsServer::Run()
+{
+	while (running)
+	{
+		fd_set readSet;
+		FD_ZERO(&readSet);
+		FD_SET(listenSocket, &readSet);
+		timeval timeout{ 0, METRICS_POLL_TIMEOUT * 1000 };
+		if (select(static_cast<int>(listenSocket) + 1, &readSet, nullptr, nullptr, &timeout) <= 0)
+			continue;
+
+		const auto client = accept(listenSocket, nullptr, nullptr);
+		if (client == INVALID_SOCKET)
+			continue;
+
+		Serve(client);
+		closesocket(client);
+	}
+}
+
+// Every request gets the same page, whatever its path; scrapers only ever ask for /metrics anyway.
+void MetricsServer::Serve(const SOCKET client)
+{
+	DWORD receiveTimeout = METRICS_POLL_TIMEOUT * 10;
+	setsockopt(client, SOL_SOCKET, SO_RCVTIMEO, (const char*)&receiveTimeout, sizeof(receiveTimeout));
+
+	char request[METRICS_REQUEST_SIZE];
+	if (recv(client, request, sizeof(request), 0) <= 0)
+		return;
+
+	std::string body;
+	{
+		std::lock_guard<std::mutex> lock{ pageMutex };
+		body = page;
+	}
+
+	const auto response = std::string{ "HTTP/1.1 200 OK\r\n" }
+		+ "Content-Type: text/plain; version=0.0.4\r\n"
+		+ "Content-Length: " + std::to_string(body.size()) + "\r\n"
+		+ "Connection: close\r\n\r\n"
+		+ body;
+
+	auto sent = 0;
+	while (sent < static_cast<int>(response.size()))
+	{
+		const auto result = send(client, response.data() + sent, static_cast<int>(response.size()) - sent, 0);
+		if (result == SOCKET_ERROR)
+			return;
+		sent += result;
+	}
+}
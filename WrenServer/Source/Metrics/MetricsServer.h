@@ -0,0 +1,24 @@
+#pragma once
+
+constexpr auto METRICS_PORT_NUMBER = 9464;
+constexpr auto METRICS_PUBLISH_INTERVAL = 1.0f; // seconds between snapshots taken on the simulation thread
+constexpr auto METRICS_POLL_TIMEOUT = 100;      // milliseconds the listener waits before checking whether to stop
+
+// Serves the last published page over plain HTTP on localhost, from its own thread. The simulation
+// thread only ever hands over a finished page, so a slow or stuck scraper can't stall a tick.
+class MetricsServer
+{
+	SOCKET listenSocket{ INVALID_SOCKET };
+	std::thread thread;
+	std::atomic<bool> running{ false };
+	std::mutex pageMutex;
+	std::string page;
+
+	void Run();
+	void Serve(const SOCKET client);
+public:
+	MetricsServer(const int port = METRICS_PORT_NUMBER);
+	~MetricsServer();
+	void Publish(std::string text);
+	void Stop();
+};
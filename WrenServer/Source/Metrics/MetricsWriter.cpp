@@ -0,0 +1,64 @@
+#include "stdafx.h"
+#include "MetricsWriter.h"
+
+constexpr double SUMMARY_QUANTILES[]{ 0.5, 0.9, 0.99, 0.999 };
+
+MetricsWriter::MetricsWriter()
+{
+	out << std::setprecision(9);
+}
+
+void MetricsWriter::Family(const char* name, const char* type, const char* help)
+{
+	out << "# HELP " << name << " " << help << "\n"
+		<< "# TYPE " << name << " " << type << "\n";
+}
+
+void MetricsWriter::Sample(const char* name, const double value, const std::string& labels)
+{
+	out << name;
+	if (!labels.empty())
+		out << "{" << labels << "}";
+	out << " " << value << "\n";
+}
+
+// Quantiles, sum and count of a Histogram, in seconds.
+void MetricsWriter::Summary(const char* name, const Histogram& histogram, const std::string& labels)
+{
+	const auto separator = labels.empty() ? "" : ",";
+	for (const auto quantile : SUMMARY_QUANTILES)
+	{
+		std::ostringstream quantileLabel;
+		quantileLabel << labels << separator << "quantile=\"" << quantile << "\"";
+		Sample(name, histogram.GetValueAtPercentile(quantile), quantileLabel.str());
+	}
+
+	const auto count = histogram.GetCount();
+	Sample((std::string{ name } + "_sum").c_str(), histogram.GetMean() * count, labels);
+	Sample((std::string{ name } + "_count").c_str(), static_cast<double>(count), labels);
+}
+
+const std::string MetricsWriter::GetText() const
+{
+	return out.str();
+}
+
+// Formats name="value", escaping the characters the text format reserves.
+const std::string MetricsWriter::Label(const char* name, const std::string& value)
+{
+	std::string label{ name };
+	label += "=\"";
+	for (const auto c : value)
+	{
+		if (c == '\\' || c == '"')
+			label += '\\';
+		if (c == '\n')
+		{
+			label += "\\n";
+			continue;
+		}
+		label += c;
+	}
+	label += "\"";
+	return label;
+}
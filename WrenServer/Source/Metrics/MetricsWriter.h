@@ -0,0 +1,19 @@
+#pragma once
+
+#include <Profiling/Histogram.h>
+
+// Builds a page in the Prometheus text exposition format. Every metric starts with Family,
+// followed by one Sample per label combination. Labels are passed preformatted, see Label.
+class MetricsWriter
+{
+	std::ostringstream out;
+
+public:
+	MetricsWriter();
+	void Family(const char* name, const char* type, const char* help);
+	void Sample(const char* name, const double value, const std::string& labels = "");
+	void Summary(const char* name, const Histogram& histogram, const std::string& labels = "");
+	const std::string GetText() const;
+
+	static const std::string Label(const char* name, const std::string& value);
+};
@@ -0,0 +1,111 @@
+#include "stdafx.h"
+#include "ReplicationScheduler.h"
+
+// Records which entities changed since the previous tick by comparing their encoded updates.
+void ReplicationScheduler::BeginTick(std::vector<ReplicatedEntity>& entities)
+{
+	tick++;
+
+	for (auto i = 0; i < entities.size(); i++)
+	{
+		ReplicatedEntity& entity = entities[i];
+		EntityRecord& record = entityRecords[entity.id];
+
+		const auto* const data = entity.packet->GetData();
+		const auto length = entity.packet->GetLength();
+		if (record.lastSeenTick == 0 || record.state.size() != length || memcmp(record.state.data(), data, length) != 0)
+		{
+			record.state.assign(data, data + length);
+			record.lastChangedTick = tick;
+		}
+
+		record.lastSeenTick = tick;
+		entity.lastChangedTick = record.lastChangedTick;
+	}
+}
+
+// Fills selected with indices into entities, in the order they should be sent. reservedBytes of the
+// client's budget are already spoken for by other messages this tick.
+void ReplicationScheduler::Schedule(const int clientId, const XMFLOAT3& clientPosition, const int clientTargetId, const std::vector<ReplicatedEntity>& entities, std::vector<int>& selected, const int reservedBytes)
+{
+	ClientRecord& client = clientRecords[clientId];
+	client.lastSeenTick = tick;
+
+	candidates.clear();
+	for (auto i = 0; i < entities.size(); i++)
+	{
+		const ReplicatedEntity& entity = entities[i];
+		ClientEntityRecord& record = client.entities[entity.id];
+		record.lastSeenTick = tick;
+
+		auto priority = entity.lastChangedTick > record.lastSentTick ? PRIORITY_CHANGED : PRIORITY_UNCHANGED;
+		if (entity.id == clientId)
+			priority += PRIORITY_SELF;
+		else if (entity.id == clientTargetId || entity.targetId == clientId)
+			priority += PRIORITY_COMBAT;
+
+		const auto dx = entity.position.x - clientPosition.x;
+		const auto dz = entity.position.z - clientPosition.z;
+		const auto distance = std::sqrt(dx * dx + dz * dz);
+		record.priority += priority * PRIORITY_FALLOFF_DISTANCE / (PRIORITY_FALLOFF_DISTANCE + distance);
+
+		candidates.push_back(std::make_pair(record.priority, i));
+	}
+
+	std::sort(candidates.begin(), candidates.end(), [](const std::pair<float, int>& l, const std::pair<float, int>& r) { return l.first > r.first; });
+
+	selected.clear();
+	auto remainingBytes = bytesPerTick - reservedBytes;
+	for (auto i = 0; i < candidates.size(); i++)
+	{
+		const auto index = candidates[i].second;
+		const ReplicatedEntity& entity = entities[index];
+		const auto cost = entity.packet->GetLength() + ENTITY_MESSAGE_OVERHEAD;
+
+		// always send at least the top entity, so a tiny budget can't starve a client completely
+		if (cost > remainingBytes && !selected.empty())
+			continue;
+
+		remainingBytes -= cost;
+		selected.push_back(index);
+
+		ClientEntityRecord& record = client.entities[entity.id];
+		record.priority = 0.0f;
+		record.lastSentTick = tick;
+	}
+}
+
+// Forgets entities that were deleted and clients that logged out.
+void ReplicationScheduler::EndTick()
+{
+	for (auto it = entityRecords.begin(); it != entityRecords.end();)
+	{
+		if (it->second.lastSeenTick != tick)
+			it = entityRecords.erase(it);
+		else
+			it++;
+	}
+
+	for (auto it = clientRecords.begin(); it != clientRecords.end();)
+	{
+		if (it->second.lastSeenTick != tick)
+		{
+			it = clientRecords.erase(it);
+			continue;
+		}
+
+		auto& entities = it->second.entities;
+		for (auto entityIt = entities.begin(); entityIt != entities.end();)
+		{
+			if (entityIt->second.lastSeenTick != tick)
+				entityIt = entities.erase(entityIt);
+			else
+				entityIt++;
+		}
+		it++;
+	}
+}
+
+void ReplicationScheduler::SetBytesPerTick(const int bytesPerTick) { this->bytesPerTick = bytesPerTick; }
+
+const int ReplicationScheduler::GetBytesPerTick() const { return bytesPerTick; }
\ No newline at end of file
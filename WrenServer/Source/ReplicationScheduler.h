@@ -0,0 +1,63 @@
+#pragma once
+
+#include <Networking/Packet.h>
+
+constexpr auto DEFAULT_CLIENT_BYTES_PER_TICK = 1200; // one full datagram per tick, ~70KB/s at 60 ticks/s
+constexpr auto ENTITY_MESSAGE_OVERHEAD = 5;          // channel, length and message id in front of each update
+
+// priority added per tick, before the distance falloff
+constexpr auto PRIORITY_SELF = 8.0f;            // the client's own character
+constexpr auto PRIORITY_COMBAT = 4.0f;          // the client's target, or anything targeting the client
+constexpr auto PRIORITY_CHANGED = 1.0f;         // state differs from what this client last received
+constexpr auto PRIORITY_UNCHANGED = 0.05f;      // still refreshed now and then, since updates are unreliable
+constexpr auto PRIORITY_FALLOFF_DISTANCE = TILE_SIZE * 10.0f; // priority halves at this distance
+
+struct ReplicatedEntity
+{
+	int id;
+	XMFLOAT3 position;
+	int targetId;   // -1 if not targeting anything
+	Packet* packet; // encoded update for this tick
+	int lastChangedTick{ 0 };
+};
+
+// Decides which entity updates each client gets this tick. Every entity accumulates priority for
+// every client each tick it isn't sent (more if it's close, changed, or involved in combat with the
+// client), and updates are sent highest priority first until the client's byte budget is used up.
+// An entity that loses out keeps accumulating, so it wins eventually: crowded areas degrade into
+// lower update rates instead of bursts of packets.
+class ReplicationScheduler
+{
+	struct EntityRecord
+	{
+		std::vector<char> state;
+		int lastChangedTick{ 0 };
+		int lastSeenTick{ 0 };
+	};
+
+	struct ClientEntityRecord
+	{
+		float priority{ 0.0f };
+		int lastSentTick{ -1 };
+		int lastSeenTick{ 0 };
+	};
+
+	struct ClientRecord
+	{
+		std::unordered_map<int, ClientEntityRecord> entities;
+		int lastSeenTick{ 0 };
+	};
+
+	int bytesPerTick{ DEFAULT_CLIENT_BYTES_PER_TICK };
+	int tick{ 0 };
+	std::unordered_map<int, EntityRecord> entityRecords;
+	std::unordered_map<int, ClientRecord> clientRecords;
+	std::vector<std::pair<float, int>> candidates;
+
+public:
+	void BeginTick(std::vector<ReplicatedEntity>& entities);
+	void Schedule(const int clientId, const XMFLOAT3& clientPosition, const int clientTargetId, const std::vector<ReplicatedEntity>& entities, std::vector<int>& selected, const int reservedBytes = 0);
+	void EndTick();
+	void SetBytesPerTick(const int bytesPerTick);
+	const int GetBytesPerTick() const;
+};
\ No newline at end of file
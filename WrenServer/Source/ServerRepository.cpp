@@ -12,9 +12,12 @@ constexpr char GET_CHARACTER_QUERY[] = "SELECT * FROM Characters WHERE character
 constexpr char LIST_CHARACTER_SKILLS_QUERY[] = "SELECT Skills.id, Skills.name, CharacterSkills.value FROM CharacterSkills INNER JOIN Skills on Skills.id = CharacterSkills.skill_id WHERE CharacterSkills.character_id = '%d';";
 constexpr char LIST_CHARACTER_ABILITIES_QUERY[] = "SELECT Abilities.id, Abilities.name, Abilities.description, Abilities.sprite_id, Abilities.toggled FROM CharacterAbilities INNER JOIN Abilities on Abilities.id = CharacterAbilities.ability_id WHERE CharacterAbilities.character_id = '%d';";
 constexpr char LIST_ABILITIES_QUERY[] = "SELECT id, name, description, sprite_id, toggled, targeted FROM Abilities;";
+constexpr char GET_CHARACTER_GUILD_QUERY[] = "SELECT Guilds.name FROM GuildMembers INNER JOIN Guilds on Guilds.id = GuildMembers.guild_id WHERE GuildMembers.character_id = '%d' LIMIT 1;";
 
 const bool ServerRepository::AccountExists(const std::string& accountName)
 {
+	QueryScope scope{ *this, "ServerRepository::AccountExists" };
+
 	const auto dbConnection = GetConnection();
 
 	char query[100];
@@ -43,6 +46,8 @@ const bool ServerRepository::AccountExists(const std::string& accountName)
 
 const bool ServerRepository::CharacterExists(const std::string& characterName)
 {
+	QueryScope scope{ *this, "ServerRepository::CharacterExists" };
+
 	const auto dbConnection = GetConnection();
 
 	char query[100];
@@ -71,6 +76,8 @@ const bool ServerRepository::CharacterExists(const std::string& characterName)
 
 void ServerRepository::CreateAccount(const std::string& accountName, const std::string& password)
 {
+	QueryScope scope{ *this, "ServerRepository::CreateAccount" };
+
 	const auto dbConnection = GetConnection();
 
 	char query[300];
@@ -88,6 +95,8 @@ void ServerRepository::CreateAccount(const std::string& accountName, const std::
 
 void ServerRepository::CreateCharacter(const std::string& characterName, const int accountId)
 {
+	QueryScope scope{ *this, "ServerRepository::CreateCharacter" };
+
 	const auto dbConnection = GetConnection();
 
 	char query[500];
@@ -105,6 +114,8 @@ void ServerRepository::CreateCharacter(const std::string& characterName, const i
 
 const std::unique_ptr<Account> ServerRepository::GetAccount(const std::string& accountName)
 {
+	QueryScope scope{ *this, "ServerRepository::GetAccount" };
+
 	auto dbConnection = GetConnection();
 
 	char query[100];
@@ -136,6 +147,8 @@ const std::unique_ptr<Account> ServerRepository::GetAccount(const std::string& a
 
 std::vector<std::string> ServerRepository::ListCharacters(const int accountId)
 {
+	QueryScope scope{ *this, "ServerRepository::ListCharacters" };
+
 	auto dbConnection = GetConnection();
 
 	char query[100];
@@ -171,6 +184,8 @@ std::vector<std::string> ServerRepository::ListCharacters(const int accountId)
 
 void ServerRepository::DeleteCharacter(const std::string& characterName)
 {
+	QueryScope scope{ *this, "ServerRepository::DeleteCharacter" };
+
 	auto dbConnection = GetConnection();
 
 	char query[100];
@@ -192,6 +207,8 @@ void ServerRepository::DeleteCharacter(const std::string& characterName)
 
 Character ServerRepository::GetCharacter(const std::string& characterName)
 {
+	QueryScope scope{ *this, "ServerRepository::GetCharacter" };
+
 	auto dbConnection = GetConnection();
 
 	char query[100];
@@ -245,6 +262,8 @@ Character ServerRepository::GetCharacter(const std::string& characterName)
 
 std::vector<WrenCommon::Skill> ServerRepository::ListCharacterSkills(const int characterId)
 {
+	QueryScope scope{ *this, "ServerRepository::ListCharacterSkills" };
+
 	auto dbConnection = GetConnection();
 
 	char query[200];
@@ -282,6 +301,8 @@ std::vector<WrenCommon::Skill> ServerRepository::ListCharacterSkills(const int c
 
 std::vector<Ability> ServerRepository::ListCharacterAbilities(const int characterId)
 {
+	QueryScope scope{ *this, "ServerRepository::ListCharacterAbilities" };
+
 	auto dbConnection = GetConnection();
 
 	char query[300];
@@ -323,6 +344,8 @@ std::vector<Ability> ServerRepository::ListCharacterAbilities(const int characte
 
 std::vector<Ability> ServerRepository::ListAbilities()
 {
+	QueryScope scope{ *this, "ServerRepository::ListAbilities" };
+
 	auto dbConnection = GetConnection();
 
 	auto statement = PrepareStatement(dbConnection, LIST_ABILITIES_QUERY);
@@ -358,3 +381,34 @@ std::vector<Ability> ServerRepository::ListAbilities()
 		throw std::exception(FAILED_TO_EXECUTE);
 	}
 }
+
+// The name of the guild the character belongs to, or an empty string if it isn't in one.
+const std::string ServerRepository::GetCharacterGuild(const int characterId)
+{
+	QueryScope scope{ *this, "ServerRepository::GetCharacterGuild" };
+
+	auto dbConnection = GetConnection();
+
+	char query[200];
+	sprintf_s(query, GET_CHARACTER_GUILD_QUERY, characterId);
+
+	auto statement = PrepareStatement(dbConnection, query);
+	const auto result = sqlite3_step(statement);
+	if (result == SQLITE_ROW)
+	{
+		const std::string guildName{ reinterpret_cast<const char*>(sqlite3_column_text(statement, 0)) };
+		sqlite3_finalize(statement);
+		return guildName;
+	}
+	else if (result == SQLITE_DONE)
+	{
+		sqlite3_finalize(statement);
+		return "";
+	}
+	else
+	{
+		sqlite3_finalize(statement);
+		std::cout << sqlite3_errmsg(dbConnection) << std::endl;
+		throw std::exception(FAILED_TO_EXECUTE);
+	}
+}
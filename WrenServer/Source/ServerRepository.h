@@ -20,4 +20,5 @@ public:
 	std::vector<WrenCommon::Skill> ListCharacterSkills(const int characterId);
 	std::vector<Ability> ListCharacterAbilities(const int characterId);
 	std::vector<Ability> ListAbilities();
+	const std::string GetCharacterGuild(const int characterId);
 };
\ No newline at end of file
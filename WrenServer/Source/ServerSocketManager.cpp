@@ -1,10 +1,6 @@
 #include "stdafx.h"
 #include "ServerSocketManager.h"
-#include "Components/AIComponentManager.h"
-#include <Components/StatsComponentManager.h>
-#include "Components/PlayerComponentManager.h"
-#include "Components/SkillComponentManager.h"
-#include "Components/InventoryComponentManager.h"
+#include "World.h"
 
 constexpr auto PLAYER_NOT_FOUND = "Player not found.";
 constexpr auto INCORRECT_USERNAME = "Incorrect Username.";
@@ -17,20 +13,28 @@ constexpr auto DEAD_ATTACK_TARGET = "You can't attack something that is already
 constexpr auto NO_ATTACK_TARGET = "You need a target before attacking!";
 constexpr auto MESSAGE_TYPE_ERROR = "ERROR";
 constexpr auto INVENTORY_FULL = "Inventory is full.";
+constexpr auto INVALID_CHAT_COMMAND = "Say /s, /p, /g or /w followed by a message, /invite <name>, /accept or /leave party.";
+constexpr auto NOT_IN_CHAT_CHANNEL = "You aren't in a party or guild.";
+constexpr auto PARTY_INVITE_FAILED = "Only a party's leader can invite, and only players who aren't in a party already.";
+constexpr auto NO_PARTY_INVITE = "You have no party invite to accept.";
+constexpr auto CHAT_THROTTLED = "You're sending messages too quickly.";
+constexpr auto MESSAGE_TYPE_INFO = "INFO";
+constexpr auto NETWORK_STATS_TOP_SESSIONS = 5; // busiest inbound sessions listed in each report
+constexpr auto ZONE_HANDOFF_RETRY = 2.0;      // seconds without a ZoneHandoffAccepted before the handoff is sent again
+constexpr auto ZONE_TRANSFER_LINGER = 5.0;    // seconds a handed off client's Connection stays open for ZoneTransfer resends
+constexpr auto ZONE_GHOST_TIMEOUT = 1.0;      // seconds without a ZoneBorderUpdate before a ghost is dropped
+constexpr auto MAX_REPORTED_LATENCY = 10.0f;  // seconds; a client claiming more than this is capped
+constexpr auto CORRECTION_REFRESH_INTERVAL = 0.5; // seconds; lets the client trim the inputs it keeps for replay, and covers lost corrections
 
 ServerSocketManager::ServerSocketManager(
 	EventHandler& eventHandler,
-	GameMap& gameMap,
-	ObjectManager& objectManager,
-	ServerComponentOrchestrator& componentOrchestrator,
 	ServerRepository& serverRepository,
-	CommonRepository& commonRepository)
-	: SocketManager{ eventHandler, SERVER_PORT_NUMBER },
-	  gameMap{ gameMap },
-	  objectManager{ objectManager },
-	  componentOrchestrator{ componentOrchestrator },
+	CommonRepository& commonRepository,
+	const ZoneMap& zoneMap)
+	: SocketManager{ eventHandler, ntohs(zoneMap.GetLocalZone().address.sin_port) },
 	  serverRepository{ serverRepository },
-	  commonRepository{ commonRepository }
+	  commonRepository{ commonRepository },
+	  zoneMap{ zoneMap }
 {	
 }
 
@@ -43,102 +47,316 @@ void ServerSocketManager::Initialize()
 
 	// initialize Abilities
 	abilities = serverRepository.ListAbilities();
+}
+
+// Logins are spread over every World added here, so add them all before the first login.
+void ServerSocketManager::AddWorld(World& world)
+{
+	world.GetReplicationScheduler().SetBytesPerTick(clientBytesPerTick);
+	worlds.push_back(&world);
+}
+
+// An account that isn't logged in gets the first World, where the lookup behaves as it always has with
+// one World: GetGameObjectById hands back the first GameObject and the token check fails.
+World& ServerSocketManager::GetWorld(const int accountId)
+{
+	const auto it = accountWorlds.find(accountId);
+	if (it != accountWorlds.end())
+		return *it->second;
+
+	if (worlds.empty())
+		throw std::exception("No World has been added.");
+	return *worlds[0];
+}
+
+// New logins go to whichever World has the fewest players, which keeps the Worlds' ticks about the same length.
+World& ServerSocketManager::GetLeastPopulatedWorld()
+{
+	if (worlds.empty())
+		throw std::exception("No World has been added.");
 
-	// initialize StaticObjects
-	auto staticObjects = commonRepository.ListStaticObjects();
-	for (auto i = 0; i < staticObjects.size(); i++)
+	World* leastPopulated = worlds[0];
+	for (auto i = 1; i < worlds.size(); i++)
 	{
-		const StaticObject* staticObject = staticObjects.at(i).get();
-		const auto pos = staticObject->GetPosition();
-		const GameObject& gameObject = objectManager.CreateGameObject(pos, XMFLOAT3{ 14.0f, 14.0f, 14.0f }, 0.0f, GameObjectType::StaticObject, staticObject->GetName(), staticObject->GetId(), true);
-		gameMap.SetTileOccupied(gameObject.localPosition, true);
+		if (worlds[i]->GetPlayerCount() < leastPopulated->GetPlayerCount())
+			leastPopulated = worlds[i];
 	}
+	return *leastPopulated;
+}
 
-	// initialize test dummy
-	// we need to move ListNpcs to CommonRepository
-	const std::string dummyName{ "Dummy1" };
-	GameObject& dummyGameObject = objectManager.CreateGameObject(XMFLOAT3{ 30.0f, 0.0f, 30.0f }, XMFLOAT3{ 14.0f, 14.0f, 14.0f }, 30.0f, GameObjectType::Npc, dummyName, 101, false, 2, 4);
-	const auto dummyId = dummyGameObject.GetId();
-
-	const auto aiComponentManager = componentOrchestrator.GetAIComponentManager();
+World* ServerSocketManager::FindWorld(const int worldId)
+{
+	for (World* world : worlds)
+	{
+		if (world->GetId() == worldId)
+			return world;
+	}
+	return nullptr;
+}
 
-	const AIComponent& dummyAIComponent = aiComponentManager->CreateAIComponent(dummyId);
-	dummyGameObject.aiComponentId = dummyAIComponent.GetId();
+// Components only know their own manager; Worlds are never added or removed while they tick.
+World& ServerSocketManager::FindWorld(const PlayerComponentManager& playerComponentManager)
+{
+	for (World* world : worlds)
+	{
+		if (&world->GetPlayerComponentManager() == &playerComponentManager)
+			return *world;
+	}
+	throw std::exception("PlayerComponentManager doesn't belong to any World.");
+}
 
-	const auto statsComponentManager = componentOrchestrator.GetStatsComponentManager();
-	const StatsComponent& dummyStatsComponent = statsComponentManager->CreateStatsComponent(dummyId, 10, 10, 10, 10, 10, 10, 10, 100, 100, 100, 100, 100, 100);
-	dummyGameObject.statsComponentId = dummyStatsComponent.GetId();
+// Clients logged in through a gateway are only ever reached through it. The link is loopback, so
+// compression is left to the gateway.
+void ServerSocketManager::AddGateway(const sockaddr_in& address)
+{
+	gateways.push_back(address);
+	SetCompressionEnabled(address, false);
+}
 
-	const auto inventoryComponentManager = componentOrchestrator.GetInventoryComponentManager();
-	InventoryComponent& dummyInventoryComponent = inventoryComponentManager->CreateInventoryComponent(dummyId);
-	dummyGameObject.inventoryComponentId = dummyInventoryComponent.GetId();
-	dummyInventoryComponent.AddItem(1);
-	dummyInventoryComponent.AddItem(2);
-	gameMap.SetTileOccupied(dummyGameObject.localPosition, true);
+const bool ServerSocketManager::IsGateway(const sockaddr_in& address) const
+{
+	const auto key = GetEndpointKey(address);
+	for (const auto& gateway : gateways)
+	{
+		if (GetEndpointKey(gateway) == key)
+			return true;
+	}
+	return false;
+}
 
-	const std::string dummyName2{ "Dummy2" };
-	GameObject& dummyGameObject2 = objectManager.CreateGameObject(XMFLOAT3{ 90.0f, 0.0f, 60.0f }, XMFLOAT3{ 14.0f, 14.0f, 14.0f }, 30.0f, GameObjectType::Npc, dummyName2, 102, false, 2, 4);
-	const auto dummyId2 = dummyGameObject2.GetId();
+// Messages for a client behind a gateway are wrapped up for the gateway to pass on.
+void ServerSocketManager::SendToClient(const sockaddr_in& to, Packet& packet)
+{
+	const auto gateway = gatewayClients.find(GetEndpointKey(to));
+	if (gateway == gatewayClients.end())
+	{
+		SocketManager::SendPacket(to, packet);
+		return;
+	}
 
-	const AIComponent& dummyAIComponent2 = aiComponentManager->CreateAIComponent(dummyId2);
-	dummyGameObject2.aiComponentId = dummyAIComponent2.GetId();
+	Packet& forwardPacket = CreateForwardPacket(to, packet.GetData(), packet.GetLength());
+	SocketManager::SendPacket(gateway->second, forwardPacket);
+	forwardPacket.Release();
+}
 
-	const StatsComponent& dummyStatsComponent2 = statsComponentManager->CreateStatsComponent(dummyId2, 10, 10, 10, 10, 10, 10, 10, 100, 100, 100, 100, 100, 100);
-	dummyGameObject2.statsComponentId = dummyStatsComponent2.GetId();
+// Drops a client's Connection, or tells its gateway to.
+void ServerSocketManager::DisconnectClient(const sockaddr_in& address)
+{
+	const auto gateway = gatewayClients.find(GetEndpointKey(address));
+	if (gateway == gatewayClients.end())
+	{
+		RemoveConnection(address);
+		return;
+	}
 
-	InventoryComponent& dummyInventoryComponent2 = inventoryComponentManager->CreateInventoryComponent(dummyId2);
-	dummyGameObject2.inventoryComponentId = dummyInventoryComponent2.GetId();
-	dummyInventoryComponent2.AddItem(2);
-	dummyInventoryComponent2.AddItem(3);
-	gameMap.SetTileOccupied(dummyGameObject2.localPosition, true);
+	char clientAddress[INET_ADDRSTRLEN];
+	ZeroMemory(clientAddress, sizeof(clientAddress));
+	inet_ntop(AF_INET, &(address.sin_addr), clientAddress, INET_ADDRSTRLEN);
+	const std::vector<std::string> args{ std::string{ clientAddress }, std::to_string(ntohs(address.sin_port)) };
+	SocketManager::SendPacket(gateway->second, OpCode::GatewayDisconnect, args);
+	gatewayClients.erase(gateway);
 }
 
 void ServerSocketManager::SendPacket(const sockaddr_in& to, const OpCode opCode, const std::vector<std::string>& args)
 {
-	SocketManager::SendPacket(to, opCode, args);
+	std::lock_guard<std::mutex> lock{ sendMutex };
+	Packet& packet = CreatePacket(opCode, args);
+	SendToClient(to, packet);
+	packet.Release();
 }
 
-void ServerSocketManager::SendPacketToAllClients(const OpCode opcode, const std::vector<std::string>& args)
+// For combat and loot, which only matter to players who can see the entities involved. Called while the
+// World ticks, so it only queues the message on the World; SendInterestEvents sends it.
+void ServerSocketManager::SendPacketToInterestedClients(PlayerComponentManager& playerComponentManager, const OpCode opCode, const std::vector<std::string>& args, const int entityId, const int otherEntityId)
 {
-	const auto playerComponentManager = componentOrchestrator.GetPlayerComponentManager();
-	const auto* const playerComponents = playerComponentManager->GetPlayerComponents();
-	const auto playerComponentIndex = playerComponentManager->GetPlayerComponentIndex();
+	FindWorld(playerComponentManager).GetInterestEvents().push_back(InterestEvent{ opCode, args, { entityId, otherEntityId } });
+}
 
-	for (auto i = 0; i < playerComponentIndex; i++)
+// Bytes on the wire and compression CPU per client per tick, averaged since the last call.
+void ServerSocketManager::PrintCompressionStats(const int ticks)
+{
+	const auto& stats = GetCompressionStats();
+	const auto clients = Utility::Max<int>(1, GetConnectionCount());
+	const auto perClientTick = static_cast<double>(clients) * Utility::Max<int>(1, ticks);
+	const auto ratio = stats.uncompressedBytes > 0 ? static_cast<double>(stats.compressedBytes) / stats.uncompressedBytes : 1.0;
+
+	std::cout << "Network: " << GetConnectionCount() << " clients, "
+		<< stats.bytesSent / perClientTick << " bytes/tick/client, "
+		<< stats.messagesCompressed << " messages compressed to " << ratio * 100.0 << "%, "
+		<< (stats.compressTime + stats.decompressTime) * 1000000.0 / perClientTick << "us CPU/tick/client\n";
+
+	ResetCompressionStats();
+}
+
+// Per-OpCode traffic and handler CPU, heaviest first, and the busiest inbound sessions, since the last call.
+void ServerSocketManager::PrintNetworkStats()
+{
+	const auto& stats = GetNetworkStats();
+	const auto elapsed = Utility::Max<double>(GetTime() - stats.startTime, 0.001);
+
+	std::vector<std::pair<OpCode, OpCodeStats>> opCodes{ stats.opCodes.begin(), stats.opCodes.end() };
+	std::sort(opCodes.begin(), opCodes.end(), [](const auto& l, const auto& r)
+	{
+		return l.second.sent.bytes + l.second.received.bytes > r.second.sent.bytes + r.second.received.bytes;
+	});
+
+	std::cout << "Network rejects: " << stats.checksumRejects << " checksum, "
+		<< stats.malformedDatagrams << " malformed, "
+		<< stats.decompressionFailures << " decompression, "
+		<< stats.unknownOpCodes << " unknown OpCode, "
+		<< stats.handshakeRejects << " handshake; "
+		<< stats.connectionTimeouts << " connection timeouts\n";
+
+	if (const auto networkSimulator = GetNetworkSimulator())
 	{
-		SendPacket(playerComponents[i].GetFromSockAddr(), opcode, args);
+		const auto& simulatorStats = networkSimulator->GetStats();
+		std::cout << "Network simulator: " << simulatorStats.datagramsLost << " lost, "
+			<< simulatorStats.datagramsOverCapacity << " over capacity, "
+			<< simulatorStats.datagramsDuplicated << " duplicated, "
+			<< simulatorStats.datagramsReordered << " reordered\n";
+		networkSimulator->ResetStats();
 	}
+
+	std::cout << std::fixed << std::setprecision(1);
+	for (const auto& pair : opCodes)
+	{
+		const OpCodeStats& opCodeStats = pair.second;
+		std::cout << "  " << std::left << std::setw(26) << GetOpCodeName(pair.first) << std::right
+			<< " out " << std::setw(8) << opCodeStats.sent.messages / elapsed << " msg/s " << std::setw(10) << opCodeStats.sent.bytes / elapsed << " B/s"
+			<< " | in " << std::setw(8) << opCodeStats.received.messages / elapsed << " msg/s " << std::setw(10) << opCodeStats.received.bytes / elapsed << " B/s"
+			<< " | handler " << std::setw(8) << (opCodeStats.received.messages > 0 ? opCodeStats.handlerTime * 1000000.0 / opCodeStats.received.messages : 0.0) << "us avg"
+			<< " | " << opCodeStats.decodeFailures << " decode failures"
+			<< " | " << opCodeStats.rateLimited << " rate limited\n";
+	}
+
+	auto sessions = GetSessionStats();
+	std::sort(sessions.begin(), sessions.end(), [](const SessionStats& l, const SessionStats& r) { return l.bytesPerSecond > r.bytesPerSecond; });
+	for (auto i = 0; i < Utility::Min<int>(NETWORK_STATS_TOP_SESSIONS, static_cast<int>(sessions.size())); i++)
+	{
+		char str[INET_ADDRSTRLEN];
+		inet_ntop(AF_INET, &(sessions[i].address.sin_addr), str, INET_ADDRSTRLEN);
+		std::cout << "  session " << str << ":" << ntohs(sessions[i].address.sin_port)
+			<< " in " << sessions[i].datagramsPerSecond << " datagrams/s, "
+			<< sessions[i].messagesPerSecond << " msg/s, "
+			<< sessions[i].bytesPerSecond << " B/s\n";
+	}
+
+	Histogram rtts;
+	Histogram jitters;
+	RecordSessionLatencies(rtts, jitters);
+	if (rtts.GetCount() > 0)
+	{
+		std::cout << "  clock sync over " << rtts.GetCount() << " sessions: RTT p50 " << rtts.GetValueAtPercentile(0.5) * 1000.0
+			<< "ms, p99 " << rtts.GetValueAtPercentile(0.99) * 1000.0
+			<< "ms, jitter p50 " << jitters.GetValueAtPercentile(0.5) * 1000.0
+			<< "ms, p99 " << jitters.GetValueAtPercentile(0.99) * 1000.0 << "ms\n";
+	}
+	std::cout << std::defaultfloat;
+
+	ResetNetworkStats();
 }
 
+// Also fails for accounts that aren't logged in here, e.g. a client that was just handed off to another zone.
 const bool ServerSocketManager::ValidateToken(const int accountId, const std::string token)
 {
-	const auto playerComponentManager = componentOrchestrator.GetPlayerComponentManager();
-	const auto gameObject = objectManager.GetGameObjectById(accountId);
-	const auto playerComponent = playerComponentManager->GetComponentById(gameObject.playerComponentId);
-	
-	return token == playerComponent.GetToken();
+	if (accountWorlds.find(accountId) == accountWorlds.end())
+		return false;
+
+	return token == GetPlayerComponent(accountId).GetToken();
 }
 
 PlayerComponent& ServerSocketManager::GetPlayerComponent(const int accountId)
 {
-	const auto playerComponentManager = componentOrchestrator.GetPlayerComponentManager();
-	const auto gameObject = objectManager.GetGameObjectById(accountId);
+	World& world = GetWorld(accountId);
+	const auto gameObject = world.GetObjectManager().GetGameObjectById(accountId);
 
-	return playerComponentManager->GetComponentById(gameObject.playerComponentId);
+	return world.GetPlayerComponentManager().GetComponentById(gameObject.playerComponentId);
+}
+
+// The account playing the named character in this process, or -1. Players still choosing a character have no name yet.
+const int ServerSocketManager::FindAccountByCharacterName(const std::string& characterName)
+{
+	for (const auto& pair : accountWorlds)
+	{
+		const GameObject& player = pair.second->GetObjectManager().GetGameObjectById(pair.first);
+		if (!player.name.empty() && player.name == characterName)
+			return pair.first;
+	}
+	return -1;
 }
 
 void ServerSocketManager::HandleTimeout()
 {
-	const auto playerComponentManager = componentOrchestrator.GetPlayerComponentManager();
-	const auto* const playerComponents = playerComponentManager->GetPlayerComponents();
-	const auto playerComponentIndex = playerComponentManager->GetPlayerComponentIndex();
+	for (World* world : worlds)
+	{
+		PlayerComponentManager& playerComponentManager = world->GetPlayerComponentManager();
+		const auto* const playerComponents = playerComponentManager.GetPlayerComponents();
+		const auto playerComponentIndex = playerComponentManager.GetPlayerComponentIndex();
 
-	for (auto i = 0; i < playerComponentIndex; i++)
+		for (auto i = 0; i < playerComponentIndex; i++)
+		{
+			const auto comp = playerComponents[i];
+
+			// gateways handle heartbeats and time their own clients out
+			if (gatewayClients.find(GetEndpointKey(comp.GetFromSockAddr())) != gatewayClients.end())
+				continue;
+
+			if (GetTickCount64() > comp.lastHeartbeat + TIMEOUT_DURATION)
+			{
+				DisconnectClient(comp.GetFromSockAddr());
+				world->GetObjectManager().DeleteGameObject(world->GetEventHandler(), comp.GetGameObjectId());
+				accountWorlds.erase(comp.GetGameObjectId());
+				chatChannels.Remove(comp.GetGameObjectId());
+			}
+		}
+	}
+}
+
+// A GUID, unless seeded tokens are on, in which case it comes from the World's seeded RNG so that a
+// replayed capture hands out the same tokens the recorded clients used. Seeded tokens are guessable.
+const std::string ServerSocketManager::CreateToken(World& world)
+{
+	GUID guid;
+	if (seededTokens)
+	{
+		std::mt19937& rng = world.GetComponentOrchestrator().GetRandomEngine();
+		guid.Data1 = static_cast<unsigned long>(rng());
+		guid.Data2 = static_cast<unsigned short>(rng());
+		guid.Data3 = static_cast<unsigned short>(rng());
+		for (auto i = 0; i < 8; i++)
+			guid.Data4[i] = static_cast<unsigned char>(rng());
+	}
+	else if (FAILED(CoCreateGuid(&guid)))
+		throw std::exception("Failed to create GUID.");
+
+	char guid_cstr[39];
+	snprintf(guid_cstr, sizeof(guid_cstr),
+		"{%08x-%04x-%04x-%02x%02x-%02x%02x%02x%02x%02x%02x}",
+		guid.Data1, guid.Data2, guid.Data3,
+		guid.Data4[0], guid.Data4[1], guid.Data4[2], guid.Data4[3],
+		guid.Data4[4], guid.Data4[5], guid.Data4[6], guid.Data4[7]);
+	return std::string{ guid_cstr };
+}
+
+void ServerSocketManager::SetSeededTokens(const bool seeded) { seededTokens = seeded; }
+
+void ServerSocketManager::SetTickEpoch(const double epoch) { tickEpoch = epoch; }
+
+// The RTT and jitter each logged in client last reported from its clock sync.
+void ServerSocketManager::RecordSessionLatencies(Histogram& rtts, Histogram& jitters)
+{
+	for (World* world : worlds)
 	{
-		const auto comp = playerComponents[i];
-		if (GetTickCount64() > comp.lastHeartbeat + TIMEOUT_DURATION)
+		PlayerComponentManager& playerComponentManager = world->GetPlayerComponentManager();
+		const auto* const playerComponents = playerComponentManager.GetPlayerComponents();
+		const auto playerComponentIndex = playerComponentManager.GetPlayerComponentIndex();
+
+		for (auto i = 0; i < playerComponentIndex; i++)
 		{
-			objectManager.DeleteGameObject(eventHandler, comp.GetGameObjectId());
+			if (playerComponents[i].rtt <= 0.0f)
+				continue;
+			rtts.Record(playerComponents[i].rtt);
+			jitters.Record(playerComponents[i].jitter);
 		}
 	}
 }
@@ -152,28 +370,7 @@ void ServerSocketManager::Login(const std::string& accountName, const std::strin
 		if (crypto_pwhash_str_verify(account->GetPassword().c_str(), password.c_str(), strlen(password.c_str())) != 0)
 			error = INCORRECT_PASSWORD;
 		else
-		{
-			GUID guid;
-			if (FAILED(CoCreateGuid(&guid)))
-				throw std::exception("Failed to create GUID.");
-			char guid_cstr[39];
-			snprintf(guid_cstr, sizeof(guid_cstr),
-				"{%08x-%04x-%04x-%02x%02x-%02x%02x%02x%02x%02x%02x}",
-				guid.Data1, guid.Data2, guid.Data3,
-				guid.Data4[0], guid.Data4[1], guid.Data4[2], guid.Data4[3],
-				guid.Data4[4], guid.Data4[5], guid.Data4[6], guid.Data4[7]);
-			const std::string token{ guid_cstr };
-
-			const auto accountId = account->GetId();
-			const std::string name{ "" };
-			GameObject& playerGameObject = objectManager.CreateGameObject(VEC_ZERO, XMFLOAT3{ 14.0f, 14.0f, 14.0f }, PLAYER_SPEED, GameObjectType::Player, name, accountId);
-			const auto playerComponentManager = componentOrchestrator.GetPlayerComponentManager();
-			const PlayerComponent& playerComponent = playerComponentManager->CreatePlayerComponent(playerGameObject.GetId(), token, ipAndPort, from, GetTickCount64());
-			playerGameObject.playerComponentId = playerComponent.GetId();
-            
-			std::vector<std::string> args{ std::to_string(accountId), token, ListCharacters(accountId) };
-			SendPacket(from, OpCode::LoginSuccess, args);
-		}
+			CreateSession(account->GetId(), ipAndPort, from);
 	}
 	else
 		error = INCORRECT_USERNAME;
@@ -185,9 +382,29 @@ void ServerSocketManager::Login(const std::string& accountName, const std::strin
 	}
 }
 
+// Everything after the password check, which a gateway does itself before sending GatewayLogin.
+void ServerSocketManager::CreateSession(const int accountId, const std::string& ipAndPort, const sockaddr_in& address)
+{
+	World& world = GetLeastPopulatedWorld();
+	const auto token = CreateToken(world);
+
+	const std::string name{ "" };
+	GameObject& playerGameObject = world.GetObjectManager().CreateGameObject(VEC_ZERO, XMFLOAT3{ 14.0f, 14.0f, 14.0f }, PLAYER_SPEED, GameObjectType::Player, name, accountId);
+	const PlayerComponent& playerComponent = world.GetPlayerComponentManager().CreatePlayerComponent(playerGameObject.GetId(), token, ipAndPort, address, GetTickCount64());
+	playerGameObject.playerComponentId = playerComponent.GetId();
+	accountWorlds[accountId] = &world;
+
+	std::vector<std::string> args{ std::to_string(accountId), token, ListCharacters(accountId) };
+	SendPacket(address, OpCode::LoginSuccess, args);
+}
+
 void ServerSocketManager::Logout(const int accountId)
 {
-	objectManager.DeleteGameObject(eventHandler, accountId);
+	World& world = GetWorld(accountId);
+	DisconnectClient(GetPlayerComponent(accountId).GetFromSockAddr());
+	world.GetObjectManager().DeleteGameObject(world.GetEventHandler(), accountId);
+	accountWorlds.erase(accountId);
+	chatChannels.Remove(accountId);
 }
 
 void ServerSocketManager::CreateAccount(const std::string& accountName, const std::string& password, const sockaddr_in& from)
@@ -273,7 +490,8 @@ std::string ServerSocketManager::ListAbilities(const int characterId)
 
 void ServerSocketManager::EnterWorld(const int accountId, const std::string& characterName)
 {
-	GameObject& gameObject = objectManager.GetGameObjectById(accountId);
+	World& world = GetWorld(accountId);
+	GameObject& gameObject = world.GetObjectManager().GetGameObjectById(accountId);
 	gameObject.name = characterName;
 
 	PlayerComponent& playerComponent = GetPlayerComponent(accountId);
@@ -283,6 +501,9 @@ void ServerSocketManager::EnterWorld(const int accountId, const std::string& cha
 	playerComponent.characterId = character.GetId();
 	playerComponent.modelId = character.GetModelId();
 	playerComponent.textureId = character.GetTextureId();
+	playerComponent.guildName = serverRepository.GetCharacterGuild(character.GetId());
+	playerComponent.correctionPending = true;
+	chatChannels.SetGuild(accountId, playerComponent.guildName, GetTime());
 
 	const auto agility = character.GetAgility();
 	const auto strength = character.GetStrength();
@@ -299,8 +520,7 @@ void ServerSocketManager::EnterWorld(const int accountId, const std::string& cha
 	const auto maxStamina = character.GetMaxStamina();
 
 	const auto gameObjectId = gameObject.GetId();
-	const auto statsComponentManager = componentOrchestrator.GetStatsComponentManager();
-	const StatsComponent& statsComponent = statsComponentManager->CreateStatsComponent(
+	const StatsComponent& statsComponent = world.GetStatsComponentManager().CreateStatsComponent(
 		gameObjectId,
 		agility, strength, wisdom, intelligence, charisma, luck, endurance,
 		health, maxHealth, mana, maxMana, stamina, maxStamina
@@ -308,12 +528,10 @@ void ServerSocketManager::EnterWorld(const int accountId, const std::string& cha
 	gameObject.statsComponentId = statsComponent.GetId();
 
 	auto skills = serverRepository.ListCharacterSkills(character.GetId());
-	const auto skillComponentManager = componentOrchestrator.GetSkillComponentManager();
-	const SkillComponent& skillComponent = skillComponentManager->CreateSkillComponent(gameObjectId, skills);
+	const SkillComponent& skillComponent = world.GetSkillComponentManager().CreateSkillComponent(gameObjectId, skills);
 	gameObject.skillComponentId = skillComponent.GetId();
 
-	const auto inventoryComponentManager = componentOrchestrator.GetInventoryComponentManager();
-	const InventoryComponent& inventoryComponent = inventoryComponentManager->CreateInventoryComponent(gameObjectId);
+	const InventoryComponent& inventoryComponent = world.GetInventoryComponentManager().CreateInventoryComponent(gameObjectId);
 	gameObject.inventoryComponentId = inventoryComponent.GetId();
 
 	const auto pos = character.GetPosition();
@@ -329,7 +547,7 @@ void ServerSocketManager::EnterWorld(const int accountId, const std::string& cha
 		std::to_string(health), std::to_string(maxHealth), std::to_string(mana), std::to_string(maxMana), std::to_string(stamina), std::to_string(maxStamina),
 	};
 	SendPacket(playerComponent.GetFromSockAddr(), OpCode::EnterWorldSuccess, args);
-	gameMap.SetTileOccupied(pos, true);
+	world.GetGameMap().SetTileOccupied(pos, true);
 }
 
 void ServerSocketManager::DeleteCharacter(const int accountId, const std::string& characterName)
@@ -340,93 +558,551 @@ void ServerSocketManager::DeleteCharacter(const int accountId, const std::string
 	SendPacket(playerComponent.GetFromSockAddr(), OpCode::DeleteCharacterSuccess, args);
 }
 
+// Hands off players that have moved into another zone, and drops stale ghosts and transferred clients.
+// Runs on the main thread between World ticks.
+void ServerSocketManager::UpdateZones()
+{
+	const auto now = GetTime();
+
+	if (zoneMap.GetZoneCount() > 1)
+	{
+		for (World* world : worlds)
+		{
+			PlayerComponentManager& playerComponentManager = world->GetPlayerComponentManager();
+			auto* const playerComponents = playerComponentManager.GetPlayerComponents();
+			for (auto i = 0; i < playerComponentManager.GetPlayerComponentIndex(); i++)
+			{
+				PlayerComponent& playerComponent = playerComponents[i];
+				if (playerComponent.characterId == 0)
+					continue;
+
+				// a player mid-move is handed off as soon as the tile it's moving to is across the border
+				const GameObject& player = world->GetObjectManager().GetGameObjectById(playerComponent.GetGameObjectId());
+				const auto moving = player.movementVector.x != 0.0f || player.movementVector.z != 0.0f;
+				const auto position = moving ? player.destination : player.localPosition;
+				if (zoneMap.IsLocal(position))
+					continue;
+
+				const auto pending = pendingHandoffs.find(player.GetId());
+				if (pending != pendingHandoffs.end() && now - pending->second < ZONE_HANDOFF_RETRY)
+					continue;
+
+				HandOffPlayer(*world, playerComponent, position, zoneMap.GetZone(zoneMap.GetZoneIndex(position)));
+				pendingHandoffs[player.GetId()] = now;
+			}
+
+			auto& ghosts = world->GetGhosts();
+			for (auto it = ghosts.begin(); it != ghosts.end();)
+			{
+				if (now - it->second.lastUpdateTime > ZONE_GHOST_TIMEOUT)
+					it = ghosts.erase(it);
+				else
+					it++;
+			}
+		}
+	}
+
+	while (!transferredClients.empty() && now - transferredClients.front().second > ZONE_TRANSFER_LINGER)
+	{
+		DisconnectClient(transferredClients.front().first);
+		transferredClients.erase(transferredClients.begin());
+	}
+}
+
+// Sends the zone the player is moving into a snapshot of the player to carry on from. The player keeps its token, so the
+// client's session survives the move. Until the other zone accepts, the player takes no more input here,
+// so the snapshot stays accurate.
+void ServerSocketManager::HandOffPlayer(World& world, PlayerComponent& playerComponent, const XMFLOAT3& position, const Zone& zone)
+{
+	const GameObject& player = world.GetObjectManager().GetGameObjectById(playerComponent.GetGameObjectId());
+	const StatsComponent& stats = world.GetStatsComponentManager().GetComponentById(player.statsComponentId);
+	const SkillComponent& skillComponent = world.GetSkillComponentManager().GetComponentById(player.skillComponentId);
+	const InventoryComponent& inventoryComponent = world.GetInventoryComponentManager().GetComponentById(player.inventoryComponentId);
+
+	std::string skills{ "" };
+	for (const auto& skill : skillComponent.GetSkills())
+		skills += std::to_string(skill->id) + "%" + std::to_string(skill->value) + ";";
+
+	std::string itemIds{ "" };
+	for (const auto itemId : inventoryComponent.itemIds)
+		itemIds += std::to_string(itemId) + ";";
+
+	char clientAddress[INET_ADDRSTRLEN];
+	ZeroMemory(clientAddress, sizeof(clientAddress));
+	inet_ntop(AF_INET, &(playerComponent.GetFromSockAddr().sin_addr), clientAddress, INET_ADDRSTRLEN);
+
+	// a client behind a gateway stays behind it, so the other zone has to reply through the same one
+	char gatewayAddress[INET_ADDRSTRLEN];
+	ZeroMemory(gatewayAddress, sizeof(gatewayAddress));
+	u_short gatewayPort{ 0 };
+	const auto gateway = gatewayClients.find(GetEndpointKey(playerComponent.GetFromSockAddr()));
+	if (gateway != gatewayClients.end())
+	{
+		inet_ntop(AF_INET, &(gateway->second.sin_addr), gatewayAddress, INET_ADDRSTRLEN);
+		gatewayPort = ntohs(gateway->second.sin_port);
+	}
+
+	std::vector<std::string> args
+	{
+		std::to_string(world.GetId()), std::to_string(player.GetId()), playerComponent.GetToken(), playerComponent.GetIPAndPort(),
+		std::string{ clientAddress }, std::to_string(ntohs(playerComponent.GetFromSockAddr().sin_port)),
+		std::to_string(playerComponent.characterId), std::to_string(playerComponent.modelId), std::to_string(playerComponent.textureId), player.name,
+		std::to_string(position.x), std::to_string(position.y), std::to_string(position.z),
+		std::to_string(playerComponent.lastProcessedInputSequence),
+		std::to_string(stats.agility), std::to_string(stats.strength), std::to_string(stats.wisdom), std::to_string(stats.intelligence), std::to_string(stats.charisma), std::to_string(stats.luck), std::to_string(stats.endurance),
+		std::to_string(stats.health), std::to_string(stats.maxHealth), std::to_string(stats.mana), std::to_string(stats.maxMana), std::to_string(stats.stamina), std::to_string(stats.maxStamina),
+		skills, itemIds,
+		std::string{ gatewayAddress }, std::to_string(gatewayPort),
+		std::to_string(player.replicationSequence), playerComponent.guildName
+	};
+	SendPacket(zone.address, OpCode::ZoneHandoff, args);
+
+	playerComponent.pendingInputCount = 0;
+	playerComponent.rightMouseDownDir = VEC_ZERO;
+	playerComponent.autoAttackOn = false;
+}
+
+// Recreates a player handed off by a neighbouring zone. Resends of a handoff that was already accepted
+// are just accepted again.
+void ServerSocketManager::AcceptHandoff(const std::vector<std::string>& args)
+{
+	const auto accountId = std::stoi(args.at(1));
+	if (accountWorlds.find(accountId) == accountWorlds.end())
+	{
+		World* world = FindWorld(std::stoi(args.at(0)));
+		if (!world)
+			world = &GetLeastPopulatedWorld();
+
+		sockaddr_in clientAddress;
+		ZeroMemory(&clientAddress, sizeof(clientAddress));
+		clientAddress.sin_family = AF_INET;
+		inet_pton(AF_INET, args.at(4).c_str(), &clientAddress.sin_addr);
+		clientAddress.sin_port = htons(static_cast<u_short>(std::stoi(args.at(5))));
+
+		const XMFLOAT3 position{ std::stof(args.at(10)), std::stof(args.at(11)), std::stof(args.at(12)) };
+		GameObject& player = world->GetObjectManager().CreateGameObject(position, XMFLOAT3{ 14.0f, 14.0f, 14.0f }, PLAYER_SPEED, GameObjectType::Player, args.at(9), accountId);
+		const auto gameObjectId = player.GetId();
+
+		PlayerComponent& playerComponent = world->GetPlayerComponentManager().CreatePlayerComponent(gameObjectId, args.at(2), args.at(3), clientAddress, GetTickCount64());
+		player.playerComponentId = playerComponent.GetId();
+		playerComponent.characterId = std::stoi(args.at(6));
+		playerComponent.modelId = std::stoi(args.at(7));
+		playerComponent.textureId = std::stoi(args.at(8));
+		playerComponent.lastProcessedInputSequence = std::stoul(args.at(13));
+		playerComponent.lastReceivedInputSequence = playerComponent.lastProcessedInputSequence;
+		playerComponent.guildName = args.at(32);
+		chatChannels.SetGuild(accountId, playerComponent.guildName, GetTime());
+
+		int stats[13];
+		for (auto i = 0; i < 13; i++)
+			stats[i] = std::stoi(args.at(14 + i));
+		const StatsComponent& statsComponent = world->GetStatsComponentManager().CreateStatsComponent(
+			gameObjectId,
+			stats[0], stats[1], stats[2], stats[3], stats[4], stats[5], stats[6],
+			stats[7], stats[8], stats[9], stats[10], stats[11], stats[12]);
+		player.statsComponentId = statsComponent.GetId();
+
+		std::vector<WrenCommon::Skill> skills;
+		std::istringstream skillStream{ args.at(27) };
+		std::string skill;
+		while (std::getline(skillStream, skill, ';'))
+		{
+			const auto separator = skill.find('%');
+			skills.push_back(WrenCommon::Skill{ std::stoi(skill.substr(0, separator)), "", std::stoi(skill.substr(separator + 1)) });
+		}
+		const SkillComponent& skillComponent = world->GetSkillComponentManager().CreateSkillComponent(gameObjectId, skills);
+		player.skillComponentId = skillComponent.GetId();
+
+		InventoryComponent& inventoryComponent = world->GetInventoryComponentManager().CreateInventoryComponent(gameObjectId);
+		player.inventoryComponentId = inventoryComponent.GetId();
+		std::istringstream itemStream{ args.at(28) };
+		std::string itemId;
+		for (auto slot = 0; slot < inventoryComponent.itemIds.size() && std::getline(itemStream, itemId, ';'); slot++)
+			inventoryComponent.itemIds[slot] = std::stoi(itemId);
+
+		// our clients may have seen the player's ghost, so its updates carry on from the newest sequence they had
+		player.replicationSequence = static_cast<unsigned short>(std::stoul(args.at(31)));
+		auto& ghosts = world->GetGhosts();
+		const auto ghost = ghosts.find(accountId);
+		if (ghost != ghosts.end())
+		{
+			if (SequenceGreaterThan(ghost->second.state.sequence, player.replicationSequence))
+				player.replicationSequence = ghost->second.state.sequence;
+			ghosts.erase(ghost);
+		}
+
+		world->GetGameMap().SetTileOccupied(position, true);
+		accountWorlds[accountId] = world;
+
+		if (!args.at(29).empty())
+		{
+			sockaddr_in gatewayAddress;
+			ZeroMemory(&gatewayAddress, sizeof(gatewayAddress));
+			gatewayAddress.sin_family = AF_INET;
+			inet_pton(AF_INET, args.at(29).c_str(), &gatewayAddress.sin_addr);
+			gatewayAddress.sin_port = htons(static_cast<u_short>(std::stoi(args.at(30))));
+			if (IsGateway(gatewayAddress))
+				gatewayClients[GetEndpointKey(clientAddress)] = gatewayAddress;
+		}
+	}
+
+	std::vector<std::string> acceptedArgs{ std::to_string(accountId) };
+	SendPacket(from, OpCode::ZoneHandoffAccepted, acceptedArgs);
+}
+
+// The other zone has the player now: point the client at it and forget the player here.
+void ServerSocketManager::CompleteHandoff(const int accountId)
+{
+	pendingHandoffs.erase(accountId);
+
+	const auto zone = zoneMap.FindZone(from);
+	if (accountWorlds.find(accountId) == accountWorlds.end() || zone == -1)
+		return;
+
+	World& world = GetWorld(accountId);
+	const PlayerComponent& playerComponent = GetPlayerComponent(accountId);
+	const auto clientAddress = playerComponent.GetFromSockAddr();
+
+	char zoneAddress[INET_ADDRSTRLEN];
+	ZeroMemory(zoneAddress, sizeof(zoneAddress));
+	inet_ntop(AF_INET, &(zoneMap.GetZone(zone).address.sin_addr), zoneAddress, INET_ADDRSTRLEN);
+	std::vector<std::string> args{ std::string{ zoneAddress }, std::to_string(ntohs(zoneMap.GetZone(zone).address.sin_port)) };
+	SendPacket(clientAddress, OpCode::ZoneTransfer, args);
+
+	GameObject& player = world.GetObjectManager().GetGameObjectById(accountId);
+	world.GetGameMap().SetTileOccupied(player.localPosition, false);
+	world.GetGameMap().SetTileOccupied(player.destination, false);
+	world.GetObjectManager().DeleteGameObject(world.GetEventHandler(), accountId);
+	accountWorlds.erase(accountId);
+	chatChannels.Remove(accountId);
+
+	transferredClients.push_back(std::make_pair(clientAddress, GetTime()));
+}
+
 void ServerSocketManager::UpdateClients()
 {
+	for (World* world : worlds)
+		UpdateClients(*world);
+}
+
+// Every Npc and Player is bit-packed into one Packet per tick. The World's ReplicationScheduler then picks
+// which of those Packets each client in the World gets this tick, within its bandwidth budget.
+void ServerSocketManager::UpdateClients(World& world)
+{
+	ObjectManager& objectManager = world.GetObjectManager();
 	const auto gameObjectLength = objectManager.GetGameObjectIndex();
-	const auto* const gameObjects = objectManager.GetGameObjects();
+	auto* const gameObjects = objectManager.GetGameObjects();
 
-	const auto playerComponentManager = componentOrchestrator.GetPlayerComponentManager();
-	const auto* const playerComponents = playerComponentManager->GetPlayerComponents();
+	const auto playerComponentManager = &world.GetPlayerComponentManager();
+	auto* const playerComponents = playerComponentManager->GetPlayerComponents();
 	const auto playerComponentIndex = playerComponentManager->GetPlayerComponentIndex();
 
-	const auto statsComponentManager = componentOrchestrator.GetStatsComponentManager();
+	const auto aiComponentManager = &world.GetAIComponentManager();
+	const auto statsComponentManager = &world.GetStatsComponentManager();
+	ReplicationScheduler& replicationScheduler = world.GetReplicationScheduler();
+
+	replicatedEntities.clear();
+	for (auto j = 0; j < gameObjectLength; j++)
+	{
+		GameObject& gameObject = gameObjects[j];
+
+		const auto type = gameObject.GetType();
+		if (type != GameObjectType::Npc && type != GameObjectType::Player)
+			continue;
+
+		const StatsComponent& stats = statsComponentManager->GetComponentById(gameObject.statsComponentId);
+
+		EntityState state;
+		state.sequence = ++gameObject.replicationSequence;
+		state.id = gameObject.GetId();
+		state.position = gameObject.GetWorldPosition();
+		state.movementVector = gameObject.movementVector;
+		state.agility = stats.agility;
+		state.strength = stats.strength;
+		state.wisdom = stats.wisdom;
+		state.intelligence = stats.intelligence;
+		state.charisma = stats.charisma;
+		state.luck = stats.luck;
+		state.endurance = stats.endurance;
+		state.health = stats.health;
+		state.maxHealth = stats.maxHealth;
+		state.mana = stats.mana;
+		state.maxMana = stats.maxMana;
+		state.stamina = stats.stamina;
+		state.maxStamina = stats.maxStamina;
+
+		auto targetId = -1;
+		const auto isPlayer = type == GameObjectType::Player;
+		if (isPlayer)
+		{
+			const PlayerComponent& otherPlayer = playerComponentManager->GetComponentById(gameObject.playerComponentId);
+			state.modelId = otherPlayer.modelId;
+			state.textureId = otherPlayer.textureId;
+			state.name = gameObject.name;
+			targetId = otherPlayer.targetId;
+		}
+		else if (gameObject.aiComponentId != -1)
+			targetId = aiComponentManager->GetComponentById(gameObject.aiComponentId).targetId;
+
+		// entities near a border are also shown to the zone across it
+		zoneMap.GetBorderZones(state.position, borderZones);
+		if (!borderZones.empty())
+		{
+			entityWriter.Reset();
+			entityWriter.WriteBits(world.GetId(), 16);
+			entityWriter.WriteBits(isPlayer ? 1 : 0, 1);
+			state.Write(entityWriter, isPlayer);
+			entityWriter.Flush();
+
+			Packet& borderUpdate = packetPool.Acquire();
+			borderUpdate.Begin(OpCode::ZoneBorderUpdate).Write(entityWriter);
+			for (const auto zone : borderZones)
+				SocketManager::SendPacket(zoneMap.GetZone(zone).address, borderUpdate);
+			borderUpdate.Release();
+		}
+
+		entityWriter.Reset();
+		state.Write(entityWriter, isPlayer);
+		entityWriter.Flush();
+
+		Packet& packet = packetPool.Acquire();
+		packet.Begin(isPlayer ? OpCode::PlayerUpdate : OpCode::NpcUpdate).Write(entityWriter);
+		replicatedEntities.push_back(ReplicatedEntity{ state.id, state.position, targetId, &packet });
+	}
+
+	for (const auto& pair : world.GetGhosts())
+	{
+		const ZoneGhost& ghost = pair.second;
+
+		entityWriter.Reset();
+		ghost.state.Write(entityWriter, ghost.isPlayer);
+		entityWriter.Flush();
+
+		Packet& packet = packetPool.Acquire();
+		packet.Begin(ghost.isPlayer ? OpCode::PlayerUpdate : OpCode::NpcUpdate).Write(entityWriter);
+		replicatedEntities.push_back(ReplicatedEntity{ ghost.state.id, ghost.state.position, -1, &packet });
+	}
+
+	replicationScheduler.BeginTick(replicatedEntities);
 
 	for (auto i = 0; i < playerComponentIndex; i++)
 	{
-		const PlayerComponent& playerToUpdate{ playerComponents[i] };
+		PlayerComponent& playerToUpdate{ playerComponents[i] };
 
 		// skip players that have logged in, but haven't selected a character and entered the game yet
 		if (playerToUpdate.characterId == 0)
 			continue;
 
-		// for each player, send them an update for every non-static game object
-		for (auto j = 0; j < gameObjectLength; j++)
+		const auto playerId = playerToUpdate.GetGameObjectId();
+		const GameObject& player = objectManager.GetGameObjectById(playerId);
+		const auto playerPosition = player.GetWorldPosition();
+
+		// the player's own movement is predicted by the client, which only needs the authoritative result
+		// of its inputs when the server's could differ: a move started or refused, or the player standing
+		// somewhere it wasn't last told, e.g. after arriving or being moved by the server
+		const auto now = GetTime();
+		const auto correctionDue = playerToUpdate.correctionPending
+			|| (player.movementVector == VEC_ZERO && player.localPosition != playerToUpdate.lastCorrectionPosition)
+			|| (playerToUpdate.lastProcessedInputSequence != playerToUpdate.lastCorrectionSequence && now - playerToUpdate.lastCorrectionTime >= CORRECTION_REFRESH_INTERVAL);
+
+		Packet* correction = nullptr;
+		if (correctionDue)
+		{
+			entityWriter.Reset();
+			// the player's update sequence was bumped above, so it also orders its corrections
+			PlayerMovement::WriteCorrection(entityWriter, player.replicationSequence, playerToUpdate.lastProcessedInputSequence, player);
+			entityWriter.Flush();
+
+			correction = &packetPool.Acquire();
+			correction->Begin(OpCode::PlayerCorrection).Write(entityWriter);
+
+			playerToUpdate.correctionPending = false;
+			playerToUpdate.lastCorrectionSequence = playerToUpdate.lastProcessedInputSequence;
+			playerToUpdate.lastCorrectionPosition = player.localPosition;
+			playerToUpdate.lastCorrectionTime = now;
+		}
+
+		// the correction comes out of the same byte budget as the entity updates
+		const auto reservedBytes = correction ? correction->GetLength() + ENTITY_MESSAGE_OVERHEAD : 0;
+		replicationScheduler.Schedule(playerId, playerPosition, playerToUpdate.targetId, replicatedEntities, scheduledEntities, reservedBytes);
+
+		for (auto j = 0; j < scheduledEntities.size(); j++)
+			SendToClient(playerToUpdate.GetFromSockAddr(), *replicatedEntities[scheduledEntities[j]].packet);
+
+		if (correction)
+		{
+			SendToClient(playerToUpdate.GetFromSockAddr(), *correction);
+			correction->Release();
+		}
+	}
+
+	replicationScheduler.EndTick();
+
+	for (auto j = 0; j < replicatedEntities.size(); j++)
+		replicatedEntities[j].packet->Release();
+
+	SendInterestEvents(world);
+}
+
+// Each event goes to the players within INTEREST_RADIUS of any entity involved, and to those entities if
+// they're players. It's encoded once, and the transport packs a client's events for the tick into the
+// same datagrams as its entity updates.
+void ServerSocketManager::SendInterestEvents(World& world)
+{
+	ObjectManager& objectManager = world.GetObjectManager();
+	auto& interestEvents = world.GetInterestEvents();
+
+	for (const auto& event : interestEvents)
+	{
+		interestRecipients.clear();
+		for (const auto entityId : event.entityIds)
 		{
-			const auto gameObject = gameObjects[j];
-
-			const auto pos = gameObject.GetWorldPosition();
-			const auto mov = gameObject.movementVector;
-
-			const auto id = std::to_string(gameObject.GetId());
-			const auto posX = std::to_string(pos.x);
-			const auto posY = std::to_string(pos.y);
-			const auto posZ = std::to_string(pos.z);
-			const auto movX = std::to_string(mov.x);
-			const auto movY = std::to_string(mov.y);
-			const auto movZ = std::to_string(mov.z);
-
-			const StatsComponent& stats = statsComponentManager->GetComponentById(gameObject.statsComponentId);
-			const auto agility = std::to_string(stats.agility);
-			const auto strength = std::to_string(stats.strength);
-			const auto wisdom = std::to_string(stats.wisdom);
-			const auto intelligence = std::to_string(stats.intelligence);
-			const auto charisma = std::to_string(stats.charisma);
-			const auto luck = std::to_string(stats.luck);
-			const auto endurance = std::to_string(stats.endurance);
-			const auto health = std::to_string(stats.health);
-			const auto maxHealth = std::to_string(stats.maxHealth);
-			const auto mana = std::to_string(stats.mana);
-			const auto maxMana = std::to_string(stats.maxMana);
-			const auto stamina = std::to_string(stats.stamina);
-			const auto maxStamina = std::to_string(stats.maxStamina);
-
-			const auto type = gameObject.GetType();
-			if (type == GameObjectType::Npc)
+			if (entityId < 0 || !objectManager.GameObjectExists(entityId))
+				continue;
+
+			const GameObject& entity = objectManager.GetGameObjectById(entityId);
+			if (entity.GetType() == GameObjectType::Player)
+				interestRecipients.push_back(entityId);
+			world.GetPlayerGrid().Query(entity.localPosition, INTEREST_RADIUS, interestRecipients);
+		}
+
+		std::sort(interestRecipients.begin(), interestRecipients.end());
+		interestRecipients.erase(std::unique(interestRecipients.begin(), interestRecipients.end()), interestRecipients.end());
+
+		Packet& packet = CreatePacket(event.opCode, event.args);
+		for (const auto recipientId : interestRecipients)
+		{
+			// logged out, or handed off to another zone, since it was queued
+			if (accountWorlds.find(recipientId) == accountWorlds.end())
+				continue;
+			SendToClient(GetPlayerComponent(recipientId).GetFromSockAddr(), packet);
+		}
+		packet.Release();
+	}
+	interestEvents.clear();
+}
+
+void ServerSocketManager::SetClientBytesPerTick(const int bytesPerTick)
+{
+	clientBytesPerTick = bytesPerTick;
+	for (World* world : worlds)
+		world->GetReplicationScheduler().SetBytesPerTick(bytesPerTick);
+}
+
+// A line only goes to its audience: players within SAY_RADIUS for say, the channel's members for party
+// and guild, and the sender's World for /w. It's encoded once and the same Packet goes to every recipient.
+void ServerSocketManager::PropagateChatMessage(World& world, const int accountId, const std::string& line)
+{
+	const auto senderAddress = GetPlayerComponent(accountId).GetFromSockAddr();
+	const GameObject& sender = world.GetObjectManager().GetGameObjectById(accountId);
+	const auto parsed = ChatChannels::Parse(line);
+	const auto now = GetTime();
+
+	switch (parsed.command)
+	{
+		case ChatCommand::Invalid:
+			SendPacket(senderAddress, OpCode::ServerMessage, { INVALID_CHAT_COMMAND, MESSAGE_TYPE_ERROR });
+			return;
+		case ChatCommand::Invite:
+		{
+			const auto inviteeId = FindAccountByCharacterName(parsed.text);
+			if (inviteeId == -1)
 			{
-				std::vector<std::string> args{ id, posX, posY, posZ, movX, movY, movZ, agility, strength, wisdom, intelligence, charisma, luck, endurance, health, maxHealth, mana, maxMana, stamina, maxStamina };
-				SendPacket(playerToUpdate.GetFromSockAddr(), OpCode::NpcUpdate, args);
+				SendPacket(senderAddress, OpCode::ServerMessage, { parsed.text + " isn't online.", MESSAGE_TYPE_ERROR });
+				return;
 			}
-			else if (type == GameObjectType::Player)
+			if (!chatChannels.Invite(accountId, inviteeId, now))
 			{
-				const PlayerComponent& otherPlayer = playerComponentManager->GetComponentById(gameObject.playerComponentId);
-				std::vector<std::string> args{ id, posX, posY, posZ, movX, movY, movZ, std::to_string(otherPlayer.modelId), std::to_string(otherPlayer.textureId), gameObject.name, agility, strength, wisdom, intelligence, charisma, luck, endurance, health, maxHealth, mana, maxMana, stamina, maxStamina };
-				SendPacket(playerToUpdate.GetFromSockAddr(), OpCode::PlayerUpdate, args);
+				SendPacket(senderAddress, OpCode::ServerMessage, { PARTY_INVITE_FAILED, MESSAGE_TYPE_ERROR });
+				return;
 			}
+			SendPacket(GetPlayerComponent(inviteeId).GetFromSockAddr(), OpCode::ServerMessage, { sender.name + " invited you to their party. Say /accept to join.", MESSAGE_TYPE_INFO });
+			SendPacket(senderAddress, OpCode::ServerMessage, { "Invited " + parsed.text + " to your party.", MESSAGE_TYPE_INFO });
+			return;
 		}
+		case ChatCommand::Accept:
+		{
+			const auto leaderId = chatChannels.AcceptInvite(accountId, now);
+			if (leaderId == -1)
+			{
+				SendPacket(senderAddress, OpCode::ServerMessage, { NO_PARTY_INVITE, MESSAGE_TYPE_ERROR });
+				return;
+			}
+			const auto& leaderName = GetWorld(leaderId).GetObjectManager().GetGameObjectById(leaderId).name;
+			SendPacket(senderAddress, OpCode::ServerMessage, { "Joined " + leaderName + "'s party.", MESSAGE_TYPE_INFO });
+			SendPacket(GetPlayerComponent(leaderId).GetFromSockAddr(), OpCode::ServerMessage, { sender.name + " joined your party.", MESSAGE_TYPE_INFO });
+			return;
+		}
+		case ChatCommand::Leave:
+			chatChannels.Leave(accountId, parsed.type);
+			SendPacket(senderAddress, OpCode::ServerMessage, { std::string{ "Left " } + ChatChannels::GetChannelTypeName(parsed.type) + ".", MESSAGE_TYPE_INFO });
+			return;
+		default:
+			break;
 	}
-}
 
-void ServerSocketManager::PropagateChatMessage(const std::string& senderName, const std::string& message)
-{
-	const auto playerComponentManager = componentOrchestrator.GetPlayerComponentManager();
-	const auto* const playerComponents = playerComponentManager->GetPlayerComponents();
-	const auto playerComponentIndex = playerComponentManager->GetPlayerComponentIndex();
+	if (chatChannels.Throttle(accountId, parsed.type, now))
+	{
+		SendPacket(senderAddress, OpCode::ServerMessage, { CHAT_THROTTLED, MESSAGE_TYPE_ERROR });
+		return;
+	}
 
-	for (auto i = 0; i < playerComponentIndex; i++)
+	chatRecipients.clear();
+	switch (parsed.type)
+	{
+		case ChatChannelType::Say:
+		{
+			world.GetPlayerGrid().Query(sender.localPosition, SAY_RADIUS, chatRecipients);
+			// the grid is rebuilt each tick, so a player who has only just entered the World isn't in it yet
+			if (std::find(chatRecipients.begin(), chatRecipients.end(), accountId) == chatRecipients.end())
+				chatRecipients.push_back(accountId);
+			break;
+		}
+		case ChatChannelType::Party:
+		case ChatChannelType::Guild:
+		{
+			const auto* const subscribers = chatChannels.GetSubscribers(accountId, parsed.type);
+			if (!subscribers)
+			{
+				SendPacket(senderAddress, OpCode::ServerMessage, { NOT_IN_CHAT_CHANNEL, MESSAGE_TYPE_ERROR });
+				return;
+			}
+			chatRecipients.assign(subscribers->begin(), subscribers->end());
+			break;
+		}
+		default:
+		{
+			PlayerComponentManager& playerComponentManager = world.GetPlayerComponentManager();
+			const auto* const playerComponents = playerComponentManager.GetPlayerComponents();
+			const auto playerComponentIndex = playerComponentManager.GetPlayerComponentIndex();
+			for (auto i = 0; i < playerComponentIndex; i++)
+				chatRecipients.push_back(playerComponents[i].GetGameObjectId());
+			break;
+		}
+	}
+
+	// the sender's name comes from its GameObject rather than the client, so it can't be spoofed
+	const std::vector<std::string> args{ parsed.text, sender.name, ChatChannels::GetChannelTypeName(parsed.type) };
+	Packet& packet = CreatePacket(OpCode::PropagateChatMessage, args);
+	for (const auto recipientId : chatRecipients)
 	{
-		std::vector<std::string> args{ senderName, message };
-		SendPacket(playerComponents[i].GetFromSockAddr(), OpCode::PropagateChatMessage, args);
+		// the grid can still hold players who have logged out since the last tick
+		if (accountWorlds.find(recipientId) == accountWorlds.end())
+			continue;
+		SendToClient(GetPlayerComponent(recipientId).GetFromSockAddr(), packet);
 	}
+	packet.Release();
 }
 
 void ServerSocketManager::ActivateAbility(PlayerComponent& playerComponent, const Ability& ability)
 {
 	if (ability.name == "Auto Attack")
 	{
+		World& world = GetWorld(playerComponent.GetGameObjectId());
+		ObjectManager& objectManager = world.GetObjectManager();
 		const GameObject& target = objectManager.GetGameObjectById(playerComponent.targetId);
 
-		const auto statsComponentManager = componentOrchestrator.GetStatsComponentManager();
-		const StatsComponent& targetStatsComponent = statsComponentManager->GetComponentById(target.statsComponentId);
+		const StatsComponent& targetStatsComponent = world.GetStatsComponentManager().GetComponentById(target.statsComponentId);
 
 		if (!playerComponent.autoAttackOn && playerComponent.targetId == -1)
 		{
@@ -467,8 +1143,10 @@ void ServerSocketManager::ActivateAbility(PlayerComponent& playerComponent, cons
 void ServerSocketManager::LootItem(const int accountId, const int gameObjectId, const int slot)
 {
 	// check if item exists, then move it from target inventory to player inventory, then send message to client
+	World& world = GetWorld(accountId);
+	ObjectManager& objectManager = world.GetObjectManager();
 	const GameObject& gameObject = objectManager.GetGameObjectById(gameObjectId);
-	const auto inventoryComponentManager = componentOrchestrator.GetInventoryComponentManager();
+	const auto inventoryComponentManager = &world.GetInventoryComponentManager();
 	InventoryComponent& inventoryComponent = inventoryComponentManager->GetComponentById(gameObject.inventoryComponentId);
 	const auto itemId = inventoryComponent.itemIds.at(slot); // TODO: validate array bounds passed from client
 
@@ -488,17 +1166,18 @@ void ServerSocketManager::LootItem(const int accountId, const int gameObjectId,
 		{
 			inventoryComponent.itemIds.at(slot) = -1;
 			std::vector<std::string> args{ std::to_string(gameObjectId), std::to_string(slot), std::to_string(destinationSlot), std::to_string(itemId), std::to_string(player.GetId()) };
-			SendPacketToAllClients(OpCode::LootItemSuccess, args);
+			SendPacketToInterestedClients(world.GetPlayerComponentManager(), OpCode::LootItemSuccess, args, gameObjectId, player.GetId());
 		}
 	}
 }
 
 void ServerSocketManager::MoveItem(const int accountId, const int draggingSlot, const int slot)
 {
-	const auto inventoryComponentManager = componentOrchestrator.GetInventoryComponentManager();
+	World& world = GetWorld(accountId);
+	const auto inventoryComponentManager = &world.GetInventoryComponentManager();
 
 	const PlayerComponent& playerComponent = GetPlayerComponent(accountId);
-	const GameObject& player = objectManager.GetGameObjectById(playerComponent.GetGameObjectId());
+	const GameObject& player = world.GetObjectManager().GetGameObjectById(playerComponent.GetGameObjectId());
 	InventoryComponent& playerInventoryComponent = inventoryComponentManager->GetComponentById(player.inventoryComponentId);
 
 	const auto success = playerInventoryComponent.MoveItem(draggingSlot, slot);
@@ -534,7 +1213,8 @@ void ServerSocketManager::InitializeMessageHandlers()
 		const auto accountId = std::stoi(args.at(0));
 		const std::string& token = args.at(1);
 
-		ValidateToken(accountId, token);
+		if (!ValidateToken(accountId, token))
+			return;
 		Logout(accountId);
 	};
 	
@@ -552,7 +1232,8 @@ void ServerSocketManager::InitializeMessageHandlers()
 		const std::string& token = args.at(1);
 		const std::string& characterName = args.at(2);
 
-		ValidateToken(accountId, token);
+		if (!ValidateToken(accountId, token))
+			return;
 		CreateCharacter(accountId, characterName);
 	};
 
@@ -561,7 +1242,8 @@ void ServerSocketManager::InitializeMessageHandlers()
 		const auto accountId = std::stoi(args.at(0));
 		const std::string& token = args.at(1);
 
-		ValidateToken(accountId, token);
+		if (!ValidateToken(accountId, token))
+			return;
 		UpdateLastHeartbeat(accountId);
 	};
 
@@ -571,7 +1253,8 @@ void ServerSocketManager::InitializeMessageHandlers()
 		const std::string& token = args.at(1);
 		const std::string& characterName = args.at(2);
 
-		ValidateToken(accountId, token);
+		if (!ValidateToken(accountId, token))
+			return;
 		EnterWorld(accountId, characterName);
 	};
 
@@ -581,7 +1264,8 @@ void ServerSocketManager::InitializeMessageHandlers()
 		const std::string& token = args.at(1);
 		const std::string& characterName = args.at(2);
 
-		ValidateToken(accountId, token);
+		if (!ValidateToken(accountId, token))
+			return;
 		DeleteCharacter(accountId, characterName);
 	};
 
@@ -591,7 +1275,8 @@ void ServerSocketManager::InitializeMessageHandlers()
 		const std::string& token = args.at(1);
 		const auto abilityId = std::stoi(args.at(2));
 
-		ValidateToken(accountId, token);
+		if (!ValidateToken(accountId, token))
+			return;
 		PlayerComponent& playerComponent = GetPlayerComponent(accountId);
 
 		const auto abilityIt = find_if(abilities.begin(), abilities.end(), [&abilityId](Ability ability) { return ability.abilityId == abilityId; });
@@ -605,11 +1290,12 @@ void ServerSocketManager::InitializeMessageHandlers()
 	{
 		const auto accountId = std::stoi(args.at(0));
 		const std::string& token = args.at(1);
-		const std::string& message = args.at(2);
-		const std::string& senderName = args.at(3);
+		// args.at(2) is the sender's name according to the client, which the server doesn't need
+		const std::string& line = args.at(3);
 
-		ValidateToken(accountId, token);
-		PropagateChatMessage(senderName, message);
+		if (!ValidateToken(accountId, token))
+			return;
+		PropagateChatMessage(GetWorld(accountId), accountId, line);
 	};
 
 	messageHandlers[OpCode::SetTarget] = [this](const std::vector<std::string>& args)
@@ -618,11 +1304,12 @@ void ServerSocketManager::InitializeMessageHandlers()
 		const std::string& token = args.at(1);
 		const auto targetId = std::stol(args.at(2));
 
-		ValidateToken(accountId, token);
+		if (!ValidateToken(accountId, token))
+			return;
 		PlayerComponent& playerComponent = GetPlayerComponent(accountId);
 		playerComponent.targetId = targetId;
 
-		const GameObject& gameObject = objectManager.GetGameObjectById(targetId);
+		const GameObject& gameObject = GetWorld(accountId).GetObjectManager().GetGameObjectById(targetId);
 
 		// Toggle off Auto-Attack on the server and the client if the player switches to an invalid target.
 		if (gameObject.isStatic && playerComponent.autoAttackOn)
@@ -640,7 +1327,8 @@ void ServerSocketManager::InitializeMessageHandlers()
 		const auto accountId = std::stoi(args.at(0));
 		const std::string& token = args.at(1);
 
-		ValidateToken(accountId, token);
+		if (!ValidateToken(accountId, token))
+			return;
 		PlayerComponent& playerComponent{ GetPlayerComponent(accountId) };
 		playerComponent.targetId = -1;
 	};
@@ -650,11 +1338,18 @@ void ServerSocketManager::InitializeMessageHandlers()
 		const auto accountId = std::stoi(args.at(0));
 		const std::string& token = args.at(1);
 		const std::string& pingId = args.at(2);
+		const std::string& clientTime = args.at(3);
+
+		if (!ValidateToken(accountId, token))
+			return;
 
-		ValidateToken(accountId, token);
+		// the client's own measurements, clamped since nothing stops it from lying
+		PlayerComponent& player = GetPlayerComponent(accountId);
+		player.rtt = Utility::Max<float>(0.0f, Utility::Min<float>(std::stof(args.at(4)), MAX_REPORTED_LATENCY));
+		player.jitter = Utility::Max<float>(0.0f, Utility::Min<float>(std::stof(args.at(5)), MAX_REPORTED_LATENCY));
 
-		const PlayerComponent& player = GetPlayerComponent(accountId);
-		std::vector<std::string> outgoingArgs{ pingId };
+		// the client's send time comes back untouched, so it needn't remember which ping is which
+		std::vector<std::string> outgoingArgs{ pingId, clientTime, std::to_string(GetTime() - tickEpoch) };
 		SendPacket(player.GetFromSockAddr(), OpCode::Pong, outgoingArgs);
 	};
 
@@ -664,7 +1359,8 @@ void ServerSocketManager::InitializeMessageHandlers()
 		const std::string& token = args.at(1);
 		const auto dir = XMFLOAT3{ std::stof(args.at(2)), std::stof(args.at(3)), std::stof(args.at(4)) };
 
-		ValidateToken(accountId, token);
+		if (!ValidateToken(accountId, token))
+			return;
 
 		PlayerComponent& comp = GetPlayerComponent(accountId);
 		comp.rightMouseDownDir = dir;
@@ -675,7 +1371,8 @@ void ServerSocketManager::InitializeMessageHandlers()
 		const auto accountId = std::stoi(args.at(0));
 		const std::string& token = args.at(1);
 
-		ValidateToken(accountId, token);
+		if (!ValidateToken(accountId, token))
+			return;
 
 		PlayerComponent& comp = GetPlayerComponent(accountId);
 		comp.rightMouseDownDir = VEC_ZERO;
@@ -687,12 +1384,34 @@ void ServerSocketManager::InitializeMessageHandlers()
 		const std::string& token = args.at(1);
 		const auto dir = XMFLOAT3{ std::stof(args.at(2)), std::stof(args.at(3)), std::stof(args.at(4)) };
 
-		ValidateToken(accountId, token);
+		if (!ValidateToken(accountId, token))
+			return;
 
 		PlayerComponent& comp = GetPlayerComponent(accountId);
 		comp.rightMouseDownDir = dir;
 	};
 
+	// accountId, token, input count, first input sequence, then one direction per input
+	binaryMessageHandlers[OpCode::PlayerInput] = [this](BitReader& reader)
+	{
+		const auto accountId = static_cast<int>(reader.ReadBits(32));
+		const auto token = reader.ReadString();
+		const auto inputCount = reader.ReadRangedInt(1, MAX_REDUNDANT_INPUTS);
+		const auto firstSequence = reader.ReadBits(32);
+
+		PlayerInput inputs[MAX_REDUNDANT_INPUTS];
+		for (auto i = 0; i < inputCount; i++)
+			inputs[i] = PlayerInput{ firstSequence + i, reader.ReadDirection() };
+
+		if (reader.Failed() || !ValidateToken(accountId, token) || pendingHandoffs.find(accountId) != pendingHandoffs.end())
+			return;
+
+		PlayerComponentManager& playerComponentManager = GetWorld(accountId).GetPlayerComponentManager();
+		PlayerComponent& comp = GetPlayerComponent(accountId);
+		for (auto i = 0; i < inputCount; i++)
+			playerComponentManager.QueueInput(comp, inputs[i]);
+	};
+
 	messageHandlers[OpCode::LootItem] = [this](const std::vector<std::string>& args)
 	{
 		const auto accountId = std::stoi(args.at(0));
@@ -700,7 +1419,8 @@ void ServerSocketManager::InitializeMessageHandlers()
 		const auto gameObjectId = std::stoi(args.at(2));
 		const auto slot = std::stoi(args.at(3));
 
-		ValidateToken(accountId, token);
+		if (!ValidateToken(accountId, token))
+			return;
 
 		LootItem(accountId, gameObjectId, slot);
 	};
@@ -712,8 +1432,104 @@ void ServerSocketManager::InitializeMessageHandlers()
 		const auto draggingSlot = std::stoi(args.at(2));
 		const auto slot = std::stoi(args.at(3));
 
-		ValidateToken(accountId, token);
+		if (!ValidateToken(accountId, token))
+			return;
 
 		MoveItem(accountId, draggingSlot, slot);
 	};
-}
+
+	// the zone messages are only ever accepted from the other zone servers
+
+	messageHandlers[OpCode::ZoneHandoff] = [this](const std::vector<std::string>& args)
+	{
+		if (zoneMap.FindZone(from) != -1)
+			AcceptHandoff(args);
+	};
+
+	messageHandlers[OpCode::ZoneHandoffAccepted] = [this](const std::vector<std::string>& args)
+	{
+		if (zoneMap.FindZone(from) != -1)
+			CompleteHandoff(std::stoi(args.at(0)));
+	};
+
+	// world id, whether it's a player, then the same EntityState as a PlayerUpdate or NpcUpdate
+	binaryMessageHandlers[OpCode::ZoneBorderUpdate] = [this](BitReader& reader)
+	{
+		if (zoneMap.FindZone(from) == -1)
+			return;
+
+		const auto worldId = static_cast<int>(reader.ReadBits(16));
+		const auto isPlayer = reader.ReadBits(1) == 1;
+		EntityState state;
+		state.Read(reader, isPlayer);
+
+		// an update can still be in flight for a player that has just been handed off to us
+		World* const world = FindWorld(worldId);
+		if (reader.Failed() || !world || (isPlayer && accountWorlds.find(state.id) != accountWorlds.end()))
+			return;
+
+		// border updates are unreliable, so one can be overtaken by a newer update for the same entity
+		auto& ghosts = world->GetGhosts();
+		const auto ghost = ghosts.find(state.id);
+		if (ghost != ghosts.end() && !SequenceGreaterThan(state.sequence, ghost->second.state.sequence))
+			return;
+
+		ghosts[state.id] = ZoneGhost{ state, isPlayer, GetTime() };
+	};
+
+	// the gateway messages are only ever accepted from the configured gateways
+
+	const auto handleGatewayForward = [this](BitReader& reader)
+	{
+		sockaddr_in client;
+		const char* message{ nullptr };
+		int length{ 0 };
+		if (IsGateway(from) && ReadForwardedMessage(reader, client, message, length))
+			HandleForwardedMessage(client, message, length);
+	};
+	binaryMessageHandlers[OpCode::GatewayForward] = handleGatewayForward;
+	binaryMessageHandlers[OpCode::GatewayForwardUnreliable] = handleGatewayForward;
+
+	// the gateway has already checked the password
+	messageHandlers[OpCode::GatewayLogin] = [this](const std::vector<std::string>& args)
+	{
+		if (!IsGateway(from))
+			return;
+
+		const auto accountId = std::stoi(args.at(0));
+		const std::string& ipAndPort = args.at(1);
+
+		sockaddr_in client;
+		ZeroMemory(&client, sizeof(client));
+		client.sin_family = AF_INET;
+		inet_pton(AF_INET, args.at(2).c_str(), &client.sin_addr);
+		client.sin_port = htons(static_cast<u_short>(std::stoi(args.at(3))));
+
+		gatewayClients[GetEndpointKey(client)] = from;
+		CreateSession(accountId, ipAndPort, client);
+	};
+
+	// the client went quiet, so the gateway has dropped it
+	messageHandlers[OpCode::GatewayDisconnect] = [this](const std::vector<std::string>& args)
+	{
+		if (!IsGateway(from))
+			return;
+
+		sockaddr_in client;
+		ZeroMemory(&client, sizeof(client));
+		client.sin_family = AF_INET;
+		inet_pton(AF_INET, args.at(0).c_str(), &client.sin_addr);
+		client.sin_port = htons(static_cast<u_short>(std::stoi(args.at(1))));
+
+		const auto clientKey = GetEndpointKey(client);
+		for (const auto& pair : accountWorlds)
+		{
+			if (GetEndpointKey(GetPlayerComponent(pair.first).GetFromSockAddr()) == clientKey)
+			{
+				Logout(pair.first);
+				break;
+			}
+		}
+		gatewayClients.erase(clientKey);
+	};
+}
\ No newline at end of file
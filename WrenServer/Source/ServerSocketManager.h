@@ -6,22 +6,50 @@
 #include "ServerRepository.h"
 #include "Components/ServerComponentOrchestrator.h"
 #include <EventHandling/EventHandler.h>
-#include <GameMap/GameMap.h>
-#include <ObjectManager.h>
 #include "Components/PlayerComponent.h"
+#include <Networking/EntityState.h>
+#include "ReplicationScheduler.h"
+#include "Zones/ZoneMap.h"
+#include "Chat/ChatChannels.h"
+#include <Profiling/Histogram.h>
+
+class World;
+class PlayerComponentManager;
 
 class ServerSocketManager : public SocketManager
 {
-	GameMap& gameMap;
-	ObjectManager& objectManager;
-	ServerComponentOrchestrator& componentOrchestrator;
 	ServerRepository& serverRepository;
 	CommonRepository& commonRepository;
+	const ZoneMap& zoneMap;
+	std::vector<World*> worlds;
+	std::unordered_map<int, World*> accountWorlds; // which World each logged in account's GameObject lives in
 	std::vector<Ability> abilities;
+	std::vector<ReplicatedEntity> replicatedEntities;
+	std::vector<int> scheduledEntities;
+	BitWriter entityWriter;
+	std::vector<int> borderZones;
+	std::unordered_map<int, double> pendingHandoffs;              // accountId to when its ZoneHandoff was sent
+	std::vector<std::pair<sockaddr_in, double>> transferredClients; // kept open until their ZoneTransfer has had time to arrive
+	std::vector<sockaddr_in> gateways;
+	std::unordered_map<unsigned __int64, sockaddr_in> gatewayClients; // endpoint key of each client connected through a gateway, to that gateway
+	ChatChannels chatChannels;
+	std::vector<int> chatRecipients;
+	std::vector<int> interestRecipients;
+	int clientBytesPerTick{ DEFAULT_CLIENT_BYTES_PER_TICK };
+	bool seededTokens{ false };
+	double tickEpoch{ 0.0 }; // local time of tick 0, so clients can line their clocks up with the ticks
+	std::mutex sendMutex; // Worlds tick on several threads and all send through here
 
+	World& GetWorld(const int accountId);
+	World& GetLeastPopulatedWorld();
+	World* FindWorld(const int worldId);
+	World& FindWorld(const PlayerComponentManager& playerComponentManager);
 	const bool ValidateToken(const int accountId, const std::string token); // this should probably return a PlayerComponent to improve performance
 	PlayerComponent& GetPlayerComponent(const int accountId);
+	const int FindAccountByCharacterName(const std::string& characterName);
+	const std::string CreateToken(World& world);
 	void Login(const std::string& accountName, const std::string& password, const std::string& ipAndPort, const sockaddr_in& from);
+	void CreateSession(const int accountId, const std::string& ipAndPort, const sockaddr_in& address);
 	void CreateAccount(const std::string& accountName, const std::string& password, const sockaddr_in& from);
 	void Logout(const int accountId);
 	void CreateCharacter(const int accountId, const std::string& characterName);
@@ -31,24 +59,39 @@ class ServerSocketManager : public SocketManager
 	std::string ListAbilities(const int characterId);
 	void EnterWorld(const int accountId, const std::string& characterName);
 	void DeleteCharacter(const int accountId, const std::string& characterName);
-	void PropagateChatMessage(const std::string& senderName, const std::string& message);
+	void PropagateChatMessage(World& world, const int accountId, const std::string& line);
 	void ActivateAbility(PlayerComponent& player, const Ability& ability);
 	void LootItem(const int accountId, const int gameObjectId, const int slot);
 	void MoveItem(const int accountId, const int draggingSlot, const int slot);
+	void UpdateClients(World& world);
+	void SendInterestEvents(World& world);
+	void HandOffPlayer(World& world, PlayerComponent& playerComponent, const XMFLOAT3& position, const Zone& zone);
+	void AcceptHandoff(const std::vector<std::string>& args);
+	void CompleteHandoff(const int accountId);
+	const bool IsGateway(const sockaddr_in& address) const;
+	void SendToClient(const sockaddr_in& to, Packet& packet);
+	void DisconnectClient(const sockaddr_in& address);
 	void InitializeMessageHandlers() override;
 
 public:
 	ServerSocketManager(
 		EventHandler& eventHandler,
-		GameMap& gameMap,
-		ObjectManager& objectManager,
-		ServerComponentOrchestrator& componentOrchestrator,
 		ServerRepository& serverRepository,
-		CommonRepository& commonRepository);
+		CommonRepository& commonRepository,
+		const ZoneMap& zoneMap);
 
 	void Initialize();
+	void AddWorld(World& world);
+	void AddGateway(const sockaddr_in& address);
 	void HandleTimeout();
+	void UpdateZones();
 	void UpdateClients();
+	void PrintCompressionStats(const int ticks);
+	void PrintNetworkStats();
+	void SetClientBytesPerTick(const int bytesPerTick);
+	void SetSeededTokens(const bool seeded);
+	void SetTickEpoch(const double epoch);
+	void RecordSessionLatencies(Histogram& rtts, Histogram& jitters);
 	void SendPacket(const sockaddr_in& to, const OpCode opCode, const std::vector<std::string>& args = std::vector<std::string>{});
-	void SendPacketToAllClients(const OpCode opCode, const std::vector<std::string>& args = std::vector<std::string>{});
-};
+	void SendPacketToInterestedClients(PlayerComponentManager& playerComponentManager, const OpCode opCode, const std::vector<std::string>& args, const int entityId, const int otherEntityId = -1);
+};
\ No newline at end of file
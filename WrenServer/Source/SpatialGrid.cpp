@@ -0,0 +1,57 @@
+#include "stdafx.h"
+#include "SpatialGrid.h"
+
+SpatialGrid::SpatialGrid(const float cellSize)
+	: cellSize{ cellSize }
+{
+}
+
+const int SpatialGrid::GetCell(const float coordinate) const
+{
+	return static_cast<int>(std::floor(coordinate / cellSize));
+}
+
+const __int64 SpatialGrid::GetCellKey(const int x, const int z)
+{
+	return (static_cast<__int64>(x) << 32) | static_cast<unsigned int>(z);
+}
+
+// Empty cells are kept, along with their capacity, since the same cells fill up again next tick.
+void SpatialGrid::Clear()
+{
+	for (auto& pair : cells)
+		pair.second.clear();
+}
+
+void SpatialGrid::Insert(const int id, const XMFLOAT3& position)
+{
+	cells[GetCellKey(GetCell(position.x), GetCell(position.z))].push_back(Entry{ id, position });
+}
+
+// Appends the id of everything within radius of position.
+void SpatialGrid::Query(const XMFLOAT3& position, const float radius, std::vector<int>& ids) const
+{
+	const auto minX = GetCell(position.x - radius);
+	const auto maxX = GetCell(position.x + radius);
+	const auto minZ = GetCell(position.z - radius);
+	const auto maxZ = GetCell(position.z + radius);
+	const auto radiusSquared = radius * radius;
+
+	for (auto x = minX; x <= maxX; x++)
+	{
+		for (auto z = minZ; z <= maxZ; z++)
+		{
+			const auto cell = cells.find(GetCellKey(x, z));
+			if (cell == cells.end())
+				continue;
+
+			for (const auto& entry : cell->second)
+			{
+				const auto dx = entry.position.x - position.x;
+				const auto dz = entry.position.z - position.z;
+				if (dx * dx + dz * dz <= radiusSquared)
+					ids.push_back(entry.id);
+			}
+		}
+	}
+}
\ No newline at end of file
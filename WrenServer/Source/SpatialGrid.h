@@ -0,0 +1,28 @@
+#pragma once
+
+#include <Constants.h>
+
+constexpr auto SPATIAL_GRID_CELL_SIZE = TILE_SIZE * 10.0f;
+
+// Entities bucketed into square cells on the x/z plane, so finding everything within a radius of a point
+// only visits the cells the radius overlaps. It's rebuilt from scratch every tick rather than kept up
+// to date as things move.
+class SpatialGrid
+{
+	struct Entry
+	{
+		int id;
+		XMFLOAT3 position;
+	};
+
+	float cellSize;
+	std::unordered_map<__int64, std::vector<Entry>> cells;
+
+	const int GetCell(const float coordinate) const;
+	static const __int64 GetCellKey(const int x, const int z);
+public:
+	SpatialGrid(const float cellSize = SPATIAL_GRID_CELL_SIZE);
+	void Clear();
+	void Insert(const int id, const XMFLOAT3& position);
+	void Query(const XMFLOAT3& position, const float radius, std::vector<int>& ids) const;
+};
\ No newline at end of file
@@ -0,0 +1,99 @@
+#include "stdafx.h"
+#include "ThreadPool.h"
+
+ThreadPool::ThreadPool(const int threadCount)
+{
+	for (auto i = 0; i < threadCount; i++)
+		workers.emplace_back(&ThreadPool::WorkerLoop, this);
+}
+
+ThreadPool::~ThreadPool()
+{
+	{
+		std::lock_guard<std::mutex> lock{ mutex };
+		stopping = true;
+	}
+	workReady.notify_all();
+
+	for (auto& worker : workers)
+		worker.join();
+}
+
+// Calls job(0) to job(count - 1) and returns once they've all finished. If a job throws, the rest still
+// run and the first exception is rethrown here, on the calling thread.
+void ThreadPool::Run(const int count, const std::function<void(const int)>& job)
+{
+	if (workers.empty() || count <= 1)
+	{
+		for (auto i = 0; i < count; i++)
+			job(i);
+		return;
+	}
+
+	{
+		// a worker that only just woke up for the previous Run may still be on its way out of RunJobs
+		std::unique_lock<std::mutex> lock{ mutex };
+		workDone.wait(lock, [this]() { return busyWorkers == 0; });
+		this->job = &job;
+		jobCount = count;
+		nextJob = 0;
+		jobsRemaining = count;
+		error = nullptr;
+		generation++;
+	}
+	workReady.notify_all();
+
+	RunJobs();
+
+	std::unique_lock<std::mutex> lock{ mutex };
+	workDone.wait(lock, [this]() { return jobsRemaining == 0; });
+	this->job = nullptr;
+	if (error)
+		std::rethrow_exception(error);
+}
+
+const int ThreadPool::GetThreadCount() const { return static_cast<int>(workers.size()); }
+
+void ThreadPool::WorkerLoop()
+{
+	unsigned __int64 lastGeneration{ 0 };
+	while (true)
+	{
+		{
+			std::unique_lock<std::mutex> lock{ mutex };
+			workReady.wait(lock, [this, &lastGeneration]() { return stopping || generation != lastGeneration; });
+			if (stopping)
+				return;
+			lastGeneration = generation;
+			busyWorkers++;
+		}
+
+		RunJobs();
+
+		std::lock_guard<std::mutex> lock{ mutex };
+		if (--busyWorkers == 0)
+			workDone.notify_all();
+	}
+}
+
+// A worker that wakes up late finds every index taken and goes straight back to sleep.
+void ThreadPool::RunJobs()
+{
+	for (auto i = nextJob++; i < jobCount; i = nextJob++)
+	{
+		try
+		{
+			(*job)(i);
+		}
+		catch (...)
+		{
+			std::lock_guard<std::mutex> lock{ mutex };
+			if (!error)
+				error = std::current_exception();
+		}
+
+		std::lock_guard<std::mutex> lock{ mutex };
+		if (--jobsRemaining == 0)
+			workDone.notify_all();
+	}
+}
\ No newline at end of file
@@ -0,0 +1,28 @@
+#pragma once
+
+// A fixed set of worker threads for running independent jobs side by side, e.g. one World's tick each.
+// Run hands job indices out until they've all been taken and blocks until every job has finished. The
+// calling thread works through jobs too, so a pool with no workers just runs them in order.
+class ThreadPool
+{
+	std::vector<std::thread> workers;
+	std::mutex mutex;
+	std::condition_variable workReady;
+	std::condition_variable workDone;
+	const std::function<void(const int)>* job{ nullptr };
+	int jobCount{ 0 };
+	std::atomic<int> nextJob{ 0 };
+	int jobsRemaining{ 0 };
+	int busyWorkers{ 0 };
+	unsigned __int64 generation{ 0 };
+	std::exception_ptr error;
+	bool stopping{ false };
+
+	void WorkerLoop();
+	void RunJobs();
+public:
+	ThreadPool(const int threadCount);
+	~ThreadPool();
+	void Run(const int count, const std::function<void(const int)>& job);
+	const int GetThreadCount() const;
+};
\ No newline at end of file
@@ -0,0 +1,178 @@
+#include "stdafx.h"
+#include "World.h"
+
+World::World(const int id, ServerSocketManager& socketManager)
+	: id{ id },
+	  profiler{ UPDATE_FREQUENCY, id },
+	  aiComponentManagerPhase{ profiler.AddPhase("AIComponentManager") },
+	  playerComponentManagerPhase{ profiler.AddPhase("PlayerComponentManager") },
+	  skillComponentManagerPhase{ profiler.AddPhase("SkillComponentManager") },
+	  objectManagerPhase{ profiler.AddPhase("ObjectManager") },
+	  playerGridPhase{ profiler.AddPhase("PlayerGrid") },
+	  publishEventsPhase{ profiler.AddPhase("PublishEvents") },
+	  aiComponentManager{ eventHandler, objectManager, gameMap, componentOrchestrator, socketManager },
+	  playerComponentManager{ eventHandler, objectManager, gameMap, componentOrchestrator, socketManager },
+	  skillComponentManager{ eventHandler, objectManager, componentOrchestrator, socketManager },
+	  statsComponentManager{ eventHandler, objectManager },
+	  inventoryComponentManager{ eventHandler, objectManager }
+{
+	componentOrchestrator.InitializeComponentManagers(&aiComponentManager, &playerComponentManager, &skillComponentManager, &statsComponentManager, &inventoryComponentManager);
+}
+
+// Places the static objects and npcs every World starts with. Static objects are placed across the whole
+// map, so movement near a zone border is blocked the same way on both sides, but npcs only in this zone.
+void World::Initialize(CommonRepository& commonRepository, const ZoneMap& zoneMap)
+{
+	// initialize StaticObjects
+	auto staticObjects = commonRepository.ListStaticObjects();
+	for (auto i = 0; i < staticObjects.size(); i++)
+	{
+		const StaticObject* staticObject = staticObjects.at(i).get();
+		const auto pos = staticObject->GetPosition();
+		const GameObject& gameObject = objectManager.CreateGameObject(pos, XMFLOAT3{ 14.0f, 14.0f, 14.0f }, 0.0f, GameObjectType::StaticObject, staticObject->GetName(), staticObject->GetId(), true);
+		gameMap.SetTileOccupied(gameObject.localPosition, true);
+	}
+
+	// initialize test dummy
+	// we need to move ListNpcs to CommonRepository
+	const XMFLOAT3 dummyPosition{ 30.0f, 0.0f, 30.0f };
+	if (zoneMap.IsLocal(dummyPosition))
+	{
+		const std::string dummyName{ "Dummy1" };
+		GameObject& dummyGameObject = objectManager.CreateGameObject(dummyPosition, XMFLOAT3{ 14.0f, 14.0f, 14.0f }, 30.0f, GameObjectType::Npc, dummyName, 101, false, 2, 4);
+		const auto dummyId = dummyGameObject.GetId();
+
+		const AIComponent& dummyAIComponent = aiComponentManager.CreateAIComponent(dummyId);
+		dummyGameObject.aiComponentId = dummyAIComponent.GetId();
+
+		const StatsComponent& dummyStatsComponent = statsComponentManager.CreateStatsComponent(dummyId, 10, 10, 10, 10, 10, 10, 10, 100, 100, 100, 100, 100, 100);
+		dummyGameObject.statsComponentId = dummyStatsComponent.GetId();
+
+		InventoryComponent& dummyInventoryComponent = inventoryComponentManager.CreateInventoryComponent(dummyId);
+		dummyGameObject.inventoryComponentId = dummyInventoryComponent.GetId();
+		dummyInventoryComponent.AddItem(1);
+		dummyInventoryComponent.AddItem(2);
+		gameMap.SetTileOccupied(dummyGameObject.localPosition, true);
+	}
+
+	const XMFLOAT3 dummyPosition2{ 90.0f, 0.0f, 60.0f };
+	if (zoneMap.IsLocal(dummyPosition2))
+	{
+		const std::string dummyName2{ "Dummy2" };
+		GameObject& dummyGameObject2 = objectManager.CreateGameObject(dummyPosition2, XMFLOAT3{ 14.0f, 14.0f, 14.0f }, 30.0f, GameObjectType::Npc, dummyName2, 102, false, 2, 4);
+		const auto dummyId2 = dummyGameObject2.GetId();
+
+		const AIComponent& dummyAIComponent2 = aiComponentManager.CreateAIComponent(dummyId2);
+		dummyGameObject2.aiComponentId = dummyAIComponent2.GetId();
+
+		const StatsComponent& dummyStatsComponent2 = statsComponentManager.CreateStatsComponent(dummyId2, 10, 10, 10, 10, 10, 10, 10, 100, 100, 100, 100, 100, 100);
+		dummyGameObject2.statsComponentId = dummyStatsComponent2.GetId();
+
+		InventoryComponent& dummyInventoryComponent2 = inventoryComponentManager.CreateInventoryComponent(dummyId2);
+		dummyGameObject2.inventoryComponentId = dummyInventoryComponent2.GetId();
+		dummyInventoryComponent2.AddItem(2);
+		dummyInventoryComponent2.AddItem(3);
+		gameMap.SetTileOccupied(dummyGameObject2.localPosition, true);
+	}
+}
+
+// One fixed update of the simulation. Runs on a ThreadPool worker, so it only records to its own
+// TickProfiler; the tick and its systems show up in the trace on the worker's track, tagged with the World id.
+void World::Tick()
+{
+	profiler.BeginTick();
+	{
+		ProfilerScope scope{ profiler, aiComponentManagerPhase };
+		aiComponentManager.Update();
+	}
+	{
+		ProfilerScope scope{ profiler, playerComponentManagerPhase };
+		playerComponentManager.Update();
+	}
+	{
+		ProfilerScope scope{ profiler, skillComponentManagerPhase };
+		skillComponentManager.Update();
+	}
+	{
+		ProfilerScope scope{ profiler, objectManagerPhase };
+		objectManager.Update();
+	}
+	{
+		ProfilerScope scope{ profiler, playerGridPhase };
+		UpdatePlayerGrid();
+	}
+	{
+		ProfilerScope scope{ profiler, publishEventsPhase };
+		PublishEvents();
+	}
+	profiler.EndTick();
+}
+
+void World::PublishEvents()
+{
+	std::queue<std::unique_ptr<const Event>>& eventQueue = eventHandler.GetEventQueue();
+	std::list<Observer*>& observers = eventHandler.GetObservers();
+	while (!eventQueue.empty())
+	{
+		auto event = std::move(eventQueue.front());
+		eventQueue.pop();
+
+		TraceZone zone{ "PublishEvent", static_cast<int>(event->type) };
+		for (auto it = observers.begin(); it != observers.end(); it++)
+		{
+			if ((*it)->HandleEvent(event.get()))
+				break;
+		}
+	}
+}
+
+const int World::GetId() const { return id; }
+
+// Before PublishEvents, so anything an event sends can look up who's nearby.
+void World::UpdatePlayerGrid()
+{
+	const auto* const playerComponents = playerComponentManager.GetPlayerComponents();
+	const auto playerComponentIndex = playerComponentManager.GetPlayerComponentIndex();
+
+	playerGrid.Clear();
+	for (auto i = 0; i < playerComponentIndex; i++)
+	{
+		// players still at character select aren't anywhere yet
+		if (playerComponents[i].characterId == 0)
+			continue;
+
+		const auto gameObjectId = playerComponents[i].GetGameObjectId();
+		playerGrid.Insert(gameObjectId, objectManager.GetGameObjectById(gameObjectId).localPosition);
+	}
+}
+
+const int World::GetPlayerCount() { return playerComponentManager.GetPlayerComponentIndex(); }
+
+EventHandler& World::GetEventHandler() { return eventHandler; }
+
+ObjectManager& World::GetObjectManager() { return objectManager; }
+
+GameMap& World::GetGameMap() { return gameMap; }
+
+ServerComponentOrchestrator& World::GetComponentOrchestrator() { return componentOrchestrator; }
+
+AIComponentManager& World::GetAIComponentManager() { return aiComponentManager; }
+
+PlayerComponentManager& World::GetPlayerComponentManager() { return playerComponentManager; }
+
+SkillComponentManager& World::GetSkillComponentManager() { return skillComponentManager; }
+
+StatsComponentManager& World::GetStatsComponentManager() { return statsComponentManager; }
+
+InventoryComponentManager& World::GetInventoryComponentManager() { return inventoryComponentManager; }
+
+ReplicationScheduler& World::GetReplicationScheduler() { return replicationScheduler; }
+
+std::unordered_map<int, ZoneGhost>& World::GetGhosts() { return ghosts; }
+
+const SpatialGrid& World::GetPlayerGrid() const { return playerGrid; }
+
+std::vector<InterestEvent>& World::GetInterestEvents() { return interestEvents; }
+
+// The histograms only cover the ticks since the last stats report, when the main loop resets them.
+TickProfiler& World::GetProfiler() { return profiler; }
\ No newline at end of file
@@ -0,0 +1,91 @@
+#pragma once
+
+#include <EventHandling/EventHandler.h>
+#include <ObjectManager.h>
+#include <GameMap/GameMap.h>
+#include <CommonRepository.h>
+#include <Profiling/TickProfiler.h>
+#include <Components/StatsComponentManager.h>
+#include <Components/InventoryComponentManager.h>
+#include "Components/ServerComponentOrchestrator.h"
+#include "Components/AIComponentManager.h"
+#include "Components/PlayerComponentManager.h"
+#include "Components/SkillComponentManager.h"
+#include "ReplicationScheduler.h"
+#include "SpatialGrid.h"
+#include "Zones/ZoneMap.h"
+#include <Networking/EntityState.h>
+
+class ServerSocketManager;
+
+constexpr auto INTEREST_RADIUS = TILE_SIZE * 30.0f; // players this close to an entity hear about its combat and loot
+
+// An entity owned by a neighbouring zone's server that's close enough to the border to be shown to this
+// World's clients. Ghosts are only replicated, never simulated, and expire when their updates stop.
+struct ZoneGhost
+{
+	EntityState state;
+	bool isPlayer;
+	double lastUpdateTime;
+};
+
+// A combat or loot message for the clients near the entities involved (-1 for none). Queued while the
+// World ticks, and sent with the World's replication once the player grid has caught up with the tick.
+struct InterestEvent
+{
+	OpCode opCode;
+	std::vector<std::string> args;
+	int entityIds[2];
+};
+
+// One independent simulation with its own map, game objects, components, events and random engine, e.g.
+// a dungeon instance or a test shard. A server process hosts any number of them and ticks them side by
+// side on a ThreadPool: a tick only touches its own World, apart from queueing packets on the
+// ServerSocketManager, which locks around sends.
+class World
+{
+	const int id;
+	EventHandler eventHandler;
+	ObjectManager objectManager;
+	GameMap gameMap;
+	ServerComponentOrchestrator componentOrchestrator;
+	AIComponentManager aiComponentManager;
+	PlayerComponentManager playerComponentManager;
+	SkillComponentManager skillComponentManager;
+	StatsComponentManager statsComponentManager;
+	InventoryComponentManager inventoryComponentManager;
+	ReplicationScheduler replicationScheduler;
+	std::unordered_map<int, ZoneGhost> ghosts;
+	SpatialGrid playerGrid; // every player's GameObject id by position, as of the last tick
+	std::vector<InterestEvent> interestEvents;
+	TickProfiler profiler;
+	const int aiComponentManagerPhase;
+	const int playerComponentManagerPhase;
+	const int skillComponentManagerPhase;
+	const int objectManagerPhase;
+	const int playerGridPhase;
+	const int publishEventsPhase;
+
+	void UpdatePlayerGrid();
+	void PublishEvents();
+public:
+	World(const int id, ServerSocketManager& socketManager);
+	void Initialize(CommonRepository& commonRepository, const ZoneMap& zoneMap);
+	void Tick();
+	const int GetId() const;
+	const int GetPlayerCount();
+	EventHandler& GetEventHandler();
+	ObjectManager& GetObjectManager();
+	GameMap& GetGameMap();
+	ServerComponentOrchestrator& GetComponentOrchestrator();
+	AIComponentManager& GetAIComponentManager();
+	PlayerComponentManager& GetPlayerComponentManager();
+	SkillComponentManager& GetSkillComponentManager();
+	StatsComponentManager& GetStatsComponentManager();
+	InventoryComponentManager& GetInventoryComponentManager();
+	ReplicationScheduler& GetReplicationScheduler();
+	std::unordered_map<int, ZoneGhost>& GetGhosts();
+	const SpatialGrid& GetPlayerGrid() const;
+	std::vector<InterestEvent>& GetInterestEvents();
+	TickProfiler& GetProfiler();
+};
\ No newline at end of file
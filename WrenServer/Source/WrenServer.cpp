@@ -1,80 +1,518 @@
 
 #include "stdafx.h"
 #include <GameTimer.h>
-#include <Components/StatsComponentManager.h>
-#include "Components/AIComponentManager.h"
-#include "Components/PlayerComponentManager.h"
-#include "Components/SkillComponentManager.h"
-#include "Components/InventoryComponentManager.h"
+#include <Profiling/TickProfiler.h>
+#include "World.h"
+#include "ThreadPool.h"
+#include "Metrics/MetricsServer.h"
+#include "Metrics/MetricsWriter.h"
 
-void PublishEvents(EventHandler& eventHandler)
+constexpr auto STATS_REPORT_TICKS = 60 * 60; // once a minute
+constexpr auto PROFILE_REPORT_PATH = "WrenServer.profile.jsonl";
+constexpr auto SLOW_TICK_THRESHOLD = UPDATE_FREQUENCY * 2.0;
+constexpr auto SLOW_TICK_TRACE_COOLDOWN = 10.0f; // seconds, so a string of slow ticks doesn't write a trace per tick
+constexpr auto MAX_CATCH_UP_TICKS = 4;            // ticks run back to back before packets are processed again
+constexpr auto MAX_TICK_BACKLOG = 0.25;           // seconds behind schedule before the backlog is skipped
+constexpr auto DEFAULT_SIMULATED_NETWORK = "latency=50,jitter=10,loss=1"; // what S switches on without --netsim
+
+// Writes the trace buffers out to a new file named after the current time.
+void ExportTrace(const char* reason)
+{
+	const auto path = std::string{ "WrenServer." } + reason + "." + std::to_string(std::time(nullptr)) + ".trace.json";
+	if (Trace::Export(path))
+		std::cout << "Trace written to " << path << "\n";
+}
+
+// e.g. WrenServer.exe --capture session.wcap, then WrenServer.exe --replay session.wcap --replay-output build1.wcap
+// --netsim starts with every client behind a simulated link, e.g. --netsim latency=80,jitter=20,loss=2
+// --worlds hosts several independent Worlds, ticked side by side on --world-threads extra threads
+// --zones splits the map between several processes, and --zone says which strip this one owns
+// --gateways lists the WrenGateway processes allowed to log clients in and relay their messages
+// --rate-limits sets each client's messages per second and burst by class, e.g. --rate-limits chat=2:5,ping=4:8
+struct ServerOptions
 {
-	std::queue<std::unique_ptr<const Event>>& eventQueue = eventHandler.GetEventQueue();
-	std::list<Observer*>& observers = eventHandler.GetObservers();
-	while (!eventQueue.empty())
+	std::string capturePath;      // record every inbound datagram while running normally
+	std::string replayPath;       // feed a recording through the simulation as fast as possible, then exit
+	std::string replayOutputPath{ "WrenServer.replay.wcap" }; // where a replay writes the datagrams it would have sent
+	unsigned int seed{ std::random_device{}() };
+	bool simulateNetwork{ false };
+	NetworkConditions networkConditions{ ParseNetworkConditions(DEFAULT_SIMULATED_NETWORK) };
+	int worlds{ 1 };
+	int worldThreads{ -1 };       // besides the main thread, -1 picks one per core up to one per World
+	std::string zones;            // every zone server's ip:port, west to east
+	int zone{ 0 };
+	std::string gateways;         // every gateway's ip:port
+	RateLimits rateLimits{ ParseRateLimits(DEFAULT_RATE_LIMITS) };
+};
+
+ServerOptions ParseOptions(const int argc, char* argv[])
+{
+	ServerOptions options;
+	for (auto i = 1; i + 1 < argc; i += 2)
 	{
-		auto event = std::move(eventQueue.front());
-		eventQueue.pop();
+		const std::string option{ argv[i] };
+		const std::string value{ argv[i + 1] };
 
-		for (auto it = observers.begin(); it != observers.end(); it++)
+		if (option == "--capture")
+			options.capturePath = value;
+		else if (option == "--replay")
+			options.replayPath = value;
+		else if (option == "--replay-output")
+			options.replayOutputPath = value;
+		else if (option == "--seed")
+			options.seed = std::stoul(value);
+		else if (option == "--netsim")
 		{
-			if ((*it)->HandleEvent(event.get()))
-				break;
+			options.simulateNetwork = true;
+			options.networkConditions = ParseNetworkConditions(value);
 		}
+		else if (option == "--worlds")
+			options.worlds = std::stoi(value);
+		else if (option == "--world-threads")
+			options.worldThreads = std::stoi(value);
+		else if (option == "--zones")
+			options.zones = value;
+		else if (option == "--zone")
+			options.zone = std::stoi(value);
+		else if (option == "--gateways")
+			options.gateways = value;
+		else if (option == "--rate-limits")
+			options.rateLimits = ParseRateLimits(value);
+		else
+			throw std::exception("Unknown option.");
+	}
+	if (options.worlds < 1)
+		throw std::exception("--worlds must be at least 1.");
+	return options;
+}
+
+constexpr const char* GAME_OBJECT_TYPE_NAMES[]{ "Uninitialized", "Npc", "Player", "StaticObject" };
+
+struct ComponentPoolStats
+{
+	const char* name;
+	std::string world;
+	int used;
+	int capacity;
+};
+
+template <class T, int maxComponents>
+const ComponentPoolStats GetComponentPoolStats(const char* name, const World& world, const ComponentManager<T, maxComponents>& componentManager)
+{
+	return ComponentPoolStats{ name, std::to_string(world.GetId()), componentManager.GetComponentCount(), componentManager.GetMaxComponents() };
+}
+
+void WriteWorldStats(MetricsWriter& writer, const std::vector<std::unique_ptr<World>>& worlds)
+{
+	writer.Family("wren_players", "gauge", "Logged in players per World.");
+	for (const auto& world : worlds)
+		writer.Sample("wren_players", world->GetPlayerCount(), MetricsWriter::Label("world", std::to_string(world->GetId())));
+
+	writer.Family("wren_entities", "gauge", "Game objects by World and type.");
+	for (const auto& world : worlds)
+	{
+		int entityCounts[std::size(GAME_OBJECT_TYPE_NAMES)]{};
+		ObjectManager& objectManager = world->GetObjectManager();
+		const auto* const gameObjects = objectManager.GetGameObjects();
+		for (auto i = 0; i < objectManager.GetGameObjectIndex(); i++)
+			entityCounts[static_cast<int>(gameObjects[i].GetType())]++;
+
+		const auto worldLabel = MetricsWriter::Label("world", std::to_string(world->GetId()));
+		for (auto i = 0; i < std::size(GAME_OBJECT_TYPE_NAMES); i++)
+			writer.Sample("wren_entities", entityCounts[i], worldLabel + "," + MetricsWriter::Label("type", GAME_OBJECT_TYPE_NAMES[i]));
+	}
+
+	std::vector<ComponentPoolStats> componentPools;
+	for (const auto& world : worlds)
+	{
+		componentPools.push_back(GetComponentPoolStats("AI", *world, world->GetAIComponentManager()));
+		componentPools.push_back(GetComponentPoolStats("Player", *world, world->GetPlayerComponentManager()));
+		componentPools.push_back(GetComponentPoolStats("Skill", *world, world->GetSkillComponentManager()));
+		componentPools.push_back(GetComponentPoolStats("Stats", *world, world->GetStatsComponentManager()));
+		componentPools.push_back(GetComponentPoolStats("Inventory", *world, world->GetInventoryComponentManager()));
+	}
+	writer.Family("wren_component_pool_used", "gauge", "Components in use per World and component manager.");
+	for (const auto& pool : componentPools)
+		writer.Sample("wren_component_pool_used", pool.used, MetricsWriter::Label("world", pool.world) + "," + MetricsWriter::Label("pool", pool.name));
+	writer.Family("wren_component_pool_capacity", "gauge", "maxComponents per World and component manager.");
+	for (const auto& pool : componentPools)
+		writer.Sample("wren_component_pool_capacity", pool.capacity, MetricsWriter::Label("world", pool.world) + "," + MetricsWriter::Label("pool", pool.name));
+
+	writer.Family("wren_world_tick_duration_seconds", "summary", "World simulation time per tick over the current stats report interval.");
+	for (const auto& world : worlds)
+		writer.Summary("wren_world_tick_duration_seconds", world->GetProfiler().GetTickHistogram(), MetricsWriter::Label("world", std::to_string(world->GetId())));
+
+	writer.Family("wren_world_phase_duration_seconds", "summary", "World system durations per tick over the current stats report interval.");
+	for (const auto& world : worlds)
+	{
+		const TickProfiler& profiler = world->GetProfiler();
+		const auto worldLabel = MetricsWriter::Label("world", std::to_string(world->GetId()));
+		for (auto i = 0; i < profiler.GetPhaseCount(); i++)
+			writer.Summary("wren_world_phase_duration_seconds", profiler.GetPhaseHistogram(i), worldLabel + "," + MetricsWriter::Label("phase", profiler.GetPhaseName(i)));
+	}
+
+	writer.Family("wren_world_tick_overruns_total", "counter", "World ticks that took longer than UPDATE_FREQUENCY on their own.");
+	for (const auto& world : worlds)
+		writer.Sample("wren_world_tick_overruns_total", static_cast<double>(world->GetProfiler().GetTotalOverruns()), MetricsWriter::Label("world", std::to_string(world->GetId())));
+}
+
+void WriteQueryLatencies(MetricsWriter& writer, const Repository& repository)
+{
+	for (const auto& pair : repository.GetQueryLatencies())
+		writer.Summary("wren_sqlite_query_duration_seconds", pair.second, MetricsWriter::Label("query", pair.first));
+}
+
+void WriteNetworkStats(MetricsWriter& writer, const ServerSocketManager& socketManager)
+{
+	const auto stats = socketManager.GetNetworkTotals();
+
+	writer.Family("wren_connections", "gauge", "Endpoints the server holds transport state for.");
+	writer.Sample("wren_connections", socketManager.GetConnectionCount());
+
+	writer.Family("wren_network_messages_total", "counter", "Messages by OpCode and direction.");
+	for (const auto& pair : stats.opCodes)
+	{
+		const auto opCode = MetricsWriter::Label("opcode", GetOpCodeName(pair.first));
+		writer.Sample("wren_network_messages_total", pair.second.sent.messages, opCode + ",direction=\"sent\"");
+		writer.Sample("wren_network_messages_total", pair.second.received.messages, opCode + ",direction=\"received\"");
+	}
+
+	writer.Family("wren_network_bytes_total", "counter", "Message payload bytes on the wire by OpCode and direction.");
+	for (const auto& pair : stats.opCodes)
+	{
+		const auto opCode = MetricsWriter::Label("opcode", GetOpCodeName(pair.first));
+		writer.Sample("wren_network_bytes_total", static_cast<double>(pair.second.sent.bytes), opCode + ",direction=\"sent\"");
+		writer.Sample("wren_network_bytes_total", static_cast<double>(pair.second.received.bytes), opCode + ",direction=\"received\"");
+	}
+
+	writer.Family("wren_network_handler_seconds_total", "counter", "Time spent in message handlers by OpCode.");
+	for (const auto& pair : stats.opCodes)
+		writer.Sample("wren_network_handler_seconds_total", pair.second.handlerTime, MetricsWriter::Label("opcode", GetOpCodeName(pair.first)));
+
+	writer.Family("wren_network_decode_failures_total", "counter", "Bit-packed messages that were shorter than their handler expected.");
+	for (const auto& pair : stats.opCodes)
+		writer.Sample("wren_network_decode_failures_total", pair.second.decodeFailures, MetricsWriter::Label("opcode", GetOpCodeName(pair.first)));
+
+	writer.Family("wren_network_rate_limited_total", "counter", "Messages dropped because their sender was over its rate limit, by OpCode.");
+	for (const auto& pair : stats.opCodes)
+		writer.Sample("wren_network_rate_limited_total", pair.second.rateLimited, MetricsWriter::Label("opcode", GetOpCodeName(pair.first)));
+
+	writer.Family("wren_network_rejects_total", "counter", "Datagrams and messages dropped before reaching a handler.");
+	writer.Sample("wren_network_rejects_total", stats.checksumRejects, "reason=\"checksum\"");
+	writer.Sample("wren_network_rejects_total", stats.malformedDatagrams, "reason=\"malformed\"");
+	writer.Sample("wren_network_rejects_total", stats.decompressionFailures, "reason=\"decompression\"");
+	writer.Sample("wren_network_rejects_total", stats.unknownOpCodes, "reason=\"unknown_opcode\"");
+	writer.Sample("wren_network_rejects_total", stats.handshakeRejects, "reason=\"handshake\"");
+
+	writer.Family("wren_connection_timeouts_total", "counter", "Connections dropped after a reliable message or handshake went unanswered for too long.");
+	writer.Sample("wren_connection_timeouts_total", stats.connectionTimeouts);
+}
+
+void WriteSessionLatencies(MetricsWriter& writer, ServerSocketManager& socketManager)
+{
+	Histogram rtts;
+	Histogram jitters;
+	socketManager.RecordSessionLatencies(rtts, jitters);
+
+	writer.Family("wren_session_rtt_seconds", "summary", "Round trip time each logged in client last reported from its clock sync.");
+	writer.Summary("wren_session_rtt_seconds", rtts);
+	writer.Family("wren_session_jitter_seconds", "summary", "Round trip jitter each logged in client last reported from its clock sync.");
+	writer.Summary("wren_session_jitter_seconds", jitters);
+}
+
+void WriteTickStats(MetricsWriter& writer, const TickProfiler& profiler)
+{
+	writer.Family("wren_tick_duration_seconds", "summary", "Fixed update duration over the current stats report interval.");
+	writer.Summary("wren_tick_duration_seconds", profiler.GetTickHistogram());
+
+	writer.Family("wren_phase_duration_seconds", "summary", "Main loop phase durations over the current stats report interval.");
+	for (auto i = 0; i < profiler.GetPhaseCount(); i++)
+		writer.Summary("wren_phase_duration_seconds", profiler.GetPhaseHistogram(i), MetricsWriter::Label("phase", profiler.GetPhaseName(i)));
+
+	writer.Family("wren_ticks_total", "counter", "Fixed updates since startup.");
+	writer.Sample("wren_ticks_total", static_cast<double>(profiler.GetTotalTicks()));
+	writer.Family("wren_tick_overruns_total", "counter", "Fixed updates that took longer than UPDATE_FREQUENCY.");
+	writer.Sample("wren_tick_overruns_total", static_cast<double>(profiler.GetTotalOverruns()));
+	writer.Family("wren_ticks_skipped_total", "counter", "Fixed updates dropped after the main loop fell more than MAX_TICK_BACKLOG behind.");
+	writer.Sample("wren_ticks_skipped_total", static_cast<double>(profiler.GetTotalSkippedTicks()));
+}
+
+// Prints each World's tick and systems under the main loop's report, appends them to the same file, and resets them.
+void ReportWorldProfiles(const std::vector<std::unique_ptr<World>>& worlds)
+{
+	for (const auto& world : worlds)
+	{
+		TickProfiler& profiler = world->GetProfiler();
+		std::cout << "World " << world->GetId() << ", " << world->GetPlayerCount() << " players. ";
+		profiler.Report(std::cout);
+		profiler.WriteReport(PROFILE_REPORT_PATH, "world " + std::to_string(world->GetId()));
+		profiler.Reset();
 	}
 }
 
-int main()
+int main(int argc, char* argv[])
 {
+	ServerOptions options;
+	ZoneMap zoneMap;
+	std::vector<sockaddr_in> gateways;
+	std::unique_ptr<PacketCaptureReader> replay;
+	try
+	{
+		options = ParseOptions(argc, argv);
+		if (!options.zones.empty())
+			zoneMap = ZoneMap{ options.zones, options.zone };
+		gateways = SocketManager::ParseAddresses(options.gateways);
+		if (!options.replayPath.empty())
+		{
+			replay = std::make_unique<PacketCaptureReader>(options.replayPath);
+			options.seed = replay->GetSeed();
+		}
+	}
+	catch (const std::exception& e)
+	{
+		std::cout << e.what() << "\n";
+		return 1;
+	}
+
 	static EventHandler eventHandler;
-	static ObjectManager objectManager;
-	static GameMap gameMap;
-	static ServerComponentOrchestrator componentOrchestrator;
 	static ServerRepository serverRepository{ "..\\..\\Databases\\WrenServer.db" };
 	static CommonRepository commonRepository{ "..\\..\\Databases\\WrenCommon.db " };
-	static ServerSocketManager socketManager{ eventHandler, gameMap, objectManager, componentOrchestrator, serverRepository, commonRepository };
-	static AIComponentManager aiComponentManager{ eventHandler, objectManager, gameMap, componentOrchestrator, socketManager };
-	static PlayerComponentManager playerComponentManager{ eventHandler, objectManager, gameMap, componentOrchestrator, socketManager };
-	static SkillComponentManager skillComponentManager{ eventHandler, objectManager, componentOrchestrator, socketManager };
-	static StatsComponentManager statsComponentManager{ eventHandler, objectManager };
-	static InventoryComponentManager inventoryComponentManager{ eventHandler, objectManager };
-	componentOrchestrator.InitializeComponentManagers(&aiComponentManager, &playerComponentManager, &skillComponentManager, &statsComponentManager, &inventoryComponentManager);
+	static ServerSocketManager socketManager{ eventHandler, serverRepository, commonRepository, zoneMap };
+
+	// every World holds its own fixed size component pools, which are far too big for the stack
+	std::vector<std::unique_ptr<World>> worlds;
+	for (auto i = 0; i < options.worlds; i++)
+	{
+		worlds.push_back(std::make_unique<World>(i, socketManager));
+		socketManager.AddWorld(*worlds.back());
+	}
+
+	// a recording only replays the same way if every random roll and login token comes out the same
+	const auto deterministic = replay || !options.capturePath.empty();
+	if (deterministic)
+	{
+		for (auto i = 0; i < worlds.size(); i++)
+			worlds[i]->GetComponentOrchestrator().SeedRandom(options.seed + i);
+		socketManager.SeedRandom(options.seed);
+		socketManager.SetSeededTokens(true);
+	}
+
 	socketManager.Initialize();
+	socketManager.SetRateLimits(options.rateLimits);
+	for (const auto& gateway : gateways)
+		socketManager.AddGateway(gateway);
+	for (auto& world : worlds)
+		world->Initialize(commonRepository, zoneMap);
+
+	const auto cores = Utility::Max<int>(1, static_cast<int>(std::thread::hardware_concurrency()));
+	const auto worldThreads = options.worldThreads >= 0 ? options.worldThreads : Utility::Min<int>(options.worlds, cores) - 1;
+	ThreadPool worldThreadPool{ worldThreads };
+	const std::function<void(const int)> tickWorld = [&worlds](const int i) { worlds[i]->Tick(); };
 
     HWND consoleWindow = GetConsoleWindow();
     MoveWindow(consoleWindow, 810, 0, 800, 800, TRUE);
-    std::cout << "WrenServer initialized.\n\n";
+    std::cout << "WrenServer initialized with " << worlds.size() << (worlds.size() == 1 ? " World" : " Worlds") << " on " << worldThreadPool.GetThreadCount() + 1 << (worldThreadPool.GetThreadCount() == 0 ? " thread" : " threads") << ".\n";
+	if (zoneMap.GetZoneCount() > 1)
+		std::cout << "Zone " << options.zone << " of " << zoneMap.GetZoneCount() << ", x from " << Utility::Max<float>(zoneMap.GetLocalZone().minX, 0.0f) << " to " << Utility::Min<float>(zoneMap.GetLocalZone().maxX, ZONE_MAP_EXTENT) << ".\n";
+	std::cout << "\n";
+
+	// the ring buffers only ever hold the last few seconds, so tracing can stay on
+	Trace::SetEnabled(true);
+	std::cout << "Press T to write a trace of the last few seconds.\n";
+	std::cout << "Press N to print and reset the network stats.\n";
+	std::cout << "Press S to switch the network simulator on or off.\n\n";
+	auto lastSlowTickTrace = -static_cast<double>(SLOW_TICK_TRACE_COOLDOWN);
+
+	TickProfiler profiler;
+	const auto processPacketsPhase = profiler.AddPhase("ProcessPackets");
+	const auto updateWorldsPhase = profiler.AddPhase("UpdateWorlds");
+	const auto updateClientsPhase = profiler.AddPhase("UpdateClients");
+	const auto flushPacketsPhase = profiler.AddPhase("FlushPackets");
+	const auto publishMetricsPhase = profiler.AddPhase("PublishMetrics");
+	const auto waitForPacketsPhase = profiler.AddPhase("WaitForPackets");
+
+	// one fixed update; returns how long it took
+	const auto runTick = [&]()
+	{
+		profiler.BeginTick();
+		{
+			// each World's systems show up in the trace on whichever thread ticked it
+			ProfilerScope scope{ profiler, updateWorldsPhase };
+			worldThreadPool.Run(static_cast<int>(worlds.size()), tickWorld);
+		}
+		{
+			ProfilerScope scope{ profiler, updateClientsPhase };
+			socketManager.UpdateZones();
+			socketManager.UpdateClients();
+		}
+		return profiler.EndTick();
+	};
+
+	if (replay)
+	{
+		// datagrams go in at the tick they were recorded in and the transport sees tick time instead
+		// of wall time, so two builds replaying the same capture should send exactly the same bytes
+		auto tick = 0u;
+		socketManager.SetClock([&tick]() { return tick * static_cast<double>(UPDATE_FREQUENCY); });
+
+		PacketCaptureWriter output{ options.replayOutputPath, options.seed };
+		socketManager.SetOutboundCapture(&output);
+		// the recorded cookies were signed at wall clock times, so they'd never verify on tick time
+		socketManager.SetHandshakeRequired(false);
+
+		std::cout << "Replaying " << options.replayPath << " with seed " << options.seed << "\n";
+		const auto start = TickProfiler::GetTime();
+
+		CapturedDatagram datagram;
+		auto hasDatagram = replay->Read(datagram);
+		while (hasDatagram)
+		{
+			while (hasDatagram && datagram.tick <= tick)
+			{
+				socketManager.InjectDatagram(datagram.address, datagram.data.data(), static_cast<int>(datagram.data.size()));
+				hasDatagram = replay->Read(datagram);
+			}
+
+			output.SetTick(tick);
+			runTick();
+			socketManager.FlushPackets();
+			tick++;
+		}
+
+		const auto elapsed = TickProfiler::GetTime() - start;
+		std::cout << tick << " ticks in " << elapsed << "s, " << tick / Utility::Max<double>(elapsed, 0.000001) << " ticks/s\n"
+			<< output.GetDatagramCount() << " datagrams sent, digest " << std::hex << output.GetDigest() << std::dec << "\n";
+		profiler.Report(std::cout);
+		ReportWorldProfiles(worlds);
+
+		socketManager.CloseSockets();
+		return 0;
+	}
+
+	if (options.simulateNetwork)
+		socketManager.EnableNetworkSimulator(options.seed).SetConditions(options.networkConditions);
+
+	std::unique_ptr<PacketCaptureWriter> capture;
+	if (!options.capturePath.empty())
+	{
+		capture = std::make_unique<PacketCaptureWriter>(options.capturePath, options.seed);
+		socketManager.SetInboundCapture(capture.get());
+		std::cout << "Capturing to " << options.capturePath << " with seed " << options.seed << "\n\n";
+	}
 
-	GameTimer timer;
-	timer.Reset();
-	auto updateTimer = 0.0f;
+	static MetricsServer metricsServer;
+	std::cout << "Metrics at http://127.0.0.1:" << METRICS_PORT_NUMBER << "/metrics\n\n";
+	const auto publishMetrics = [&]()
+	{
+		MetricsWriter writer;
+		WriteTickStats(writer, profiler);
+		WriteWorldStats(writer, worlds);
+
+		writer.Family("wren_sqlite_query_duration_seconds", "summary", "SQLite query latency by repository method.");
+		WriteQueryLatencies(writer, serverRepository);
+		WriteQueryLatencies(writer, commonRepository);
+
+		WriteNetworkStats(writer, socketManager);
+		WriteSessionLatencies(writer, socketManager);
+
+		metricsServer.Publish(writer.GetText());
+	};
+	auto lastMetricsPublish = -static_cast<double>(METRICS_PUBLISH_INTERVAL);
+
+	// the loop sleeps in select between ticks, which by default only wakes on the 15.6ms scheduler tick
+	timeBeginPeriod(1);
+
+	auto ticksSinceStatsReport = 0;
+	auto nextTickTime = GameTimer::GetTime();
+	socketManager.SetTickEpoch(nextTickTime); // skipped ticks are skipped whole, so ticks stay in step with it
 	
     while (true)
     {
-		timer.Tick();
-
-		socketManager.ProcessPackets();
+		{
+			ProfilerScope scope{ profiler, processPacketsPhase };
+			socketManager.ProcessPackets();
+		}
 
 		// turn this off for debugging
 		//socketManager.HandleTimeout();
 
-		const auto deltaTime = timer.DeltaTime();
+		// after a stall, e.g. a debugger break or a slow query, drop the backlog rather than trying to run all of it
+		auto now = GameTimer::GetTime();
+		if (now - nextTickTime > MAX_TICK_BACKLOG)
+		{
+			const auto skippedTicks = static_cast<int>((now - nextTickTime) / UPDATE_FREQUENCY);
+			profiler.SkipTicks(skippedTicks);
+			nextTickTime += skippedTicks * static_cast<double>(UPDATE_FREQUENCY);
+		}
 
-		updateTimer += deltaTime;
-		if (updateTimer >= UPDATE_FREQUENCY)
+		// catch up a few ticks at a time, so packets still get read and sent while the loop is behind
+		for (auto caughtUpTicks = 0; now >= nextTickTime && caughtUpTicks < MAX_CATCH_UP_TICKS; caughtUpTicks++)
 		{
-			aiComponentManager.Update();
-			playerComponentManager.Update();
-			objectManager.Update();
-			
-			PublishEvents(eventHandler);
+			const auto tickDuration = runTick();
+			nextTickTime += UPDATE_FREQUENCY;
+			now = GameTimer::GetTime();
 
-			socketManager.UpdateClients();
+			if (capture)
+				capture->SetTick(static_cast<unsigned int>(profiler.GetTotalTicks()));
+			if (tickDuration > SLOW_TICK_THRESHOLD && now - lastSlowTickTrace > SLOW_TICK_TRACE_COOLDOWN)
+			{
+				std::cout << "Slow tick: " << tickDuration * 1000.0 << "ms\n";
+				ExportTrace("slowtick");
+				lastSlowTickTrace = now;
+			}
+
+			if (++ticksSinceStatsReport == STATS_REPORT_TICKS)
+			{
+				socketManager.PrintCompressionStats(ticksSinceStatsReport);
+				socketManager.PrintNetworkStats();
+				profiler.Report(std::cout);
+				profiler.WriteReport(PROFILE_REPORT_PATH);
+				profiler.Reset();
+				ReportWorldProfiles(worlds);
+				ticksSinceStatsReport = 0;
+			}
+
+			if (now - lastMetricsPublish >= METRICS_PUBLISH_INTERVAL)
+			{
+				ProfilerScope scope{ profiler, publishMetricsPhase };
+				publishMetrics();
+				lastMetricsPublish = now;
+			}
+		}
 
-			updateTimer -= UPDATE_FREQUENCY;
+		if (_kbhit())
+		{
+			const auto key = toupper(_getch());
+			if (key == 'T')
+				ExportTrace("manual");
+			else if (key == 'N')
+				socketManager.PrintNetworkStats();
+			else if (key == 'S' && socketManager.GetNetworkSimulator())
+			{
+				socketManager.DisableNetworkSimulator();
+				std::cout << "Network simulator off.\n";
+			}
+			else if (key == 'S')
+			{
+				socketManager.EnableNetworkSimulator(options.seed).SetConditions(options.networkConditions);
+				std::cout << "Network simulator on.\n";
+			}
+		}
+
+		// everything queued for a client this iteration goes out coalesced into as few datagrams as possible
+		{
+			ProfilerScope scope{ profiler, flushPacketsPhase };
+			socketManager.FlushPackets();
+		}
+
+		// sleep until a datagram arrives or the next tick is due, so an idle server costs next to nothing
+		{
+			ProfilerScope scope{ profiler, waitForPacketsPhase };
+			socketManager.WaitForPackets(nextTickTime - GameTimer::GetTime());
 		}
     }
     
+    metricsServer.Stop();
     socketManager.CloseSockets();    
 
     return 0;
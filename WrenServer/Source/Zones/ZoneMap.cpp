@@ -0,0 +1,67 @@
+#include "stdafx.h"
+#include "ZoneMap.h"
+#include <SocketManager.h>
+
+ZoneMap::ZoneMap()
+	: ZoneMap{ std::string{ SERVER_IP_ADDRESS } + ":" + std::to_string(SERVER_PORT_NUMBER), 0 }
+{
+}
+
+ZoneMap::ZoneMap(const std::string& addresses, const int localZone)
+	: localZone{ localZone }
+{
+	const auto zoneAddresses = SocketManager::ParseAddresses(addresses);
+	if (zoneAddresses.empty())
+		throw std::exception("--zones needs at least one address.");
+	if (localZone < 0 || localZone >= zoneAddresses.size())
+		throw std::exception("--zone must index into --zones.");
+
+	const auto width = ZONE_MAP_EXTENT / zoneAddresses.size();
+	for (auto i = 0; i < zoneAddresses.size(); i++)
+	{
+		// the outer edges are open, so nothing that strays off the map is ever without an owner
+		const auto minX = i == 0 ? std::numeric_limits<float>::lowest() : i * width;
+		const auto maxX = i == zoneAddresses.size() - 1 ? std::numeric_limits<float>::max() : (i + 1) * width;
+		zones.push_back(Zone{ i, minX, maxX, zoneAddresses[i] });
+	}
+}
+
+const int ZoneMap::GetZoneCount() const { return static_cast<int>(zones.size()); }
+
+const Zone& ZoneMap::GetZone(const int index) const { return zones.at(index); }
+
+const Zone& ZoneMap::GetLocalZone() const { return zones[localZone]; }
+
+const int ZoneMap::GetZoneIndex(const XMFLOAT3& position) const
+{
+	for (auto i = 0; i < zones.size(); i++)
+	{
+		if (position.x < zones[i].maxX)
+			return i;
+	}
+	return static_cast<int>(zones.size()) - 1;
+}
+
+const bool ZoneMap::IsLocal(const XMFLOAT3& position) const { return GetZoneIndex(position) == localZone; }
+
+// Returns the index of the zone server at address, or -1 for anything else, e.g. a client.
+const int ZoneMap::FindZone(const sockaddr_in& address) const
+{
+	for (auto i = 0; i < zones.size(); i++)
+	{
+		if (zones[i].address.sin_addr.s_addr == address.sin_addr.s_addr && zones[i].address.sin_port == address.sin_port)
+			return i;
+	}
+	return -1;
+}
+
+// Fills borderZones with every other zone whose edge is within ZONE_BORDER_WIDTH of position.
+void ZoneMap::GetBorderZones(const XMFLOAT3& position, std::vector<int>& borderZones) const
+{
+	borderZones.clear();
+	for (auto i = 0; i < zones.size(); i++)
+	{
+		if (i != localZone && position.x >= zones[i].minX - ZONE_BORDER_WIDTH && position.x < zones[i].maxX + ZONE_BORDER_WIDTH)
+			borderZones.push_back(i);
+	}
+}
\ No newline at end of file
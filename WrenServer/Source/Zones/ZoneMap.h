@@ -0,0 +1,35 @@
+#pragma once
+
+#include <Constants.h>
+
+constexpr auto ZONE_MAP_EXTENT = MAP_WIDTH * TILE_SIZE;
+constexpr auto ZONE_BORDER_WIDTH = TILE_SIZE * 10.0f; // entities this close to a boundary are shown to the zone across it
+
+struct Zone
+{
+	int index;
+	float minX;
+	float maxX;
+	sockaddr_in address; // the WrenServer process that owns the zone
+};
+
+// The map split along x into equal strips, one per WrenServer process, west to east. Every process is
+// given the same list of addresses and the index of its own zone, e.g.
+//   --zones 127.0.0.1:27016,127.0.0.1:27017 --zone 1
+// Without a list there's a single zone covering the whole map, owned by SERVER_PORT_NUMBER.
+class ZoneMap
+{
+	std::vector<Zone> zones;
+	int localZone{ 0 };
+
+public:
+	ZoneMap();
+	ZoneMap(const std::string& addresses, const int localZone);
+	const int GetZoneCount() const;
+	const Zone& GetZone(const int index) const;
+	const Zone& GetLocalZone() const;
+	const int GetZoneIndex(const XMFLOAT3& position) const;
+	const bool IsLocal(const XMFLOAT3& position) const;
+	const int FindZone(const sockaddr_in& address) const;
+	void GetBorderZones(const XMFLOAT3& position, std::vector<int>& borderZones) const;
+};
\ No newline at end of file
@@ -17,6 +17,7 @@
 
 #include <sqlite3.h>
 #include <Combaseapi.h>
+#include <timeapi.h>
 #include <sodium.h>
 #include <vector>
 #include <iostream>
@@ -26,9 +27,16 @@
 #include <list>
 #include <queue>
 #include <map>
+#include <unordered_map>
 #include <DirectXMath.h>
 #include <random>
 #include <Extensions.h>
 #include <functional>
+#include <conio.h>
+#include <sstream>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <condition_variable>
 
 using namespace DirectX;
@@ -0,0 +1,220 @@
+#include "stdafx.h"
+#include "Test.h"
+#include <Networking/BitWriter.h>
+#include <Networking/BitReader.h>
+#include <Networking/Direction.h>
+#include <Networking/EntityState.h>
+
+// Odd widths keep every later value straddling a byte boundary.
+TEST(BitsRoundTripAcrossByteBoundaries)
+{
+	BitWriter writer;
+	writer.WriteBits(1, 1);
+	writer.WriteBits(0x1ABCD, 17);
+	writer.WriteBits(0xDEADBEEF, 32);
+	writer.WriteBits(0, 1);
+	writer.WriteBits(0x10001, 17);
+	writer.WriteBits(0xFFFFFFFF, 32);
+	writer.WriteBool(true);
+	CHECK(writer.GetBitsWritten() == 101);
+	writer.Flush();
+	CHECK(writer.GetLength() == 13);
+
+	BitReader reader{ writer.GetData(), writer.GetLength() };
+	CHECK(reader.ReadBits(1) == 1);
+	CHECK(reader.ReadBits(17) == 0x1ABCD);
+	CHECK(reader.ReadBits(32) == 0xDEADBEEF);
+	CHECK(reader.ReadBits(1) == 0);
+	CHECK(reader.ReadBits(17) == 0x10001);
+	CHECK(reader.ReadBits(32) == 0xFFFFFFFF);
+	CHECK(reader.ReadBool());
+	CHECK(!reader.Failed());
+}
+
+// only the low bits of a value are written
+TEST(BitsAreMaskedToTheirWidth)
+{
+	BitWriter writer;
+	writer.WriteBits(0xFF, 3);
+	writer.WriteBits(0x3FFFF, 17);
+	writer.Flush();
+
+	BitReader reader{ writer.GetData(), writer.GetLength() };
+	CHECK(reader.ReadBits(3) == 7);
+	CHECK(reader.ReadBits(17) == 0x1FFFF);
+}
+
+TEST(RangedIntIsClampedToItsRange)
+{
+	BitWriter writer;
+	writer.WriteRangedInt(-50, -10, 10);
+	writer.WriteRangedInt(50, -10, 10);
+	writer.WriteRangedInt(3, -10, 10);
+	writer.WriteRangedInt(MAX_VITAL_VALUE + 1, 0, MAX_VITAL_VALUE);
+	// 20 fits in 5 bits
+	CHECK(writer.GetBitsWritten() == 3 * 5 + 16);
+	writer.Flush();
+
+	BitReader reader{ writer.GetData(), writer.GetLength() };
+	CHECK(reader.ReadRangedInt(-10, 10) == -10);
+	CHECK(reader.ReadRangedInt(-10, 10) == 10);
+	CHECK(reader.ReadRangedInt(-10, 10) == 3);
+	CHECK(reader.ReadRangedInt(0, MAX_VITAL_VALUE) == MAX_VITAL_VALUE);
+	CHECK(!reader.Failed());
+}
+
+// a range that isn't a power of two leaves bit patterns no writer produces
+TEST(RangedIntOutOfRangeOnTheWireFailsTheReader)
+{
+	BitWriter writer;
+	writer.WriteBits(7, 3);
+	writer.Flush();
+
+	BitReader reader{ writer.GetData(), writer.GetLength() };
+	CHECK(reader.ReadRangedInt(0, 5) == 5);
+	CHECK(reader.Failed());
+}
+
+TEST(DirectionsUseFourBitsUnlessEscaped)
+{
+	const XMFLOAT3 compass[]{ VEC_ZERO, VEC_NORTH, VEC_NORTHEAST, VEC_EAST, VEC_SOUTHEAST, VEC_SOUTH, VEC_SOUTHWEST, VEC_WEST, VEC_NORTHWEST };
+	const XMFLOAT3 other{ 0.6f, -0.25f, 0.8f };
+
+	BitWriter writer;
+	for (const auto& direction : compass)
+		writer.WriteDirection(direction);
+	CHECK(writer.GetBitsWritten() == static_cast<int>(std::size(compass)) * DIRECTION_BITS);
+	writer.WriteDirection(other);
+	CHECK(writer.GetBitsWritten() == static_cast<int>(std::size(compass)) * DIRECTION_BITS + DIRECTION_BITS + 3 * 32);
+	writer.Flush();
+
+	BitReader reader{ writer.GetData(), writer.GetLength() };
+	for (const auto& direction : compass)
+	{
+		const auto read = reader.ReadDirection();
+		CHECK(read.x == direction.x && read.y == direction.y && read.z == direction.z);
+	}
+	const auto read = reader.ReadDirection();
+	CHECK(read.x == other.x && read.y == other.y && read.z == other.z);
+	CHECK(!reader.Failed());
+}
+
+// indices between the compass directions and the escape code aren't valid
+TEST(UnknownDirectionIndexFailsTheReader)
+{
+	BitWriter writer;
+	writer.WriteBits(DIRECTION_COUNT, DIRECTION_BITS);
+	writer.Flush();
+
+	BitReader reader{ writer.GetData(), writer.GetLength() };
+	const auto read = reader.ReadDirection();
+	CHECK(read.x == 0.0f && read.y == 0.0f && read.z == 0.0f);
+	CHECK(reader.Failed());
+}
+
+TEST(ReadingPastTheEndFailsTheReader)
+{
+	BitWriter writer;
+	writer.WriteBits(0x5A, 8);
+	writer.WriteString("name");
+	writer.Flush();
+
+	// cut off in the middle of the string
+	BitReader reader{ writer.GetData(), writer.GetLength() - 2 };
+	CHECK(reader.ReadBits(8) == 0x5A);
+	CHECK(!reader.Failed());
+	reader.ReadString();
+	CHECK(reader.Failed());
+	CHECK(reader.ReadBits(32) == 0);
+	CHECK(reader.ReadFloat() == 0.0f);
+
+	BitReader empty{ writer.GetData(), 0 };
+	CHECK(empty.ReadBits(1) == 0);
+	CHECK(empty.Failed());
+}
+
+static void CheckEntityStateRoundTrip(const EntityState& written, const bool isPlayer)
+{
+	BitWriter writer;
+	written.Write(writer, isPlayer);
+	writer.Flush();
+
+	BitReader reader{ writer.GetData(), writer.GetLength() };
+	EntityState read;
+	read.Read(reader, isPlayer);
+	CHECK(!reader.Failed());
+
+	// positions are quantized to POSITION_BITS over the map, so they come back within half a step
+	const auto maxErrorX = TILE_SIZE * MAP_WIDTH / ((1 << POSITION_BITS) - 1) / 2.0f + 0.0001f;
+	const auto maxErrorZ = TILE_SIZE * MAP_HEIGHT / ((1 << POSITION_BITS) - 1) / 2.0f + 0.0001f;
+	CHECK(read.sequence == written.sequence);
+	CHECK(read.id == written.id);
+	CHECK(std::abs(read.position.x - written.position.x) <= maxErrorX);
+	CHECK(read.position.y == written.position.y);
+	CHECK(std::abs(read.position.z - written.position.z) <= maxErrorZ);
+	CHECK(read.movementVector.x == written.movementVector.x && read.movementVector.y == written.movementVector.y && read.movementVector.z == written.movementVector.z);
+	CHECK(read.agility == written.agility);
+	CHECK(read.strength == written.strength);
+	CHECK(read.wisdom == written.wisdom);
+	CHECK(read.intelligence == written.intelligence);
+	CHECK(read.charisma == written.charisma);
+	CHECK(read.luck == written.luck);
+	CHECK(read.endurance == written.endurance);
+	CHECK(read.health == written.health);
+	CHECK(read.maxHealth == written.maxHealth);
+	CHECK(read.mana == written.mana);
+	CHECK(read.maxMana == written.maxMana);
+	CHECK(read.stamina == written.stamina);
+	CHECK(read.maxStamina == written.maxStamina);
+	if (isPlayer)
+	{
+		CHECK(read.modelId == written.modelId);
+		CHECK(read.textureId == written.textureId);
+		CHECK(read.name == written.name);
+	}
+}
+
+static const EntityState MakeEntityState(const int id, const XMFLOAT3& position, const XMFLOAT3& movementVector)
+{
+	EntityState state;
+	state.sequence = static_cast<unsigned short>(id * 7);
+	state.id = id;
+	state.position = position;
+	state.movementVector = movementVector;
+	state.agility = 11;
+	state.strength = 12;
+	state.wisdom = 13;
+	state.intelligence = 14;
+	state.charisma = 15;
+	state.luck = 16;
+	state.endurance = MAX_ATTRIBUTE_VALUE;
+	state.health = 87;
+	state.maxHealth = 100;
+	state.mana = 0;
+	state.maxMana = 250;
+	state.stamina = MAX_VITAL_VALUE;
+	state.maxStamina = MAX_VITAL_VALUE;
+	return state;
+}
+
+TEST(NpcEntityStateRoundTrips)
+{
+	CheckEntityStateRoundTrip(MakeEntityState(42, XMFLOAT3{ 1234.567f, 0.0f, 89.01f }, VEC_SOUTHWEST), false);
+	CheckEntityStateRoundTrip(MakeEntityState(43, XMFLOAT3{ 0.0f, 0.0f, 0.0f }, VEC_ZERO), false);
+	CheckEntityStateRoundTrip(MakeEntityState(44, XMFLOAT3{ TILE_SIZE * MAP_WIDTH, 0.0f, TILE_SIZE * MAP_HEIGHT }, VEC_NORTH), false);
+}
+
+// players also carry their model, texture and name; an off-plane position and odd movement vector take the escapes
+TEST(PlayerEntityStateRoundTrips)
+{
+	auto state = MakeEntityState(7, XMFLOAT3{ 1500.25f, 3.5f, 2999.99f }, XMFLOAT3{ 0.6f, 0.0f, 0.8f });
+	state.modelId = 3;
+	state.textureId = MAX_ASSET_ID;
+	state.name = "Bloog";
+	CheckEntityStateRoundTrip(state, true);
+
+	state.name = "";
+	state.position.y = 0.0f;
+	state.movementVector = VEC_EAST;
+	CheckEntityStateRoundTrip(state, true);
+}
@@ -0,0 +1,167 @@
+#include "stdafx.h"
+#include "Test.h"
+#include <Networking/ClockSync.h>
+
+// A server clock offset + drift * localTime ahead of ours, behind a link whose way out is faster than its way
+// back, with random queuing on top. Seeded, so every run sees the same samples.
+struct SyntheticServer
+{
+	double offset;
+	double drift;
+	double uplink{ 0.02 };   // seconds
+	double downlink{ 0.06 }; // seconds
+	double maxQueuing{ 0.04 };
+	std::mt19937 rng{ 50 };
+
+	const double GetOffset(const double localTime) const { return offset + drift * localTime; }
+
+	// The server's answer to a Ping sent at sendTime, and when it gets back.
+	void Pong(const double sendTime, double& serverTime, double& receiveTime)
+	{
+		std::uniform_real_distribution<double> queuing{ 0.0, maxQueuing };
+		const auto arrival = sendTime + uplink + queuing(rng);
+		serverTime = arrival + GetOffset(arrival);
+		receiveTime = arrival + downlink + queuing(rng);
+	}
+
+	// Pings at sendTime and feeds the Pong to clockSync, returning the local time it arrived.
+	const double Ping(ClockSync& clockSync, const double sendTime)
+	{
+		double serverTime, receiveTime;
+		Pong(sendTime, serverTime, receiveTime);
+		clockSync.AddSample(sendTime, serverTime, receiveTime);
+		return receiveTime;
+	}
+};
+
+// Pings every GetPingInterval from start until end, and returns when the last Pong arrived.
+static const double Sync(ClockSync& clockSync, SyntheticServer& server, const double start, const double end)
+{
+	auto now = start;
+	while (now < end)
+		now = server.Ping(clockSync, now) + clockSync.GetPingInterval();
+	return now;
+}
+
+TEST(ClockFollowsLocalTimeUntilFirstSample)
+{
+	ClockSync clockSync;
+	CHECK(!clockSync.IsSynced());
+	CHECK(clockSync.GetPingInterval() == CLOCK_SYNC_FAST_INTERVAL);
+	CHECK(clockSync.GetServerTime(12.5) == 12.5);
+}
+
+// The true offset is within half the best round trip of its estimate, however lopsided the link is.
+TEST(ClockOffsetIsWithinHalfTheBestRoundTrip)
+{
+	ClockSync clockSync;
+	SyntheticServer server{ 1000.0, 0.0 };
+
+	const auto first = server.Ping(clockSync, 1.0);
+	CHECK(std::abs(clockSync.GetServerTime(first) - (first + server.GetOffset(first))) <= (server.uplink + server.downlink + 2 * server.maxQueuing) / 2.0);
+
+	const auto now = Sync(clockSync, server, first, 60.0);
+	CHECK(clockSync.IsSynced());
+	CHECK(clockSync.GetPingInterval() == CLOCK_SYNC_INTERVAL);
+
+	// each call only slews the clock so far, but nothing has asked since the first sample
+	const auto serverTime = clockSync.GetServerTime(now);
+	CHECK(std::abs(serverTime - (now + server.GetOffset(now))) <= (server.uplink + server.downlink + 0.01) / 2.0);
+	CHECK(clockSync.GetRtt() >= server.uplink + server.downlink);
+	CHECK(clockSync.GetJitter() > 0.0 && clockSync.GetJitter() < server.maxQueuing * 2);
+}
+
+// After the last sample the clock keeps moving away from local time at the estimated drift.
+static const double MeasureDrift(const double drift)
+{
+	ClockSync clockSync;
+	SyntheticServer server{ 5.0, drift };
+	server.maxQueuing = 0.0;
+	const auto now = Sync(clockSync, server, 0.0, 40.0);
+
+	const auto start = clockSync.GetServerTime(now);
+	const auto end = clockSync.GetServerTime(now + 100.0);
+	return (end - start - 100.0) / 100.0;
+}
+
+TEST(ClockDriftIsEstimatedAndClamped)
+{
+	CHECK(std::abs(MeasureDrift(0.0)) < 0.00001);
+	CHECK(std::abs(MeasureDrift(0.0002) - 0.0002) < 0.00002);
+	CHECK(std::abs(MeasureDrift(-0.0002) + 0.0002) < 0.00002);
+	CHECK(std::abs(MeasureDrift(0.005) - CLOCK_SYNC_MAX_DRIFT) < 0.00001);
+	CHECK(std::abs(MeasureDrift(-0.005) + CLOCK_SYNC_MAX_DRIFT) < 0.00001);
+}
+
+// Frame by frame, the clock is slewed towards each new estimate, so it never goes backwards and never
+// runs more than CLOCK_SYNC_MAX_SLEW slow or fast.
+TEST(ClockNeverRunsBackwards)
+{
+	ClockSync clockSync;
+	SyntheticServer server{ -300.0, 0.0003 };
+	server.maxQueuing = 0.15;
+
+	auto pingSent = false;
+	auto pingTime = 0.0;
+	double serverTime, pongTime;
+	auto snapped = false;
+	auto previous = clockSync.GetServerTime(0.0);
+	const auto frame = 1.0 / 60.0;
+	for (auto now = frame; now < 600.0; now += frame)
+	{
+		if (!pingSent && now >= pingTime)
+		{
+			pingTime = now;
+			server.Pong(pingTime, serverTime, pongTime);
+			pingSent = true;
+		}
+		// the first Pong snaps the clock onto the server's
+		const auto firstSample = pingSent && now >= pongTime && !snapped;
+		if (pingSent && now >= pongTime)
+		{
+			clockSync.AddSample(pingTime, serverTime, now);
+			pingTime = now + clockSync.GetPingInterval();
+			pingSent = false;
+			snapped = true;
+		}
+
+		const auto current = clockSync.GetServerTime(now);
+		if (snapped && !firstSample)
+		{
+			CHECK(current > previous);
+			CHECK(current - previous >= frame * (1.0 - CLOCK_SYNC_MAX_SLEW) - 0.000001);
+			CHECK(current - previous <= frame * (1.0 + CLOCK_SYNC_MAX_SLEW) + 0.000001);
+		}
+		previous = current;
+	}
+	CHECK(std::abs(previous - (600.0 + server.GetOffset(600.0))) < 0.1);
+}
+
+// e.g. a gateway moved us to a zone whose clock started at another time, without a ZoneTransfer to Reset on
+TEST(ClockResetsOnOffsetJump)
+{
+	ClockSync clockSync;
+	SyntheticServer server{ 100.0, 0.0 };
+	auto now = Sync(clockSync, server, 0.0, 30.0);
+	CHECK(clockSync.IsSynced());
+	const auto rtt = clockSync.GetRtt();
+
+	// further off than any round trip could explain
+	server.offset += 50.0;
+	now = server.Ping(clockSync, now + 1.0);
+	CHECK(!clockSync.IsSynced());
+	CHECK(clockSync.GetPingInterval() == CLOCK_SYNC_FAST_INTERVAL);
+	CHECK(clockSync.GetRtt() > 0.0 && std::abs(clockSync.GetRtt() - rtt) < 2 * server.maxQueuing);
+	CHECK(std::abs(clockSync.GetServerTime(now) - (now + server.GetOffset(now))) <= (server.uplink + server.downlink + 2 * server.maxQueuing) / 2.0);
+
+	// an offset change within the round trip's uncertainty is just noise
+	now = Sync(clockSync, server, now, now + 30.0);
+	server.offset += 0.05;
+	server.Ping(clockSync, now + 1.0);
+	CHECK(clockSync.IsSynced());
+
+	clockSync.Reset();
+	CHECK(!clockSync.IsSynced());
+	CHECK(clockSync.GetRtt() == 0.0);
+	CHECK(clockSync.GetServerTime(now) == now);
+}
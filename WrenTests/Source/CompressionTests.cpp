@@ -0,0 +1,282 @@
+#include "stdafx.h"
+#include "Test.h"
+#include "TestSocketManager.h"
+#include <Networking/Compression.h>
+#include <Utility.h>
+
+static const std::vector<char> Compress(const std::vector<char>& input)
+{
+	std::vector<char> compressed(Compression::GetMaxCompressedSize(static_cast<int>(input.size())));
+	const auto length = Compression::Compress(input.data(), static_cast<int>(input.size()), compressed.data(), static_cast<int>(compressed.size()));
+	compressed.resize(length);
+	return compressed;
+}
+
+static const bool Decompress(const std::vector<char>& compressed, std::vector<char>& output)
+{
+	return Compression::Decompress(compressed.data(), static_cast<int>(compressed.size()), output.data(), static_cast<int>(output.size()));
+}
+
+static void CheckRoundTrip(const std::vector<char>& input)
+{
+	const auto compressed = Compress(input);
+	CHECK(!compressed.empty());
+	CHECK(compressed.size() <= static_cast<size_t>(Compression::GetMaxCompressedSize(static_cast<int>(input.size()))));
+
+	std::vector<char> output(input.size());
+	CHECK(Decompress(compressed, output));
+	CHECK(output == input);
+}
+
+static const std::vector<char> RandomBytes(const int length, const unsigned int seed)
+{
+	std::mt19937 rng{ seed };
+	std::uniform_int_distribution<int> byte{ 0, 255 };
+	std::vector<char> bytes(length);
+	for (auto& b : bytes)
+		b = static_cast<char>(byte(rng));
+	return bytes;
+}
+
+TEST(CompressionRoundTripsEmptyInput)
+{
+	CheckRoundTrip({});
+}
+
+TEST(CompressionRoundTripsIncompressibleInput)
+{
+	for (const auto length : { 1, 3, 4, 5, 100, 1000, 5000 })
+		CheckRoundTrip(RandomBytes(length, length));
+}
+
+// the match starts one byte behind the bytes it produces, so the decoder copies what it's still writing
+TEST(CompressionRoundTripsOverlappingRuns)
+{
+	CheckRoundTrip(std::vector<char>(5000, 'a'));
+
+	std::vector<char> pattern;
+	for (auto i = 0; i < 3000; i++)
+		pattern.push_back("abc"[i % 3]);
+	CheckRoundTrip(pattern);
+
+	const auto message = std::string{ "EnterWorldSuccess|1|2.0|0.0|3.0|" } + std::string(400, '0') + "|name|10|10|10|10";
+	CheckRoundTrip(std::vector<char>{ message.begin(), message.end() });
+}
+
+// A literal or match length of 15 or more continues in extra bytes, and an extra byte of 255 means another follows.
+TEST(CompressionRoundTripsLengthExtensionBytes)
+{
+	// a run of n bytes is one literal, a match of n - 1 (at least 4), then an empty last sequence
+	const auto run = [](const int extraMatchLength) { return std::vector<char>(1 + 4 + extraMatchLength, 'a'); };
+
+	auto compressed = Compress(run(15));
+	CHECK(static_cast<unsigned char>(compressed[0]) == 0x1F);
+	CHECK(static_cast<unsigned char>(compressed[4]) == 0);
+
+	compressed = Compress(run(15 + 255));
+	CHECK(static_cast<unsigned char>(compressed[0]) == 0x1F);
+	CHECK(static_cast<unsigned char>(compressed[4]) == 255);
+	CHECK(static_cast<unsigned char>(compressed[5]) == 0);
+
+	compressed = Compress(RandomBytes(15, 1));
+	CHECK(static_cast<unsigned char>(compressed[0]) == 0xF0);
+	CHECK(static_cast<unsigned char>(compressed[1]) == 0);
+
+	compressed = Compress(RandomBytes(15 + 255, 2));
+	CHECK(static_cast<unsigned char>(compressed[0]) == 0xF0);
+	CHECK(static_cast<unsigned char>(compressed[1]) == 255);
+	CHECK(static_cast<unsigned char>(compressed[2]) == 0);
+
+	for (const auto length : { 14, 15, 16, 269, 270, 271, 524, 525, 526 })
+	{
+		CheckRoundTrip(run(length));
+		CheckRoundTrip(RandomBytes(length, length));
+	}
+}
+
+TEST(DecompressionRejectsTruncatedInput)
+{
+	const auto message = std::string{ "PropagateChatMessage|" } + std::string(300, 'x') + "|Bloog|Party|" + std::string(300, 'y');
+	const std::vector<char> input{ message.begin(), message.end() };
+	const auto compressed = Compress(input);
+
+	std::vector<char> output(input.size());
+	for (size_t length = 0; length < compressed.size(); length++)
+		CHECK(!Decompress(std::vector<char>{ compressed.begin(), compressed.begin() + length }, output));
+	CHECK(Decompress(compressed, output));
+}
+
+// Corrupt input can decode to the wrong bytes, but never past the end of the output.
+TEST(DecompressionStaysInBoundsOnCorruptInput)
+{
+	const auto message = std::string{ "ListSkills|" } + std::string(200, 'z') + "|1%Melee%10;2%Magic%10;3%Healing%10;";
+	const std::vector<char> input{ message.begin(), message.end() };
+	const auto compressed = Compress(input);
+
+	const auto guard = 64;
+	std::mt19937 rng{ 30 };
+	for (auto i = 0; i < 2000; i++)
+	{
+		auto corrupt = compressed;
+		corrupt[rng() % corrupt.size()] ^= static_cast<char>(1 << (rng() % 8));
+
+		std::vector<char> output(input.size() + guard, '#');
+		Compression::Decompress(corrupt.data(), static_cast<int>(corrupt.size()), output.data(), static_cast<int>(input.size()));
+		CHECK(std::all_of(output.end() - guard, output.end(), [](const char c) { return c == '#'; }));
+	}
+
+	// a literal length longer than the rest of the input, and a match longer than the output
+	std::vector<char> output(input.size());
+	CHECK(!Decompress({ static_cast<char>(0xF0), static_cast<char>(255), 0, 'a' }, output));
+	std::vector<char> small(5);
+	CHECK(!Decompress({ 0x1F, 'a', 1, 0, 0, 0 }, small));
+}
+
+// one literal, then a match of four at the given offset, then an empty last sequence
+static const std::vector<char> MatchAtOffset(const unsigned short offset)
+{
+	std::vector<char> compressed{ 0x10, 'a', 0, 0, 0 };
+	memcpy(compressed.data() + 2, &offset, sizeof(unsigned short));
+	return compressed;
+}
+
+TEST(DecompressionRejectsBadOffsets)
+{
+	std::vector<char> output(5);
+	CHECK(Decompress(MatchAtOffset(1), output));
+	CHECK(std::string(output.begin(), output.end()) == "aaaaa");
+
+	CHECK(!Decompress(MatchAtOffset(0), output));
+	// only one byte has been written when the match starts
+	CHECK(!Decompress(MatchAtOffset(2), output));
+	CHECK(!Decompress(MatchAtOffset(65535), output));
+}
+
+// A fixed mix of what the server sends: short chat lines every tick, which stay under the threshold, a loot
+// list now and then, and the character's skills and abilities on entering the world.
+static const std::vector<std::vector<std::string>> CompressionCorpus(const int ticks)
+{
+	const char* const words[]{ "the", "orc", "is", "over", "by", "camp", "need", "heals", "anyone", "going", "north", "party", "lf", "tank", "gg" };
+	std::mt19937 rng{ 30 };
+
+	std::vector<std::vector<std::string>> corpus(ticks);
+	for (auto tick = 0; tick < ticks; tick++)
+	{
+		for (auto line = 0; line < 4; line++)
+		{
+			std::string text;
+			const auto wordCount = 2 + rng() % 8;
+			for (auto i = 0u; i < wordCount; i++)
+				text += std::string{ i > 0 ? " " : "" } + words[rng() % std::size(words)];
+			corpus[tick].push_back(text);
+		}
+
+		if (tick % 5 == 0)
+		{
+			std::string loot;
+			for (auto i = 0; i < 24; i++)
+				loot += std::to_string(rng() % 400) + "%" + std::to_string(rng() % 5) + "%1;";
+			corpus[tick].push_back(loot);
+		}
+
+		if (tick % 60 == 0)
+		{
+			std::string skillsAndAbilities;
+			for (auto i = 0; i < 20; i++)
+				skillsAndAbilities += std::to_string(i) + "%Skill " + std::to_string(i) + "%" + std::to_string(rng() % 100) + ";";
+			skillsAndAbilities += "|";
+			for (auto i = 0; i < 10; i++)
+				skillsAndAbilities += std::to_string(i) + "%Ability " + std::to_string(i) + "%Does something to the target.%" + std::to_string(i) + "%0%1;";
+			corpus[tick].push_back(skillsAndAbilities);
+		}
+	}
+	return corpus;
+}
+
+struct CompressionRun
+{
+	CompressionStats sent;
+	CompressionStats received;
+};
+
+// Sends the corpus one tick at a time between two TestSocketManagers, which is what the server's once a
+// minute bytes/tick/client line measures on live traffic.
+static const CompressionRun RunCompressionCorpus(const std::vector<std::vector<std::string>>& corpus, const bool compress)
+{
+	double now{ 100.0 };
+	EventHandler eventHandler;
+	TestSocketManager server{ eventHandler, now };
+	TestSocketManager client{ eventHandler, now };
+	server.SetHandshakeRequired(false);
+	client.SetHandshakeRequired(false);
+	server.SetCompressionEnabled(compress);
+	const auto serverAddress = MakeAddress(1000);
+	const auto clientAddress = MakeAddress(2000);
+
+	// let the client's first datagram tell the server it can decompress
+	client.SendReliable(serverAddress, "hello");
+	Exchange(server, serverAddress, client, clientAddress, now, 2, UPDATE_FREQUENCY);
+	server.ResetCompressionStats();
+	client.ResetCompressionStats();
+
+	size_t expectedCount{ 0 };
+	for (const auto& tick : corpus)
+	{
+		for (const auto& text : tick)
+			server.SendReliable(clientAddress, text);
+		expectedCount += tick.size();
+		Exchange(server, serverAddress, client, clientAddress, now, 1, UPDATE_FREQUENCY);
+	}
+	Exchange(server, serverAddress, client, clientAddress, now, 10, UPDATE_FREQUENCY);
+	CHECK(client.received.size() == expectedCount);
+
+	return CompressionRun{ server.GetCompressionStats(), client.GetCompressionStats() };
+}
+
+// The byte counts the benchmark reports depend only on the corpus.
+TEST(CompressionCorpusIsReproducible)
+{
+	const auto corpus = CompressionCorpus(120);
+	const auto first = RunCompressionCorpus(corpus, true);
+	const auto second = RunCompressionCorpus(corpus, true);
+	const auto uncompressed = RunCompressionCorpus(corpus, false);
+
+	CHECK(first.sent.bytesSent == second.sent.bytesSent);
+	CHECK(first.sent.compressedBytes == second.sent.compressedBytes);
+	CHECK(first.sent.messagesCompressed > 0);
+	CHECK(first.received.messagesDecompressed == first.sent.messagesCompressed);
+	CHECK(first.sent.bytesSent < uncompressed.sent.bytesSent);
+	CHECK(uncompressed.sent.messagesCompressed == 0);
+}
+
+// bytes/tick with and without compression, and the CPU compression costs per tick as the median of a few
+// runs, so a threshold or codec change can be compared against the same traffic.
+BENCHMARK(CompressionBytesAndCpuPerTick)
+{
+	const auto ticks = 6000;
+	const auto runs = 5;
+	const auto corpus = CompressionCorpus(ticks);
+	const auto uncompressed = RunCompressionCorpus(corpus, false);
+
+	std::vector<CompressionRun> compressedRuns;
+	for (auto i = 0; i < runs; i++)
+		compressedRuns.push_back(RunCompressionCorpus(corpus, true));
+	const auto median = [&compressedRuns](const std::function<const double(const CompressionRun&)>& value)
+	{
+		std::vector<double> values;
+		for (const auto& run : compressedRuns)
+			values.push_back(value(run));
+		std::sort(values.begin(), values.end());
+		return values[values.size() / 2];
+	};
+
+	const auto& compressed = compressedRuns[0];
+	std::cout << std::fixed << std::setprecision(2)
+		<< "  " << ticks << " ticks, threshold " << COMPRESSION_THRESHOLD << " bytes\n"
+		<< "  uncompressed: " << static_cast<double>(uncompressed.sent.bytesSent) / ticks << " bytes/tick\n"
+		<< "  compressed:   " << static_cast<double>(compressed.sent.bytesSent) / ticks << " bytes/tick, "
+		<< compressed.sent.messagesCompressed << " messages at "
+		<< 100.0 * compressed.sent.compressedBytes / Utility::Max(compressed.sent.uncompressedBytes, 1ll) << "% of their size\n"
+		<< "  compress:     " << median([](const CompressionRun& run) { return run.sent.compressTime; }) * 1000000.0 / ticks << " us/tick\n"
+		<< "  decompress:   " << median([](const CompressionRun& run) { return run.received.decompressTime; }) * 1000000.0 / ticks << " us/tick\n";
+}
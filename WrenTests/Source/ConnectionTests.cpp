@@ -0,0 +1,78 @@
+#include "stdafx.h"
+#include "Test.h"
+#include <Networking/Connection.h>
+
+// The receive side of SocketManager::ReceiveMessage for the reliable channel: deliver the next id and
+// anything buffered behind it, buffer ids from the future, and drop everything else as a resend.
+static void ReceiveReliable(Connection& connection, const unsigned short messageId, std::vector<unsigned short>& delivered)
+{
+	if (connection.IsNextReliableMessage(messageId))
+	{
+		connection.AdvanceReliableMessageId();
+		delivered.push_back(messageId);
+
+		auto it = connection.bufferedReliableMessages.find(connection.GetNextExpectedReliableMessageId());
+		while (it != connection.bufferedReliableMessages.end())
+		{
+			delivered.push_back(it->first);
+			connection.bufferedReliableMessages.erase(it);
+			connection.AdvanceReliableMessageId();
+			it = connection.bufferedReliableMessages.find(connection.GetNextExpectedReliableMessageId());
+		}
+	}
+	else if (connection.IsFutureReliableMessage(messageId))
+		connection.bufferedReliableMessages[messageId] = BufferedReliableMessage{ };
+}
+
+TEST(ReliableStreamStartsAtZero)
+{
+	Connection connection;
+	CHECK(connection.IsNextReliableMessage(0));
+	CHECK(!connection.IsNextReliableMessage(1));
+	CHECK(connection.IsFutureReliableMessage(1));
+}
+
+// e.g. ids 0 and 1 went out in separate datagrams and the network swapped them
+TEST(ReorderedFirstDeliveryIsBuffered)
+{
+	Connection connection;
+	connection.SetRemoteSalt(1234);
+	std::vector<unsigned short> delivered;
+
+	CHECK(connection.OnDatagramReceived(1));
+	ReceiveReliable(connection, 1, delivered);
+	CHECK(delivered.empty());
+
+	CHECK(connection.OnDatagramReceived(0));
+	ReceiveReliable(connection, 0, delivered);
+	CHECK(delivered == (std::vector<unsigned short>{ 0, 1 }));
+	CHECK(connection.GetNextExpectedReliableMessageId() == 2);
+}
+
+TEST(NewRemoteSaltRestartsReliableStream)
+{
+	Connection connection;
+	std::vector<unsigned short> delivered;
+
+	connection.SetRemoteSalt(1234);
+	CHECK(connection.OnDatagramReceived(0));
+	ReceiveReliable(connection, 0, delivered);
+	ReceiveReliable(connection, 1, delivered);
+	CHECK(connection.GetNextExpectedReliableMessageId() == 2);
+
+	connection.SetRemoteSalt(4321);
+	CHECK(connection.GetNextExpectedReliableMessageId() == 0);
+	CHECK(!connection.HasAck());
+}
+
+TEST(NoAckBeforeFirstDatagram)
+{
+	Connection connection;
+	CHECK(!connection.HasAck());
+
+	connection.SetRemoteSalt(1234);
+	CHECK(connection.OnDatagramReceived(7));
+	CHECK(connection.HasAck());
+	CHECK(connection.GetAck() == 7);
+	CHECK(connection.GetRemoteSalt() == 1234);
+}
\ No newline at end of file
@@ -0,0 +1,65 @@
+#include "stdafx.h"
+#include "Test.h"
+#include <Networking/EntitySequences.h>
+#include <Networking/EntityState.h>
+
+// e.g. Npc 7's update 2 overtook its update 1 on the way
+TEST(StaleUpdateIsDroppedPerEntity)
+{
+	EntitySequences sequences;
+	CHECK(sequences.Accept(OpCode::NpcUpdate, 7, 2, 0.0));
+	CHECK(!sequences.Accept(OpCode::NpcUpdate, 7, 1, 0.0));
+	CHECK(!sequences.Accept(OpCode::NpcUpdate, 7, 2, 0.0));
+	CHECK(sequences.Accept(OpCode::NpcUpdate, 7, 3, 0.0));
+}
+
+// entities count their updates independently, so another entity's newer update doesn't make this one stale
+TEST(InterleavedEntitiesDontShadowEachOther)
+{
+	EntitySequences sequences;
+	CHECK(sequences.Accept(OpCode::NpcUpdate, 1, 500, 0.0));
+	CHECK(sequences.Accept(OpCode::NpcUpdate, 2, 3, 0.0));
+	CHECK(sequences.Accept(OpCode::PlayerUpdate, 1, 3, 0.0));
+	CHECK(sequences.Accept(OpCode::PlayerCorrection, 1, 3, 0.0));
+	CHECK(sequences.Accept(OpCode::NpcUpdate, 2, 4, 0.0));
+	CHECK(sequences.Accept(OpCode::NpcUpdate, 1, 501, 0.0));
+}
+
+TEST(EntitySequenceWrapsAround)
+{
+	EntitySequences sequences;
+	CHECK(sequences.Accept(OpCode::PlayerUpdate, 9, 65535, 0.0));
+	CHECK(sequences.Accept(OpCode::PlayerUpdate, 9, 0, 0.0));
+	CHECK(!sequences.Accept(OpCode::PlayerUpdate, 9, 65535, 0.0));
+}
+
+// e.g. the player logged back in and its sequence started over
+TEST(QuietEntityStartsOverAfterTimeout)
+{
+	EntitySequences sequences;
+	CHECK(sequences.Accept(OpCode::PlayerUpdate, 9, 1000, 0.0));
+	CHECK(!sequences.Accept(OpCode::PlayerUpdate, 9, 1, ENTITY_SEQUENCE_TIMEOUT / 2));
+	CHECK(sequences.Accept(OpCode::PlayerUpdate, 9, 1, ENTITY_SEQUENCE_TIMEOUT));
+	CHECK(sequences.Accept(OpCode::PlayerUpdate, 9, 2, ENTITY_SEQUENCE_TIMEOUT));
+
+	sequences.Clear();
+	CHECK(sequences.Accept(OpCode::PlayerUpdate, 9, 1, ENTITY_SEQUENCE_TIMEOUT));
+}
+
+TEST(EntityStateCarriesItsSequence)
+{
+	EntityState written;
+	written.sequence = 40000;
+	written.id = 12;
+
+	BitWriter writer;
+	written.Write(writer, false);
+	writer.Flush();
+
+	BitReader reader{ writer.GetData(), writer.GetLength() };
+	EntityState read;
+	read.Read(reader, false);
+	CHECK(!reader.Failed());
+	CHECK(read.sequence == 40000);
+	CHECK(read.id == 12);
+}
@@ -0,0 +1,194 @@
+#include "stdafx.h"
+#include "Test.h"
+#include "TestSocketManager.h"
+#include <Networking/NetworkSimulator.h>
+
+static void Submit(NetworkSimulator& simulator, const SimulatedDirection direction, const sockaddr_in& address, const std::vector<char>& data, const double now)
+{
+	WSABUF buffer;
+	buffer.buf = const_cast<char*>(data.data());
+	buffer.len = static_cast<ULONG>(data.size());
+	simulator.Submit(direction, address, &buffer, 1, now);
+}
+
+// Submits count numbered datagrams, one per millisecond, and returns the numbers in the order they came out.
+static const std::vector<int> RunLossyLink(NetworkSimulator& simulator, const int count)
+{
+	NetworkConditions conditions;
+	conditions.latency = 0.05;
+	conditions.jitter = 0.001;
+	conditions.lossRate = 0.1;
+	conditions.duplicateRate = 0.05;
+	conditions.reorderRate = 0.1;
+	conditions.reorderDelay = 0.02;
+	simulator.SetConditions(conditions);
+
+	const auto address = MakeAddress(1000);
+	std::vector<int> released;
+	SimulatedDatagram datagram;
+	for (auto i = 0; i < count; i++)
+	{
+		const auto now = i * 0.001;
+		std::vector<char> data(sizeof(int));
+		memcpy(data.data(), &i, sizeof(int));
+		Submit(simulator, SimulatedDirection::Outbound, address, data, now);
+		while (simulator.Release(now, datagram))
+			released.push_back(*reinterpret_cast<const int*>(datagram.data.data()));
+	}
+	while (simulator.Release(std::numeric_limits<double>::max(), datagram))
+		released.push_back(*reinterpret_cast<const int*>(datagram.data.data()));
+	return released;
+}
+
+// the same seed loses, duplicates and reorders the same datagrams, at about the configured rates
+TEST(SimulatorIsDeterministicForSeed)
+{
+	const auto count = 10000;
+	NetworkSimulator simulator{ 41 };
+	const auto released = RunLossyLink(simulator, count);
+	const auto stats = simulator.GetStats();
+
+	NetworkSimulator again{ 41 };
+	CHECK(RunLossyLink(again, count) == released);
+	CHECK(again.GetStats().datagramsLost == stats.datagramsLost);
+	CHECK(again.GetStats().datagramsDuplicated == stats.datagramsDuplicated);
+	CHECK(again.GetStats().datagramsReordered == stats.datagramsReordered);
+
+	NetworkSimulator other{ 42 };
+	CHECK(RunLossyLink(other, count) != released);
+
+	CHECK(stats.datagramsLost > 900 && stats.datagramsLost < 1100);
+	const auto kept = count - stats.datagramsLost;
+	CHECK(stats.datagramsDuplicated > kept * 0.04 && stats.datagramsDuplicated < kept * 0.06);
+	const auto scheduled = kept + stats.datagramsDuplicated;
+	CHECK(stats.datagramsReordered > scheduled * 0.09 && stats.datagramsReordered < scheduled * 0.11);
+	CHECK(stats.datagramsOverCapacity == 0);
+	CHECK(static_cast<int>(released.size()) == scheduled);
+
+	// a held back datagram comes out after ones submitted later
+	auto inversions = 0;
+	for (size_t i = 1; i < released.size(); i++)
+	{
+		if (released[i] < released[i - 1])
+			inversions++;
+	}
+	CHECK(inversions > 0);
+
+	simulator.ResetStats();
+	CHECK(simulator.GetStats().datagramsLost == 0 && simulator.GetStats().datagramsReordered == 0);
+}
+
+// At 1000 bytes per second a 125 byte datagram takes an eighth of a second to send, so eight of them fill
+// MAX_SIMULATED_QUEUE_DELAY and the rest are dropped until the backlog drains.
+TEST(BandwidthCapDropsPastMaxQueueDelay)
+{
+	NetworkSimulator simulator{ 41 };
+	NetworkConditions conditions;
+	conditions.latency = 0.1;
+	conditions.bandwidth = 1000;
+	simulator.SetConditions(conditions);
+
+	const auto address = MakeAddress(1000);
+	const std::vector<char> data(125);
+	for (auto i = 0; i < 20; i++)
+		Submit(simulator, SimulatedDirection::Outbound, address, data, 0.0);
+	CHECK(simulator.GetStats().datagramsOverCapacity == 12);
+	CHECK(simulator.GetNextReleaseTime() == 0.125 + conditions.latency);
+
+	// the other direction and other endpoints have links of their own
+	Submit(simulator, SimulatedDirection::Inbound, address, data, 0.0);
+	Submit(simulator, SimulatedDirection::Outbound, MakeAddress(2000), data, 0.0);
+	CHECK(simulator.GetStats().datagramsOverCapacity == 12);
+
+	// half a second later the link is busy until 1.0, leaving room for four more
+	for (auto i = 0; i < 10; i++)
+		Submit(simulator, SimulatedDirection::Outbound, address, data, 0.5);
+	CHECK(simulator.GetStats().datagramsOverCapacity == 18);
+
+	// each one leaves when the one ahead of it is done
+	SimulatedDatagram datagram;
+	std::vector<double> releaseTimes;
+	while (simulator.Release(std::numeric_limits<double>::max(), datagram))
+	{
+		if (datagram.direction == SimulatedDirection::Outbound && datagram.address.sin_port == address.sin_port)
+			releaseTimes.push_back(datagram.releaseTime);
+	}
+	CHECK(releaseTimes.size() == 12);
+	for (size_t i = 0; i < releaseTimes.size(); i++)
+		CHECK(releaseTimes[i] == (i + 1) * 0.125 + conditions.latency);
+	CHECK(simulator.GetNextReleaseTime() == std::numeric_limits<double>::max());
+}
+
+// Runs both ends over one simulated network for duration seconds: everything either end puts on the wire,
+// handshake replies included, goes in addressed to the other end and is handed over when the simulator releases it.
+static void ExchangeOverSimulator(TestSocketManager& a, const sockaddr_in& addressA, TestSocketManager& b, const sockaddr_in& addressB,
+	NetworkSimulator& simulator, double& now, const double duration, const double step)
+{
+	const auto submit = [&simulator, &now](const sockaddr_in& to, const std::vector<CapturedDatagram>& datagrams)
+	{
+		for (const auto& datagram : datagrams)
+			Submit(simulator, SimulatedDirection::Outbound, to, datagram.data, now);
+	};
+
+	const auto end = now + duration;
+	while (now < end)
+	{
+		submit(addressB, a.Flush());
+		submit(addressA, b.Flush());
+
+		SimulatedDatagram datagram;
+		while (simulator.Release(now, datagram))
+		{
+			const CapturedDatagram delivered{ 0, datagram.address, std::move(datagram.data) };
+			if (datagram.address.sin_port == addressB.sin_port)
+				submit(addressA, b.Receive(addressA, delivered));
+			else
+				submit(addressB, a.Receive(addressB, delivered));
+		}
+		now += step;
+	}
+}
+
+// Every reliable message arrives exactly once and in order, however many datagrams the network loses,
+// duplicates or reorders on the way, the handshake's included.
+TEST(ReliableDeliverySurvivesSimulatedLoss)
+{
+	auto now = 100.0;
+	EventHandler eventHandler;
+	TestSocketManager a{ eventHandler, now };
+	TestSocketManager b{ eventHandler, now };
+	a.SetHandshakeRequired(true);
+	b.SetHandshakeRequired(true);
+	const auto addressA = MakeAddress(1000);
+	const auto addressB = MakeAddress(2000);
+
+	NetworkSimulator simulator{ 41 };
+	NetworkConditions conditions;
+	conditions.latency = 0.04;
+	conditions.jitter = 0.02;
+	conditions.lossRate = 0.2;
+	conditions.duplicateRate = 0.05;
+	conditions.reorderRate = 0.1;
+	simulator.SetConditions(conditions);
+
+	std::vector<std::string> toB;
+	std::vector<std::string> toA;
+	for (auto i = 0; i < 300; i++)
+	{
+		toB.push_back(std::to_string(i));
+		a.SendReliable(addressB, toB.back());
+		if (i % 3 == 0)
+		{
+			toA.push_back(std::to_string(i));
+			b.SendReliable(addressA, toA.back());
+		}
+		ExchangeOverSimulator(a, addressA, b, addressB, simulator, now, 0.02, 0.01);
+	}
+	ExchangeOverSimulator(a, addressA, b, addressB, simulator, now, 20.0, 0.01);
+
+	CHECK(b.received == toB);
+	CHECK(a.received == toA);
+	CHECK(simulator.GetStats().datagramsLost > 0);
+	CHECK(simulator.GetStats().datagramsDuplicated > 0);
+	CHECK(simulator.GetStats().datagramsReordered > 0);
+}
@@ -0,0 +1,120 @@
+#include "stdafx.h"
+#include "Test.h"
+#include <Networking/SnapshotInterpolator.h>
+
+static const bool Near(const XMFLOAT3& l, const XMFLOAT3& r)
+{
+	return std::abs(l.x - r.x) < 0.0001f && std::abs(l.y - r.y) < 0.0001f && std::abs(l.z - r.z) < 0.0001f;
+}
+
+TEST(SnapshotBufferInterpolatesBetweenSurroundingSnapshots)
+{
+	SnapshotBuffer buffer;
+	buffer.Add(1.0, XMFLOAT3{ 0.0f, 0.0f, 0.0f }, VEC_EAST);
+	buffer.Add(2.0, XMFLOAT3{ 10.0f, 0.0f, 20.0f }, VEC_EAST);
+	buffer.Add(3.0, XMFLOAT3{ 10.0f, 0.0f, 40.0f }, VEC_EAST);
+
+	CHECK(Near(buffer.Sample(1.25, 5.0f, 0.25), XMFLOAT3{ 2.5f, 0.0f, 5.0f }));
+	CHECK(Near(buffer.Sample(2.0, 5.0f, 0.25), XMFLOAT3{ 10.0f, 0.0f, 20.0f }));
+	CHECK(Near(buffer.Sample(2.5, 5.0f, 0.25), XMFLOAT3{ 10.0f, 0.0f, 30.0f }));
+}
+
+TEST(SnapshotBufferClampsBeforeOldestSnapshot)
+{
+	SnapshotBuffer buffer;
+	CHECK(buffer.IsEmpty());
+	CHECK(Near(buffer.Sample(1.0, 5.0f, 0.25), VEC_ZERO));
+
+	buffer.Add(1.0, XMFLOAT3{ 4.0f, 0.0f, 4.0f }, VEC_EAST);
+	buffer.Add(2.0, XMFLOAT3{ 8.0f, 0.0f, 4.0f }, VEC_EAST);
+	CHECK(Near(buffer.Sample(0.0, 5.0f, 0.25), XMFLOAT3{ 4.0f, 0.0f, 4.0f }));
+	CHECK(Near(buffer.Sample(1.0, 5.0f, 0.25), XMFLOAT3{ 4.0f, 0.0f, 4.0f }));
+}
+
+// past the newest snapshot the entity keeps moving for maxExtrapolation seconds, then holds still
+TEST(SnapshotBufferCapsExtrapolation)
+{
+	SnapshotBuffer buffer;
+	buffer.Add(1.0, XMFLOAT3{ 0.0f, 0.0f, 0.0f }, VEC_EAST);
+	buffer.Add(2.0, XMFLOAT3{ 10.0f, 0.0f, 0.0f }, VEC_EAST);
+
+	CHECK(Near(buffer.Sample(2.1, 5.0f, 0.25), XMFLOAT3{ 10.5f, 0.0f, 0.0f }));
+	CHECK(Near(buffer.Sample(2.25, 5.0f, 0.25), XMFLOAT3{ 11.25f, 0.0f, 0.0f }));
+	CHECK(Near(buffer.Sample(2.5, 5.0f, 0.25), XMFLOAT3{ 11.25f, 0.0f, 0.0f }));
+	CHECK(Near(buffer.Sample(100.0, 5.0f, 0.25), XMFLOAT3{ 11.25f, 0.0f, 0.0f }));
+	CHECK(Near(buffer.Sample(100.0, 5.0f, 0.0), XMFLOAT3{ 10.0f, 0.0f, 0.0f }));
+}
+
+TEST(SnapshotBufferDropsOutOfOrderSnapshots)
+{
+	SnapshotBuffer buffer;
+	buffer.Add(2.0, XMFLOAT3{ 10.0f, 0.0f, 0.0f }, VEC_ZERO);
+	buffer.Add(1.0, XMFLOAT3{ 99.0f, 0.0f, 0.0f }, VEC_ZERO);
+	buffer.Add(2.0, XMFLOAT3{ 99.0f, 0.0f, 0.0f }, VEC_ZERO);
+	CHECK(buffer.GetNewestTime() == 2.0);
+	CHECK(Near(buffer.Sample(1.5, 5.0f, 0.25), XMFLOAT3{ 10.0f, 0.0f, 0.0f }));
+
+	buffer.Add(3.0, XMFLOAT3{ 20.0f, 0.0f, 0.0f }, VEC_ZERO);
+	CHECK(Near(buffer.Sample(2.5, 5.0f, 0.25), XMFLOAT3{ 15.0f, 0.0f, 0.0f }));
+}
+
+// once full, each new snapshot replaces the oldest, and the ring keeps sampling in time order across its end
+TEST(SnapshotBufferWrapsAroundAfterFillingUp)
+{
+	SnapshotBuffer buffer;
+	const auto added = SNAPSHOT_BUFFER_SIZE + 10;
+	for (auto i = 0; i < added; i++)
+		buffer.Add(static_cast<double>(i), XMFLOAT3{ static_cast<float>(i) * 2.0f, 0.0f, 0.0f }, VEC_ZERO);
+
+	const auto oldest = added - SNAPSHOT_BUFFER_SIZE;
+	CHECK(buffer.GetNewestTime() == static_cast<double>(added - 1));
+	CHECK(Near(buffer.Sample(0.0, 5.0f, 0.25), XMFLOAT3{ oldest * 2.0f, 0.0f, 0.0f }));
+	for (auto i = oldest; i < added - 1; i++)
+		CHECK(Near(buffer.Sample(i + 0.5, 5.0f, 0.25), XMFLOAT3{ i * 2.0f + 1.0f, 0.0f, 0.0f }));
+
+	buffer.Clear();
+	CHECK(buffer.IsEmpty());
+	buffer.Add(1.0, XMFLOAT3{ 3.0f, 0.0f, 0.0f }, VEC_ZERO);
+	CHECK(Near(buffer.Sample(5.0, 5.0f, 0.25), XMFLOAT3{ 3.0f, 0.0f, 0.0f }));
+}
+
+// positions are sampled interpolationDelay behind now
+TEST(SnapshotInterpolatorRendersInThePast)
+{
+	SnapshotInterpolator interpolator;
+	XMFLOAT3 position;
+	CHECK(!interpolator.TryGetPosition(1, 1.0, 5.0f, position));
+
+	interpolator.SetInterpolationDelay(0.5);
+	interpolator.AddSnapshot(1, 1.0, XMFLOAT3{ 0.0f, 0.0f, 0.0f }, VEC_EAST);
+	interpolator.AddSnapshot(1, 2.0, XMFLOAT3{ 10.0f, 0.0f, 0.0f }, VEC_EAST);
+	CHECK(interpolator.TryGetPosition(1, 2.0, 5.0f, position));
+	CHECK(Near(position, XMFLOAT3{ 5.0f, 0.0f, 0.0f }));
+	CHECK(!interpolator.TryGetPosition(2, 2.0, 5.0f, position));
+
+	interpolator.SetMaxExtrapolation(0.1);
+	CHECK(interpolator.TryGetPosition(1, 10.0, 5.0f, position));
+	CHECK(Near(position, XMFLOAT3{ 10.5f, 0.0f, 0.0f }));
+
+	interpolator.Remove(1);
+	CHECK(!interpolator.TryGetPosition(1, 2.0, 5.0f, position));
+}
+
+TEST(SnapshotInterpolatorRemovesExpiredEntities)
+{
+	SnapshotInterpolator interpolator;
+	interpolator.AddSnapshot(1, 1.0, VEC_EAST, VEC_ZERO);
+	interpolator.AddSnapshot(2, 1.0, VEC_EAST, VEC_ZERO);
+	interpolator.AddSnapshot(2, 5.0, VEC_EAST, VEC_ZERO);
+
+	XMFLOAT3 position;
+	interpolator.RemoveExpired(1.0 + SNAPSHOT_EXPIRY_TIME);
+	CHECK(interpolator.TryGetPosition(1, 2.0, 5.0f, position));
+
+	interpolator.RemoveExpired(1.0 + SNAPSHOT_EXPIRY_TIME + 0.5);
+	CHECK(!interpolator.TryGetPosition(1, 2.0, 5.0f, position));
+	CHECK(interpolator.TryGetPosition(2, 2.0, 5.0f, position));
+
+	interpolator.Clear();
+	CHECK(!interpolator.TryGetPosition(2, 2.0, 5.0f, position));
+}
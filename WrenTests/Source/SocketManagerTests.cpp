@@ -0,0 +1,121 @@
+#include "stdafx.h"
+#include "Test.h"
+#include "TestSocketManager.h"
+
+// Both ends of a Connection, with or without the handshake. Either end can be restarted, which gives it a
+// new salt and no Connections, like a new process on the same address.
+struct Peers
+{
+	double now{ 100.0 };
+	EventHandler eventHandler;
+	const bool handshakeRequired;
+	std::unique_ptr<TestSocketManager> a;
+	std::unique_ptr<TestSocketManager> b;
+	const sockaddr_in addressA{ MakeAddress(1000) };
+	const sockaddr_in addressB{ MakeAddress(2000) };
+
+	Peers(const bool handshakeRequired = false)
+		: handshakeRequired{ handshakeRequired }
+	{
+		Restart(a);
+		Restart(b);
+	}
+
+	void Restart(std::unique_ptr<TestSocketManager>& peer)
+	{
+		peer = std::make_unique<TestSocketManager>(eventHandler, now);
+		peer->SetHandshakeRequired(handshakeRequired);
+	}
+
+	void Exchange(const int rounds)
+	{
+		::Exchange(*a, addressA, *b, addressB, now, rounds, 0.1);
+	}
+};
+
+static const std::vector<std::string> Numbers(const int first, const int count)
+{
+	std::vector<std::string> numbers;
+	for (auto i = first; i < first + count; i++)
+		numbers.push_back(std::to_string(i));
+	return numbers;
+}
+
+// b buffers MAX_BUFFERED_RELIABLE_MESSAGES ahead of a gap and acks everything it buffers, so a must not send
+// further ahead than that or messages past the buffer are acked, dropped and never resent.
+TEST(ReliableWindowWaitsForLostMessage)
+{
+	Peers peers;
+	peers.a->SendReliable(peers.addressB, "0");
+	CHECK(peers.a->Flush().size() == 1); // lost
+
+	const auto count = MAX_BUFFERED_RELIABLE_MESSAGES + 44;
+	for (const auto& number : Numbers(1, count))
+		peers.a->SendReliable(peers.addressB, number);
+	peers.Exchange(50);
+
+	CHECK(peers.b->received == Numbers(0, count + 1));
+}
+
+// e.g. a late datagram from the peer's previous run, or one spoofed from its address
+TEST(DatagramWithOtherSaltIsChallengedNotAccepted)
+{
+	Peers peers{ true };
+	peers.a->SendReliable(peers.addressB, "0");
+	peers.Exchange(5);
+	CHECK(peers.b->received == Numbers(0, 1));
+
+	peers.a->SendReliable(peers.addressB, "1");
+	const auto datagrams = peers.a->Flush();
+	CHECK(datagrams.size() == 1);
+
+	auto spoofed = datagrams[0];
+	unsigned short salt{ 0 };
+	memcpy(&salt, spoofed.data.data() + sizeof(OpCode), sizeof(unsigned short));
+	salt++;
+	memcpy(spoofed.data.data() + sizeof(OpCode), &salt, sizeof(unsigned short));
+
+	const auto challenge = peers.b->Receive(peers.addressA, spoofed);
+	CHECK(challenge.size() == 1);
+	CHECK(challenge[0].data.size() == HANDSHAKE_DATAGRAM_SIZE);
+	CHECK(peers.b->received == Numbers(0, 1));
+
+	// the real peer answers with the salt it already had, which changes nothing
+	const auto response = peers.a->Receive(peers.addressB, challenge);
+	CHECK(peers.b->Receive(peers.addressA, response).empty());
+
+	peers.b->Receive(peers.addressA, datagrams);
+	peers.a->SendReliable(peers.addressB, "2");
+	peers.Exchange(5);
+	CHECK(peers.b->received == Numbers(0, 3));
+	CHECK(peers.a->GetConnectionCount() == 1);
+}
+
+static void CheckRestartResynchronizes(const bool restartA)
+{
+	Peers peers{ true };
+	peers.a->SendReliable(peers.addressB, "0");
+	peers.b->SendReliable(peers.addressA, "0");
+	peers.Exchange(5);
+	CHECK(peers.a->received == Numbers(0, 1));
+	CHECK(peers.b->received == Numbers(0, 1));
+
+	peers.Restart(restartA ? peers.a : peers.b);
+	peers.a->SendReliable(peers.addressB, "1");
+	peers.b->SendReliable(peers.addressA, "1");
+	peers.Exchange(10);
+
+	// the end that restarted only gets the new message; the other end starts its stream over for it
+	CHECK(peers.a->received == (restartA ? Numbers(1, 1) : Numbers(0, 2)));
+	CHECK(peers.b->received == (restartA ? Numbers(0, 2) : Numbers(1, 1)));
+}
+
+TEST(RestartedRequesterResynchronizesThroughHandshake)
+{
+	CheckRestartResynchronizes(true);
+}
+
+TEST(RestartedChallengerResynchronizesThroughHandshake)
+{
+	CheckRestartResynchronizes(false);
+}
@@ -0,0 +1,39 @@
+#pragma once
+
+struct TestCase
+{
+	const char* name;
+	std::function<void()> run;
+};
+
+std::vector<TestCase>& GetTestCases();
+std::vector<TestCase>& GetBenchmarks();
+
+struct TestRegistration
+{
+	TestRegistration(std::vector<TestCase>& testCases, const char* name, std::function<void()> run) { testCases.push_back(TestCase{ name, run }); }
+};
+
+// TEST(Name) { ... } registers a test that WrenTests.exe runs; CHECK throws out of it on the first failure.
+#define TEST(name) \
+	static void name(); \
+	static TestRegistration name##Registration{ GetTestCases(), #name, name }; \
+	static void name()
+
+// BENCHMARK(Name) { ... } only runs with WrenTests.exe --benchmarks and prints its own results. Its inputs are
+// fixed, so anything but the timings comes out the same on every run.
+#define BENCHMARK(name) \
+	static void name(); \
+	static TestRegistration name##Registration{ GetBenchmarks(), #name, name }; \
+	static void name()
+
+// wrapped in do/while so it's a single statement, e.g. inside an if without braces
+#define CHECK(expression) \
+	do \
+	{ \
+		if (!(expression)) \
+			throw std::exception(__FILE__ "(" TEST_STRINGIFY(__LINE__) "): CHECK(" #expression ") failed."); \
+	} while (0)
+
+#define TEST_STRINGIFY(x) TEST_STRINGIFY_(x)
+#define TEST_STRINGIFY_(x) #x
\ No newline at end of file
@@ -0,0 +1,97 @@
+#include "stdafx.h"
+#include "TestSocketManager.h"
+
+TestSocketManager::TestSocketManager(EventHandler& eventHandler, const double& now)
+	: SocketManager{ eventHandler }
+{
+	static auto instanceCount{ 0 };
+	capturePath = (std::filesystem::temp_directory_path() / ("WrenTests" + std::to_string(instanceCount++) + ".wcap")).string();
+	SetClock([&now]() { return now; });
+	InitializeMessageHandlers();
+}
+
+TestSocketManager::~TestSocketManager()
+{
+	std::remove(capturePath.c_str());
+}
+
+void TestSocketManager::InitializeMessageHandlers()
+{
+	messageHandlers[OpCode::SendChatMessage] = [this](const std::vector<std::string>& args)
+	{
+		received.push_back(args.size() > 0 ? args[0] : "");
+	};
+}
+
+// Whatever send puts on the wire, in the order it was sent.
+const std::vector<CapturedDatagram> TestSocketManager::Capture(const std::function<void()>& send)
+{
+	{
+		PacketCaptureWriter writer{ capturePath, 0 };
+		SetOutboundCapture(&writer);
+		send();
+		SetOutboundCapture(nullptr);
+	}
+
+	PacketCaptureReader reader{ capturePath };
+	std::vector<CapturedDatagram> datagrams;
+	CapturedDatagram datagram;
+	while (reader.Read(datagram))
+		datagrams.push_back(datagram);
+	return datagrams;
+}
+
+void TestSocketManager::SendReliable(const sockaddr_in& to, const std::string& text)
+{
+	SendPacket(to, OpCode::SendChatMessage, { text });
+}
+
+const std::vector<CapturedDatagram> TestSocketManager::Flush()
+{
+	return Capture([this]() { FlushPackets(); });
+}
+
+// Returns anything sent straight back, i.e. handshake replies.
+const std::vector<CapturedDatagram> TestSocketManager::Receive(const sockaddr_in& from, const std::vector<CapturedDatagram>& datagrams)
+{
+	return Capture([&]()
+	{
+		for (const auto& datagram : datagrams)
+			InjectDatagram(from, datagram.data.data(), static_cast<int>(datagram.data.size()));
+	});
+}
+
+const std::vector<CapturedDatagram> TestSocketManager::Receive(const sockaddr_in& from, const CapturedDatagram& datagram)
+{
+	return Receive(from, std::vector<CapturedDatagram>{ datagram });
+}
+
+const sockaddr_in MakeAddress(const u_short port)
+{
+	sockaddr_in address;
+	ZeroMemory(&address, sizeof(address));
+	address.sin_family = AF_INET;
+	address.sin_port = htons(port);
+	inet_pton(AF_INET, "127.0.0.1", &address.sin_addr);
+	return address;
+}
+
+void Exchange(TestSocketManager& a, const sockaddr_in& addressA, TestSocketManager& b, const sockaddr_in& addressB, double& now,
+	const int rounds, const double step, const std::function<const std::vector<CapturedDatagram>(const std::vector<CapturedDatagram>&)>& link)
+{
+	const auto send = [&link](const std::vector<CapturedDatagram>& datagrams) { return link ? link(datagrams) : datagrams; };
+
+	for (auto i = 0; i < rounds; i++)
+	{
+		auto toB = send(a.Flush());
+		auto toA = send(b.Flush());
+		while (!toB.empty() || !toA.empty())
+		{
+			const auto repliesFromB = send(b.Receive(addressA, toB));
+			const auto repliesFromA = send(a.Receive(addressB, toA));
+			toB = repliesFromA;
+			toA = repliesFromB;
+		}
+		now += step;
+	}
+}
@@ -0,0 +1,31 @@
+#pragma once
+
+#include <SocketManager.h>
+
+// A SocketManager whose datagrams come back to the test instead of going out on its socket, on a
+// clock the test moves, so both ends of a Connection can run in one process and any datagram can
+// be dropped, delayed or replayed.
+class TestSocketManager : public SocketManager
+{
+	std::string capturePath;
+
+	void InitializeMessageHandlers() override;
+	const std::vector<CapturedDatagram> Capture(const std::function<void()>& send);
+public:
+	std::vector<std::string> received; // chat messages, in the order they were handled
+
+	TestSocketManager(EventHandler& eventHandler, const double& now);
+	~TestSocketManager();
+	void SendReliable(const sockaddr_in& to, const std::string& text);
+	const std::vector<CapturedDatagram> Flush();
+	const std::vector<CapturedDatagram> Receive(const sockaddr_in& from, const std::vector<CapturedDatagram>& datagrams);
+	const std::vector<CapturedDatagram> Receive(const sockaddr_in& from, const CapturedDatagram& datagram);
+	using SocketManager::SetCompressionEnabled;
+};
+
+const sockaddr_in MakeAddress(const u_short port);
+
+// Flushes both ends and hands each the other's datagrams, handshake replies included, every step seconds
+// for the given number of rounds. link decides what the other end gets, e.g. nothing for a lost datagram.
+void Exchange(TestSocketManager& a, const sockaddr_in& addressA, TestSocketManager& b, const sockaddr_in& addressB, double& now,
+	const int rounds, const double step, const std::function<const std::vector<CapturedDatagram>(const std::vector<CapturedDatagram>&)>& link = nullptr);
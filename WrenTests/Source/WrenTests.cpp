@@ -0,0 +1,39 @@
+#include "stdafx.h"
+#include "Test.h"
+
+std::vector<TestCase>& GetTestCases()
+{
+	static std::vector<TestCase> testCases;
+	return testCases;
+}
+
+std::vector<TestCase>& GetBenchmarks()
+{
+	static std::vector<TestCase> benchmarks;
+	return benchmarks;
+}
+
+// Runs every registered test and exits non-zero if any failed, e.g. WrenTests.exe, or every benchmark
+// instead with WrenTests.exe --benchmarks
+int main(int argc, char* argv[])
+{
+	const auto& testCases = argc > 1 && std::string{ argv[1] } == "--benchmarks" ? GetBenchmarks() : GetTestCases();
+
+	auto failures = 0;
+	for (const auto& testCase : testCases)
+	{
+		try
+		{
+			testCase.run();
+			std::cout << "PASS " << testCase.name << "\n";
+		}
+		catch (const std::exception& e)
+		{
+			std::cout << "FAIL " << testCase.name << ": " << e.what() << "\n";
+			failures++;
+		}
+	}
+
+	std::cout << "\n" << testCases.size() - failures << "/" << testCases.size() << " tests passed.\n";
+	return failures > 0 ? 1 : 0;
+}
\ No newline at end of file